@@ -34,13 +34,32 @@ extern "C"
 
 #include "generic.h"
 #include "videoFunctions.h"
+#include "framePipeline.h"
+#include "vramPlanner.h"
 #include "textFunctions.h"
+#include "textWidgets.h"
+#include "variableFont.h"
 #include "backgrounds.h"
+#include "scanlineEffects.h"
+#include "camera.h"
 #include "sprites.h"
 #include "multitasking.h"
 #include "timeFunctions.h"
+#include "inputFunctions.h"
+#include "inputReplay.h"
+#include "frameTimer.h"
+#include "eventScheduler.h"
+#include "taskScheduler.h"
+#include "profiler.h"
 #include "achievements.h"
+#include "matchStats.h"
+#include "leaderboard.h"
 #include "fileIO.h"
+#include "savePath.h"
+#include "saveQueue.h"
+#include "saveFormat.h"
+#include "assets.h"
+#include "assetCache.h"
 #include "userDataFunctions.h"
 
 #ifdef __cplusplus
@@ -32,9 +32,15 @@ extern "C"
  */
 #define MAX_ACHIEVEMENT_TITLE_LENGTH 64
 
+/*
+ * The max amount of achievements (and the range of their IDs).
+ */
+#define MAX_ACHIEVEMENTS 64
+
 /*
  * The structure for each achievement.
  * Contains:
+ * id - The game's ID for the achievement.
  * pointValue - The value of the achievement
  * in points.
  * title - The title of the game.
@@ -45,6 +51,7 @@ extern "C"
  */
 typedef struct achievement_t
 {
+	int id;
 	int pointValue;
 	char gameID[8];
 	char achievementTitle[MAX_ACHIEVEMENT_TITLE_LENGTH];
@@ -52,26 +59,67 @@ typedef struct achievement_t
 } achievement_t;
 
 /*
- * Adds an achievement to the user's save profile.
+ * Loads the current user's achievements into memory.  Only the first call
+ * (or the first after the user changes) reads the save file.  It is called
+ * at startup, so that the other achievement functions only use memory.
+ * @return Returns true if the achievements are loaded.
+ */
+extern bool loadAchievements();
+
+/*
+ * Unlocks an achievement for the current user.  The achievement is only
+ * kept in memory until flushAchievements is called, so this never touches
+ * the SD card.  loadAchievements must have been called first, or the
+ * achievement is only kept until the game is turned off.
+ * @param id The game's ID for the achievement (0 to MAX_ACHIEVEMENTS - 1).
  * @param pointValue The point value of how many points
  * the achievement is worth.
  * @param gameID The identification for the game.  Should be
  * 8 characters long.
  * @param achievementTitle The title of the achievement.
+ * @return Returns true if the achievement was just unlocked, false if it
+ * already was (or the ID is not valid).
  */
-extern void addAchievement(int pointValue, const char* gameID,
+extern bool unlockAchievement(int id, int pointValue, const char* gameID,
 		const char* achievementTitle);
 
+/*
+ * Checks if an achievement is unlocked.
+ * @param id The game's ID for the achievement.
+ * @return Returns true if it is unlocked, false otherwise.
+ */
+extern bool isAchievementUnlocked(int id);
+
+/*
+ * Gets the amount of unlocked achievements.
+ * @return Returns the amount of achievements.
+ */
+extern int getAchievementCount();
+
 /*
  * Gets an achievement based on it's index (they are sorted by date.
  * @param index The index of the achievement.
- * @return The achievement as a structure.
+ * @return The achievement as a structure, or an empty achievement with an
+ * ID of -1 if the index is not valid.
  */
 extern achievement_t getAchievementFromIndex(int index);
 
+/*
+ * Checks if there are unlocked achievements that haven't been saved yet.
+ * @return Returns true if there are, false otherwise.
+ */
+extern bool hasUnsavedAchievements();
+
+/*
+ * Queues the achievements unlocked since the last flush to be added to the
+ * save file, all as one save.  The save queue then writes them over the
+ * next few frames.
+ * @return Returns true if there was anything to save.
+ */
+extern bool flushAchievements();
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif
-
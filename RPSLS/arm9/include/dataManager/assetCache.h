@@ -0,0 +1,87 @@
+/*
+ * A cache that keeps loaded assets in memory, so that assets which are used
+ * over and over (IE: the sprites made for each match) are only loaded once.
+ * Assets that are in use are reference counted, and the least recently used
+ * assets that aren't are freed when the cache goes over its memory budget.
+ */
+
+#ifndef _ASSET_CACHE_H_
+#define _ASSET_CACHE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "assets.h"
+
+/*
+ * The max amount of assets in the cache.
+ */
+#define MAX_CACHED_ASSETS 48
+
+/*
+ * The max length of a cached asset's name.
+ */
+#define MAX_CACHED_ASSET_NAME 32
+
+/*
+ * The default amount of memory the cache can use, in bytes.
+ */
+#define DEFAULT_ASSET_CACHE_BUDGET (256 * 1024)
+
+/*
+ * Gets part of an asset from the cache, loading it if it isn't there.
+ * Each call must be matched by a call to releaseCachedAsset.  Palettes
+ * are always given as a full 256 colors.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to get.
+ * @param size Set to the size of the asset's data.
+ * @return Returns the asset's data, or NULL if it couldn't be loaded or
+ * the cache is full of assets in use.
+ */
+extern const void* acquireCachedAsset(const char* name, assetPart_t part, u32* size);
+
+/*
+ * Tells the cache that an asset from acquireCachedAsset is no longer used.
+ * It stays in the cache until it is pushed out by other assets.
+ * @param data The asset's data.
+ */
+extern void releaseCachedAsset(const void* data);
+
+/*
+ * Sets how much memory the cache can use.  Assets that aren't in use are
+ * freed straight away if the cache is over the new budget.
+ * @param bytes The budget in bytes.
+ */
+extern void setAssetCacheBudget(u32 bytes);
+
+/*
+ * Frees every asset in the cache that isn't in use.
+ */
+extern void clearAssetCache();
+
+/*
+ * Gets the amount of memory the cache is using.
+ * @return Returns the amount in bytes.
+ */
+extern u32 getAssetCacheUsage();
+
+/*
+ * Gets the amount of times an asset was found in the cache.
+ * @return Returns the amount of hits.
+ */
+extern u32 getAssetCacheHits();
+
+/*
+ * Gets the amount of times an asset had to be loaded.
+ * @return Returns the amount of misses.
+ */
+extern u32 getAssetCacheMisses();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * A system for loading graphics from NitroFS instead of compiling them into
+ * the game.  Assets are read in fixed size chunks through a small reusable
+ * buffer, and are streamed straight into VRAM where possible, so they only
+ * take up main memory while they are in use.  The graphics are packed into
+ * one asset pack (made by tools/packAssets.c) with a hashed table of
+ * contents, so finding an asset is a single lookup rather than a NitroFS
+ * directory search.
+ */
+
+#ifndef _ASSETS_H_
+#define _ASSETS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The size of the chunks that assets are read in.
+ */
+#define ASSET_CHUNK_SIZE 4096
+
+/*
+ * The asset pack in NitroFS that holds the graphics.
+ */
+#define ASSET_PACK "nitro:/assets.pak"
+
+/*
+ * The magic number at the start of the asset pack ("GPAK") and its version.
+ */
+#define ASSET_PACK_MAGIC 0x4B415047
+#define ASSET_PACK_VERSION 1
+
+/*
+ * The directory in NitroFS that assets are loaded from if there is
+ * no asset pack.
+ */
+#define ASSET_DIRECTORY "nitro:/gfx/"
+
+/*
+ * The parts that make up a graphical asset.  Each part
+ * is stored as a separate file by grit.
+ */
+typedef enum
+{
+	ASSET_TILES = 0,
+	ASSET_MAP = 1,
+	ASSET_PALETTE = 2
+} assetPart_t;
+
+/*
+ * An entry in the asset pack's table of contents.
+ * hash - The hash of the asset's file name, or 0 if the entry is empty.
+ * offset - Where the asset's data starts in the pack.
+ * size - The size of the asset's data.
+ */
+typedef struct assetPackEntry_t
+{
+	u32 hash;
+	u32 offset;
+	u32 size;
+} assetPackEntry_t;
+
+/*
+ * Initializes the asset system (and NitroFS), and opens the asset pack.
+ * @return Returns true if NitroFS could be opened, false otherwise.
+ */
+extern bool initAssets();
+
+/*
+ * Finds part of an asset in the asset pack.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to find.
+ * @return Returns the asset's ID, or -1 if it isn't in the pack.
+ */
+extern int findAsset(const char* name, assetPart_t part);
+
+/*
+ * Gets the size of an asset in the asset pack.
+ * @param id The asset's ID, from findAsset.
+ * @return Returns the size in bytes, or 0 if the ID is not valid.
+ */
+extern u32 getAssetSizeById(int id);
+
+/*
+ * Streams an asset from the asset pack to the desired destination in chunks.
+ * @param id The asset's ID, from findAsset.
+ * @param dest Where to copy the data to.
+ * @param maxSize The max amount of bytes to copy.
+ * @param vram Whether the destination is in VRAM.
+ * @return Returns the amount of bytes that were copied.
+ */
+extern u32 streamAssetById(int id, void* dest, u32 maxSize, bool vram);
+
+/*
+ * Gets the size of part of an asset.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to get the size of.
+ * @return Returns the size in bytes, or 0 if it doesn't exist.
+ */
+extern u32 getAssetSize(const char* name, assetPart_t part);
+
+/*
+ * Streams part of an asset to the desired destination in chunks.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to stream.
+ * @param dest Where to copy the data to.
+ * @param maxSize The max amount of bytes to copy.
+ * @param vram Whether the destination is in VRAM.  VRAM is written with
+ * DMA from the asset buffer, main memory is read into directly.
+ * @return Returns the amount of bytes that were copied.
+ */
+extern u32 streamAsset(const char* name, assetPart_t part, void* dest, u32 maxSize, bool vram);
+
+/*
+ * Loads part of an asset into newly allocated memory.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to load.
+ * @param size Set to the size of the loaded data.
+ * @return Returns the data (free it when done), or NULL if it couldn't be loaded.
+ */
+extern void* loadAsset(const char* name, assetPart_t part, u32* size);
+
+/*
+ * Loads a background asset onto a background created with createBg.
+ * The tiles are streamed straight into VRAM, and the loaded map is
+ * handed over to the background rather than copied.
+ * @param screen The screen the background is on.
+ * @param layer The layer of the background.
+ * @param name The name of the asset (IE: "top_main").
+ */
+extern void loadBgAsset(int screen, int layer, const char* name);
+
+/*
+ * Creates a sprite from a sprite asset.  The tiles and palette come from
+ * the asset cache, so creating the same sprite again doesn't load or copy
+ * them.
+ * @param screen The screen to create the sprite on.
+ * @param index The index of the sprite.
+ * @param palSlot The slot for the palette data.
+ * @param name The name of the asset (IE: "rock").
+ * @param width The width of the sprite.
+ * @param height The height of the sprite.
+ */
+extern void createSpriteAsset(int screen, int index, int palSlot, const char* name,
+		int width, int height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
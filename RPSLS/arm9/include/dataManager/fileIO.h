@@ -1,5 +1,8 @@
 /*
- * A system for opening and closing file buffers.
+ * A system for opening and closing file buffers.  A file buffer reads a
+ * file through a small cache of fixed-size pages, so any part of a file can
+ * be read without loading the whole file into memory.  Reading straight
+ * through a file reads ahead a page at a time.
  * Created by: Gerald McAlister
  */
 
@@ -12,30 +15,93 @@ extern "C"
 #endif
 
 #include <nds.h>
+#include <stdio.h>
+
+// The size of each page of a file buffer.
+#define FILE_BUFFER_PAGE_SIZE 4096
+
+// The amount of pages each file buffer keeps.
+#define FILE_BUFFER_PAGES 4
+
+// A page of a file buffer.
+typedef struct
+{
+	// The data of the page.
+	u8* data;
+	// The index of the page in the file, or -1 if the page is empty.
+	s32 index;
+	// The amount of bytes in the page (less than a full page at the end of the file).
+	u32 length;
+	// When the page was last used, for choosing which page to replace.
+	u32 lastUse;
+}fileBufferPage_t;
 
 // A file buffer type for reading files.
 typedef struct
 {
+	// The name of the file.
 	char* name;
-	char* buffer;
+	// The open file.
+	FILE* file;
+	// The size of the file, from the offset on.
 	unsigned int size;
+	// Where in the file the buffer starts.
 	unsigned int offset;
+	// The position that readFileBufferNext reads from.
+	unsigned int position;
+	// The pages of the file.
+	fileBufferPage_t pages[FILE_BUFFER_PAGES];
+	// The last page that was read in from the file.
+	s32 lastPageRead;
+	// Counts up each time a page is used.
+	u32 useCount;
 }fileBuffer_t;
 
 /*
- * Loads a file into the desired buffer and returns the size of it.
- * @param fileName The name of the file to load.
- * @param fileBuffer The buffer to store the file in.
- * @param offset The offset to start reading the file at.
- * @return Returns the size of the file.
+ * Opens a file buffer and returns the size of the file.
+ * @param fileName The name of the file to open.
+ * @param fileBuffer The buffer to open the file in.
+ * @param offset The offset to start the buffer at.  Positions given to
+ * the buffer are from this offset.
+ * @return Returns the size of the file from the offset, or 0 if it could
+ * not be opened.
+ */
+extern u32 openFileBuffer(const char* fileName, fileBuffer_t* fileBuffer, int offset);
+
+/*
+ * Reads part of a file buffer.
+ * @param fileBuffer The buffer to read from.
+ * @param position Where to read from.
+ * @param dest Where to copy the data to.
+ * @param length The amount of bytes to read.
+ * @return Returns the amount of bytes read, which is less than the length
+ * at the end of the file.
+ */
+extern u32 readFileBuffer(fileBuffer_t* fileBuffer, u32 position, void* dest, u32 length);
+
+/*
+ * Reads the next part of a file buffer, starting where the last call
+ * ended.
+ * @param fileBuffer The buffer to read from.
+ * @param dest Where to copy the data to.
+ * @param length The amount of bytes to read.
+ * @return Returns the amount of bytes read.
+ */
+extern u32 readFileBufferNext(fileBuffer_t* fileBuffer, void* dest, u32 length);
+
+/*
+ * Sets where readFileBufferNext reads from.
+ * @param fileBuffer The buffer.
+ * @param position The position to read from next.
  */
-extern u32 openFileBuffer(char* fileName, fileBuffer_t* fileBuffer, int offset);
+extern void seekFileBuffer(fileBuffer_t* fileBuffer, u32 position);
 
 /*
- * Unloads a buffer from memory.
+ * Closes a buffer's file and frees its pages.  The buffer can be opened
+ * again afterwards.
  * @param fileBuffer The buffer to close.
  */
-void closeBuffer(fileBuffer_t* fileBuffer);
+extern void closeBuffer(fileBuffer_t* fileBuffer);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,103 @@
+/*
+ * Local leaderboards for the game's high scores.  Each leaderboard is a
+ * fixed size array kept sorted from the best score down, held in memory
+ * and saved as a single small block whenever it changes.
+ */
+
+#ifndef _LEADERBOARD_H_
+#define _LEADERBOARD_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "timeFunctions.h"
+
+/*
+ * The amount of entries kept on each leaderboard.
+ */
+#define MAX_LEADERBOARD_ENTRIES 10
+
+/*
+ * The file the leaderboards are saved to, inside the save folder.
+ */
+#define LEADERBOARD_FILE "leaders.lbd"
+
+/*
+ * The magic number at the start of the leaderboard save ("GLDB").
+ */
+#define LEADERBOARD_MAGIC 0x42444C47
+
+/*
+ * The version of the leaderboard save's layout.
+ */
+#define LEADERBOARD_VERSION 1
+
+/*
+ * The game's leaderboards.
+ * LEADERBOARD_WINS - The most wins in a single player game.
+ * LEADERBOARD_STREAK - The most wins in a row in a single player game.
+ */
+typedef enum
+{
+	LEADERBOARD_WINS = 0,
+	LEADERBOARD_STREAK = 1,
+	LEADERBOARDS = 2
+} leaderboard_t;
+
+/*
+ * An entry on a leaderboard.
+ * name - The name of the player.
+ * score - The player's score.
+ * date - The date the score was set.
+ */
+typedef struct leaderboardEntry_t
+{
+	char name[11];
+	u32 score;
+	specificDate_t date;
+} leaderboardEntry_t;
+
+/*
+ * Loads the leaderboards into memory.  Only the first call reads the save
+ * file; the other leaderboard functions call this themselves, but it is
+ * also called at startup so that submitting a score only writes.
+ */
+extern void loadLeaderboards();
+
+/*
+ * Submits a score to a leaderboard.  Each player has at most one entry on
+ * a leaderboard.  If the player is already on it, their entry is only
+ * changed when the new score beats it; otherwise the score is added if it
+ * makes the leaderboard.  Either way, the entry is moved to its place and
+ * the leaderboards are queued to be saved.
+ * @param board The leaderboard.
+ * @param name The name of the player.
+ * @param score The player's score.
+ * @return Returns the score's place on the leaderboard (0 is first), or -1
+ * if it didn't make it or didn't beat the player's entry.
+ */
+extern int submitScore(leaderboard_t board, const char* name, u32 score);
+
+/*
+ * Gets the amount of entries on a leaderboard.
+ * @param board The leaderboard.
+ * @return Returns the amount of entries.
+ */
+extern int getLeaderboardCount(leaderboard_t board);
+
+/*
+ * Gets an entry on a leaderboard.
+ * @param board The leaderboard.
+ * @param place The entry's place (0 is first).
+ * @return Returns the entry, or NULL if there is no entry in that place.
+ */
+extern const leaderboardEntry_t* getLeaderboardEntry(leaderboard_t board, int place);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
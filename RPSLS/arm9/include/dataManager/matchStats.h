@@ -0,0 +1,113 @@
+/*
+ * Keeps statistics of the current user's matches: how often each choice is
+ * picked, how each match ends, and what each choice was played against.
+ * The statistics are kept in memory, so recording a match and reading the
+ * history never touch the SD card, and are saved all at once when a
+ * session ends.
+ */
+
+#ifndef _MATCH_STATS_H_
+#define _MATCH_STATS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The amount of choices in a match.
+ */
+#define STATS_CHOICES 5
+
+/*
+ * The magic number at the start of a statistics save ("GSTA").
+ */
+#define MATCH_STATS_MAGIC 0x41545347
+
+/*
+ * The version of the statistics save's layout.
+ */
+#define MATCH_STATS_VERSION 1
+
+/*
+ * The game modes that statistics are kept for.
+ */
+typedef enum
+{
+	STATS_SINGLE = 0,
+	STATS_MULTI = 1,
+	STATS_MODES = 2
+} statsMode_t;
+
+/*
+ * The ways a match can end, for the player the statistics are for.
+ */
+typedef enum
+{
+	STATS_LOSS = 0,
+	STATS_TIE = 1,
+	STATS_WIN = 2,
+	STATS_OUTCOMES = 3
+} statsOutcome_t;
+
+/*
+ * The statistics for one game mode.  The counters stop at their max value
+ * instead of wrapping around.
+ * matches - The amount of matches played.
+ * choices - The amount of times each choice was picked.
+ * outcomes - The amount of matches with each outcome.
+ * versus - The amount of times each choice was played against each of the
+ * opponent's choices.
+ * lastChoice - The last choice picked, or -1 if none has been.
+ * streak - The amount of wins in a row.
+ * bestStreak - The most wins in a row.
+ */
+typedef struct matchStats_t
+{
+	u32 matches;
+	u16 choices[STATS_CHOICES];
+	u16 outcomes[STATS_OUTCOMES];
+	u16 versus[STATS_CHOICES][STATS_CHOICES];
+	s16 lastChoice;
+	u16 streak;
+	u16 bestStreak;
+} matchStats_t;
+
+/*
+ * Loads the current user's statistics into memory.  Only the first call
+ * (or the first after the user changes) reads the save file; the other
+ * statistics functions call this themselves, but it is also called at
+ * startup so that recording the first match doesn't read the SD card.
+ */
+extern void loadMatchStats();
+
+/*
+ * Records a match.
+ * @param mode The game mode the match was played in.
+ * @param choice The player's choice.
+ * @param opponentChoice The opponent's choice.
+ * @param result The result of the match for the player (-1 is a loss,
+ * 0 is a tie and 1 is a win).
+ */
+extern void recordMatch(statsMode_t mode, int choice, int opponentChoice, int result);
+
+/*
+ * Gets the current user's statistics for a game mode.
+ * @param mode The game mode.
+ * @return Returns the statistics.
+ */
+extern const matchStats_t* getMatchStats(statsMode_t mode);
+
+/*
+ * Queues the statistics to be saved, if any matches were recorded since
+ * they were last saved.  Should be called at the end of a session.
+ */
+extern void saveMatchStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * A container for save files.  Each save starts with a header holding a
+ * magic number, a version, the length of the data and a CRC32 of it, so
+ * a save can be checked before it is used and older versions can be
+ * moved forward.  The data is packed one field at a time in little endian
+ * order, so it doesn't depend on how the compiler lays out structures.
+ */
+
+#ifndef _SAVE_FORMAT_H_
+#define _SAVE_FORMAT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The size of the save header in bytes.
+ */
+#define SAVE_HEADER_SIZE 16
+
+/*
+ * Saves are padded to a multiple of this size, so each one fills whole
+ * sectors and is written as a single block.
+ */
+#define SAVE_BLOCK_SIZE 512
+
+/*
+ * Packs data into a save.
+ * data - The buffer the data is packed into.
+ * size - The amount of data that has been packed.
+ * capacity - The size of the buffer.
+ * overflowed - Set if there was more data than would fit.
+ */
+typedef struct saveWriter_t
+{
+	u8* data;
+	int size;
+	int capacity;
+	bool overflowed;
+} saveWriter_t;
+
+/*
+ * Unpacks data from a save.  Reading past the end gives zeros, so fields
+ * added in later versions read as zero from older saves.
+ * data - The save's data.
+ * size - The size of the data.
+ * position - The position of the next field.
+ */
+typedef struct saveReader_t
+{
+	const u8* data;
+	int size;
+	int position;
+} saveReader_t;
+
+/*
+ * Works out the CRC32 of some data.
+ * @param crc The CRC of the data before this (0 to start).
+ * @param data The data.
+ * @param length The length of the data.
+ * @return Returns the CRC of all of the data.
+ */
+extern u32 calculateCrc32(u32 crc, const void* data, int length);
+
+/*
+ * Sets up a save writer.
+ * @param writer The writer to set up.
+ * @param buffer The buffer to pack the data into.
+ * @param capacity The size of the buffer.
+ */
+extern void initSaveWriter(saveWriter_t* writer, void* buffer, int capacity);
+
+/*
+ * Packs bytes into a save.
+ * @param writer The save writer.
+ * @param data The data to pack.
+ * @param length The amount of bytes to pack.
+ */
+extern void writeSaveBytes(saveWriter_t* writer, const void* data, int length);
+
+/*
+ * Packs an 8 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+extern void writeSaveU8(saveWriter_t* writer, u8 value);
+
+/*
+ * Packs a 16 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+extern void writeSaveU16(saveWriter_t* writer, u16 value);
+
+/*
+ * Packs a 32 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+extern void writeSaveU32(saveWriter_t* writer, u32 value);
+
+/*
+ * Unpacks bytes from a save.  Anything past the end of the save is
+ * unpacked as zeros.
+ * @param reader The save reader.
+ * @param data Set to the unpacked bytes.
+ * @param length The amount of bytes to unpack.
+ */
+extern void readSaveBytes(saveReader_t* reader, void* data, int length);
+
+/*
+ * Unpacks an 8 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+extern u8 readSaveU8(saveReader_t* reader);
+
+/*
+ * Unpacks a 16 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+extern u16 readSaveU16(saveReader_t* reader);
+
+/*
+ * Unpacks a 32 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+extern u32 readSaveU32(saveReader_t* reader);
+
+/*
+ * Queues a save to be written.  The header is added, the save is padded
+ * to whole blocks, and it is written to a temporary file which then
+ * replaces the old save.
+ * @param fileName The name of the save file.
+ * @param magic The magic number for the type of save.
+ * @param version The version of the save's layout.
+ * @param writer The writer holding the save's data.
+ * @return Returns true if the save was queued, false if it couldn't be.
+ */
+extern bool writeSaveFile(const char* fileName, u32 magic, u16 version, const saveWriter_t* writer);
+
+/*
+ * Loads a save and checks it.  If the save is missing or broken, but a
+ * temporary file was left by a save that didn't finish, that is used.
+ * @param fileName The name of the save file.
+ * @param magic The magic number for the type of save.
+ * @param newestVersion The newest version of the save's layout that this
+ * build can read.  Saves from newer builds are not loaded.
+ * @param version Set to the version of the save's layout.
+ * @param buffer The buffer to load the save's data into.
+ * @param capacity The size of the buffer.
+ * @param reader Set up to read the save's data.
+ * @return Returns true if a valid save was loaded, false otherwise.
+ */
+extern bool readSaveFile(const char* fileName, u32 magic, u16 newestVersion, u16* version, void* buffer, int capacity, saveReader_t* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
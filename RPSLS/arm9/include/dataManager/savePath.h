@@ -0,0 +1,57 @@
+/*
+ * Finds the game's save folder (data/GAME_TITLE on the SD card) once at
+ * startup, creating it if needed, and builds the paths of save files from
+ * it.  The working directory is never changed.
+ */
+
+#ifndef _SAVE_PATH_H_
+#define _SAVE_PATH_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max length of a save file's path.
+ */
+#define MAX_SAVE_PATH_LENGTH 96
+
+/*
+ * Starts the file system and finds (or creates) the game's save folder.
+ * @return Returns true if the save folder can be used, false otherwise.
+ */
+extern bool initSavePath();
+
+/*
+ * Tells whether the save folder can be used.
+ * @return Returns true if it can, false otherwise.
+ */
+extern bool isSavePathReady();
+
+/*
+ * Turns the reading and writing of save files on or off.  While it is
+ * off, getSavePath fails, so everything that is saved starts out empty
+ * and nothing is written.  Used while a replay is played back, so that
+ * the playback neither depends on nor changes what is on the SD card.
+ * @param enabled Whether save files can be used.
+ */
+extern void setSaveFilesEnabled(bool enabled);
+
+/*
+ * Gets the path of a file in the save folder.
+ * @param fileName The name of the file (IE: "player.usr").
+ * @param path Set to the file's path.
+ * @param size The size of the path, which should be MAX_SAVE_PATH_LENGTH.
+ * @return Returns true if the path was made, false if there is no save
+ * folder, save files are turned off, or the path is too long.
+ */
+extern bool getSavePath(const char* fileName, char* path, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
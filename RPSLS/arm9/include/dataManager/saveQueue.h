@@ -0,0 +1,115 @@
+/*
+ * A queue for writing save files a little at a time.  Saves are copied
+ * into the queue and written in small chunks from updateAll, with a limit
+ * on how long each frame can spend writing, so a slow SD card doesn't
+ * stall the game.  Saves to the same file that haven't started yet are
+ * merged together.
+ */
+
+#ifndef _SAVE_QUEUE_H_
+#define _SAVE_QUEUE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of saves that can be waiting at once.
+ */
+#define MAX_SAVE_REQUESTS 8
+
+/*
+ * The amount of bytes written to the file at a time.
+ */
+#define SAVE_CHUNK_SIZE 512
+
+/*
+ * The max length of the path of a save's temporary file.
+ */
+#define MAX_SAVE_TEMP_PATH_LENGTH (MAX_SAVE_PATH_LENGTH + 4)
+
+/*
+ * The default amount of time each frame can spend writing, in clock
+ * ticks (about 2 milliseconds).
+ */
+#define DEFAULT_SAVE_BUDGET (TIME_TICKS_PER_SECOND / 500)
+
+/*
+ * Queues data to be written to a file.  The data is copied, so it can
+ * be changed straight after.  Every save is written to a temporary file
+ * which replaces the file once it has all been written, so the old file is
+ * never left half written; appends copy the old file into the temporary
+ * file first.  If the file already has a save waiting that hasn't started,
+ * they are merged: a new whole file replaces the old data, and appends are
+ * added to the end of it.
+ * @param fileName The name of the file to write.
+ * @param data The data to write.
+ * @param size The size of the data in bytes.
+ * @param append Whether to add the data to the end of the file instead of
+ * replacing the file.
+ * @return Returns true if the save was queued, false if it couldn't be.
+ */
+extern bool queueSave(const char* fileName, const void* data, int size, bool append);
+
+/*
+ * Gets the name of the temporary file a save is written to before it
+ * replaces the file.
+ * @param fileName The name of the file being saved.
+ * @param tempName Set to the temporary file's name.
+ * @param size The size of tempName, which should be MAX_SAVE_TEMP_PATH_LENGTH.
+ * @return Returns true if the name fit.
+ */
+extern bool getTempSavePath(const char* fileName, char* tempName, int size);
+
+/*
+ * Writes the queued saves until the frame's time budget is spent.
+ * Called by updateAll each frame.
+ */
+extern void updateSaveQueue();
+
+/*
+ * Writes every queued save straight away.  Should be called before
+ * reading a file that may have a save waiting, and before the game exits.
+ * @return Returns true if every save was written, false if any failed.
+ */
+extern bool flushSaveQueue();
+
+/*
+ * Sets how long each frame can spend writing saves.
+ * @param ticks The time in clock ticks (0 writes one chunk per frame).
+ */
+extern void setSaveBudget(u32 ticks);
+
+/*
+ * Gets the amount of saves waiting to be written.
+ * @return Returns the amount of saves.
+ */
+extern int getSaveQueueDepth();
+
+/*
+ * Gets how long the last save took, from being queued to being written.
+ * @return Returns the time in clock ticks.
+ */
+extern u32 getLastSaveLatency();
+
+/*
+ * Gets the longest time a save has taken, from being queued to being
+ * written.
+ * @return Returns the time in clock ticks.
+ */
+extern u32 getMaxSaveLatency();
+
+/*
+ * Gets the amount of saves that failed to write.
+ * @return Returns the amount of failed saves.
+ */
+extern u32 getFailedSaveCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,6 +16,21 @@ extern "C" {
 #include <nds.h>
 #include "timeFunctions.h"
 
+/*
+ * The magic number at the start of a user's save ("GUSR").
+ */
+#define USER_DATA_MAGIC 0x52535547
+
+/*
+ * The version of the user save's layout.
+ */
+#define USER_DATA_VERSION 1
+
+/*
+ * The most data a user's save can hold.
+ */
+#define USER_DATA_SAVE_SIZE 128
+
 /*
  * A structure containing the user's data.
  * isBirthdayToday - Tells whether the user's
@@ -62,6 +77,15 @@ extern void saveUserData(const char* user);
  */
 extern void deleteUserData(const char* user);
 
+/*
+ * Gets the name of the current user, in a form that is safe to use in a
+ * file name.  If no user is loaded, the name set on the Nintendo DS/DSi
+ * is used.
+ * @param name Set to the user's name.
+ * @param size The size of the name (at least 11).
+ */
+extern void getCurrentUserName(char* name, int size);
+
 /*
  * Updates the user's data (IE: birthday, events, etc.)
  */
@@ -0,0 +1,89 @@
+/*
+ * The computer opponent for single player.  It keeps a model of the
+ * player's choices (how often each is picked, and what tends to follow the
+ * last one and the last two), predicts the next choice from it, and plays
+ * whatever does best against the prediction.  Updating the model and
+ * choosing a move both take the same small amount of work every match, and
+ * all of the tables are fixed size so nothing is allocated while playing.
+ */
+
+#ifndef _AI_OPPONENT_H_
+#define _AI_OPPONENT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The amount of choices in a match.
+ */
+#define AI_CHOICES 5
+
+/*
+ * The value of one observed choice in the model's tables (8.8 fixed point).
+ */
+#define AI_COUNT_ONE 256
+
+/*
+ * The difficulty levels for the computer.
+ * AI_EASY - Mostly random, and only looks at how often each choice is picked.
+ * AI_NORMAL - Sometimes random, and also looks at what follows the last choice.
+ * AI_HARD - Rarely random, and also looks at what follows the last two choices.
+ */
+typedef enum
+{
+	AI_EASY = 0,
+	AI_NORMAL = 1,
+	AI_HARD = 2,
+	AI_DIFFICULTIES = 3
+} aiDifficulty_t;
+
+/*
+ * Sets up the computer opponent, clearing its model of the player.
+ * @param results The results table, where results[a][b] is the result of
+ * choice a against choice b (-1 is a loss, 0 a tie, 1 a win).
+ * @param difficulty The difficulty level.
+ */
+extern void initAiOpponent(const int results[AI_CHOICES][AI_CHOICES], aiDifficulty_t difficulty);
+
+/*
+ * Starts the model's choice counts from the player's saved history, so the
+ * computer doesn't start from nothing each session.
+ * @param choices The amount of times each choice has been picked.
+ * @param lastChoice The player's last choice, or -1 if there isn't one.
+ */
+extern void seedAiOpponent(const u16 choices[AI_CHOICES], int lastChoice);
+
+/*
+ * Sets the computer's difficulty level.
+ * @param difficulty The difficulty level.
+ */
+extern void setAiDifficulty(aiDifficulty_t difficulty);
+
+/*
+ * Gets the computer's difficulty level.
+ * @return Returns the difficulty level.
+ */
+extern aiDifficulty_t getAiDifficulty();
+
+/*
+ * Chooses the computer's next move.
+ * @return Returns the choice (0 to AI_CHOICES - 1).
+ */
+extern int chooseAiMove();
+
+/*
+ * Adds the player's choice to the computer's model.  Should be called
+ * after each match.
+ * @param choice The player's choice.
+ */
+extern void observePlayerMove(int choice);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
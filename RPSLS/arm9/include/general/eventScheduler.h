@@ -0,0 +1,79 @@
+/*
+ * Contains a scheduler for calendar events (event_t).  Events are kept in a
+ * min-heap ordered by the next day they happen on, and the heap is only
+ * checked when the date changes, so the cost per frame stays the same no
+ * matter how many events there are.
+ */
+
+#ifndef _EVENT_SCHEDULER_H_
+#define _EVENT_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "timeFunctions.h"
+
+/*
+ * The max amount of events that can be scheduled at once.
+ */
+#define MAX_SCHEDULED_EVENTS 64
+
+/*
+ * A function called when an event happens.
+ * @param event The event that happened.
+ */
+typedef void (*eventCallback_t)(event_t* event);
+
+/*
+ * Schedules an event.  The event is set to active on its date, and its
+ * callback is called.  Events with a year <= 0 happen every year.
+ * @param event The event to schedule.  It must stay around while scheduled.
+ * @param callback The function to call when the event happens, or NULL.
+ * @return Returns true if the event was scheduled, false if it has already
+ * passed or there is no room left.
+ */
+extern bool scheduleEvent(event_t* event, eventCallback_t callback);
+
+/*
+ * Schedules a table of events.
+ * @param events The events to schedule.
+ * @param count The amount of events.
+ * @param callback The function to call when any of the events happen, or NULL.
+ * @return Returns the amount of events that were scheduled.
+ */
+extern int loadEventTable(event_t* events, int count, eventCallback_t callback);
+
+/*
+ * Stops an event from being scheduled.
+ * @param event The event to unschedule.
+ */
+extern void unscheduleEvent(event_t* event);
+
+/*
+ * Unschedules all of the events.
+ */
+extern void clearEvents();
+
+/*
+ * Gets the amount of days between 1970-01-01 and a date.
+ * @param year The year of the date.
+ * @param month The month of the date (1-12).
+ * @param day The day of the date (1-31).
+ * @return Returns the amount of days.
+ */
+extern s32 getDayNumber(int year, int month, int day);
+
+/*
+ * Checks if any events happen today.  Called by updateAll, and only does
+ * any work when the date has changed.
+ */
+extern void updateEvents();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
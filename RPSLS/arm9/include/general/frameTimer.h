@@ -0,0 +1,70 @@
+/*
+ * Contains a fixed timestep frame timer.  The time since the last frame is
+ * read from the clock's hardware timers and added to an accumulator, which
+ * is then spent in fixed logic steps.  When a frame runs long, the next one
+ * runs several steps before drawing, so the game keeps the same speed no
+ * matter how often it is drawn.
+ */
+
+#ifndef _FRAME_TIMER_H_
+#define _FRAME_TIMER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The amount of logic steps in a second.
+ */
+#define FRAME_STEP_RATE 60
+
+/*
+ * The max amount of logic steps run before a frame is drawn.  Any more
+ * than this are dropped, so that the game slows down instead of never
+ * drawing again.
+ */
+#define MAX_FRAME_STEPS 4
+
+/*
+ * Starts (or restarts) the frame timer.  Should be called right before a
+ * timed loop, so that the time spent loading beforehand isn't caught up on.
+ */
+extern void startFrameTimer();
+
+/*
+ * Gets the amount of logic steps to run before the next frame is drawn.
+ * Called once per frame.
+ * @return Returns the amount of steps, from 0 to MAX_FRAME_STEPS.
+ */
+extern int getFrameSteps();
+
+/*
+ * Locks the frame timer to one logic step per frame, whatever the time.
+ * Used while input is being recorded or played back, so that each frame
+ * does the same thing every time.
+ * @param locked Whether to lock the frame timer.
+ */
+extern void setFrameTimerLocked(bool locked);
+
+/*
+ * Gets the amount of logic steps that were dropped because there were too
+ * many to catch up on.
+ * @return Returns the amount of dropped steps.
+ */
+extern u32 getDroppedFrameCount();
+
+/*
+ * Gets the amount of frames that were drawn late, and so had to run more
+ * than one logic step.
+ * @return Returns the amount of late frames.
+ */
+extern u32 getLateFrameCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Contains the input system.  The keys and touch screen are sampled once
+ * every vertical blank into a ring buffer of timestamped snapshots, and
+ * each frame updateAll turns the snapshots since the last frame into
+ * pressed, released and held keys.  Presses that start and end between
+ * two frames are still seen, and the game never has to poll the hardware
+ * itself.
+ */
+
+#ifndef _INPUT_FUNCTIONS_H_
+#define _INPUT_FUNCTIONS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The amount of snapshots kept.  Must be a power of 2.
+ */
+#define INPUT_HISTORY 32
+
+/*
+ * The amount of key bits (A through the lid).
+ */
+#define INPUT_KEY_COUNT 14
+
+/*
+ * The max amount of players.
+ */
+#define MAX_INPUT_PLAYERS 2
+
+/*
+ * A structure for a snapshot of the input.
+ * ticks - When the snapshot was taken (see getTimeTicks).
+ * keys - The keys that were held.
+ * touchX - The X position of the stylus, if KEY_TOUCH is held.
+ * touchY - The Y position of the stylus, if KEY_TOUCH is held.
+ */
+typedef struct inputSnapshot_t
+{
+	u32 ticks;
+	u32 keys;
+	u16 touchX;
+	u16 touchY;
+} inputSnapshot_t;
+
+/*
+ * A structure for one frame of input, as worked out by updateInput.
+ * Used to record and play back input.
+ * keysDown - The keys pressed during the frame.
+ * keysUp - The keys released during the frame.
+ * keysHeld - The keys held at the end of the frame.
+ * touchX - The X position of the stylus during the frame.
+ * touchY - The Y position of the stylus during the frame.
+ */
+typedef struct inputFrame_t
+{
+	u16 keysDown;
+	u16 keysUp;
+	u16 keysHeld;
+	u8 touchX;
+	u8 touchY;
+} inputFrame_t;
+
+/*
+ * Takes a snapshot of the input.  Called by the frame pipeline every
+ * vertical blank.
+ */
+extern void sampleInput();
+
+/*
+ * Works out the pressed, released and held keys from the snapshots taken
+ * since the last call.  Called by updateAll.
+ */
+extern void updateInput();
+
+/*
+ * Sets which keys belong to a player.
+ * @param player The player.
+ * @param keys The player's keys.
+ */
+extern void setPlayerKeys(int player, u32 keys);
+
+/*
+ * Gets the keys that were pressed this frame.
+ * @return Returns the pressed keys.
+ */
+extern u32 getKeysDown();
+
+/*
+ * Gets the keys that were released this frame.
+ * @return Returns the released keys.
+ */
+extern u32 getKeysUp();
+
+/*
+ * Gets the keys that are held.
+ * @return Returns the held keys.
+ */
+extern u32 getKeysHeld();
+
+/*
+ * Gets a player's keys that were pressed this frame.
+ * @param player The player.
+ * @return Returns the pressed keys.
+ */
+extern u32 getPlayerKeysDown(int player);
+
+/*
+ * Gets a player's keys that were released this frame.
+ * @param player The player.
+ * @return Returns the released keys.
+ */
+extern u32 getPlayerKeysUp(int player);
+
+/*
+ * Gets a player's keys that are held.
+ * @param player The player.
+ * @return Returns the held keys.
+ */
+extern u32 getPlayerKeysHeld(int player);
+
+/*
+ * Takes presses out of this frame's pressed keys, so that no other code
+ * sees them.
+ * @param keys The keys to take.
+ * @return Returns the keys that had been pressed.
+ */
+extern u32 consumeKeysDown(u32 keys);
+
+/*
+ * Gets when a key was last pressed.
+ * @param key The key.
+ * @return Returns the tick count of the snapshot the key was pressed in.
+ */
+extern u32 getKeyDownTicks(u32 key);
+
+/*
+ * Gets the position of the stylus this frame.
+ * @return Returns the last position touched since the last frame, or 0, 0
+ * if the touch screen wasn't touched.
+ */
+extern touchPosition getTouchPosition();
+
+/*
+ * Gets the latest snapshot used by updateInput.
+ * @return Returns the snapshot.
+ */
+extern inputSnapshot_t getInputSnapshot();
+
+/*
+ * Gets this frame's input.
+ * @param frame Set to this frame's input.
+ */
+extern void getInputFrame(inputFrame_t* frame);
+
+/*
+ * Replaces this frame's input (IE: with input being played back).
+ * @param frame The input to use for this frame.
+ */
+extern void setInputFrame(const inputFrame_t* frame);
+
+/*
+ * Gets the amount of snapshots that were lost because the game went too
+ * long between frames.
+ * @return Returns the amount of lost snapshots.
+ */
+extern u32 getLostInputCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
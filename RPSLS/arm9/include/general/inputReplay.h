@@ -0,0 +1,108 @@
+/*
+ * Contains an input recorder.  A session's random seed and the input of
+ * every frame are recorded to a file, and can be played back through the
+ * input system later so that the game does exactly the same thing again.
+ * This is used for repeatable benchmark runs with the profiler.
+ */
+
+#ifndef _INPUT_REPLAY_H_
+#define _INPUT_REPLAY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "inputFunctions.h"
+
+/*
+ * The file replays are kept in, inside the save folder.
+ */
+#define REPLAY_FILE "replay.rpl"
+
+/*
+ * The magic number at the start of a replay file ("RPLY").
+ */
+#define REPLAY_MAGIC 0x594C5052
+
+/*
+ * The version of the replay file format.
+ */
+#define REPLAY_VERSION 1
+
+/*
+ * The max amount of frames in a replay (5 minutes).
+ */
+#define MAX_REPLAY_FRAMES (60 * 60 * 5)
+
+/*
+ * The start of a replay file.  The frames follow it.
+ * magic - REPLAY_MAGIC.
+ * version - REPLAY_VERSION.
+ * frameSize - The size of each frame, in case it changes.
+ * seed - The random seed of the session.
+ * frameCount - The amount of frames.
+ */
+typedef struct replayHeader_t
+{
+	u32 magic;
+	u16 version;
+	u16 frameSize;
+	u32 seed;
+	u32 frameCount;
+} replayHeader_t;
+
+/*
+ * Starts recording the input.  The recording is saved when stopReplay is
+ * called, when SELECT is pressed, or when MAX_REPLAY_FRAMES is reached.
+ * @param fileName The file to save the recording to.
+ * @param seed The random seed of the session.
+ * @return Returns true if the recording started, false if there wasn't
+ * enough memory.
+ */
+extern bool startReplayRecording(const char* fileName, u32 seed);
+
+/*
+ * Starts playing back a recording.  The frame timer is locked to one
+ * step per frame, and in profiling builds every frame is logged.
+ * @param fileName The file to play back.
+ * @return Returns true if the recording is being played back, false if it
+ * couldn't be loaded.
+ */
+extern bool startReplayPlayback(const char* fileName);
+
+/*
+ * Stops recording (saving the recording) or playing back.
+ */
+extern void stopReplay();
+
+/*
+ * Gets the random seed of the recording being played back or recorded.
+ * @return Returns the seed.
+ */
+extern u32 getReplaySeed();
+
+/*
+ * Checks if input is being recorded.
+ * @return Returns true if recording, false otherwise.
+ */
+extern bool isReplayRecording();
+
+/*
+ * Checks if a recording is being played back.
+ * @return Returns true if playing back, false otherwise.
+ */
+extern bool isReplayPlaying();
+
+/*
+ * Records or plays back this frame's input.  Called by updateAll right
+ * after updateInput.
+ */
+extern void updateReplay();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
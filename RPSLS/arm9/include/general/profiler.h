@@ -0,0 +1,179 @@
+/*
+ * Contains a frame profiler based on the DS's hardware timers.  Named scopes
+ * can be nested, the time spent in each one is kept for the last
+ * PROFILE_HISTORY frames, and an overlay can show the results on a text
+ * layer.  Everything is used through the PROFILE_ macros, which compile to
+ * nothing unless GEM_PROFILE is defined (make PROFILE=YES).
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of different scopes.
+ */
+#define MAX_PROFILE_SCOPES 16
+
+/*
+ * The max amount of scopes that can be nested inside each other.
+ */
+#define PROFILE_MAX_DEPTH 8
+
+/*
+ * The amount of frames kept for each scope.
+ */
+#define PROFILE_HISTORY 64
+
+/*
+ * The amount of frames between each redraw of the overlay.
+ */
+#define PROFILE_OVERLAY_RATE 30
+
+/*
+ * The length a logged line is split at.
+ */
+#define PROFILE_LOG_LINE_LENGTH 80
+
+#ifdef GEM_PROFILE
+
+/*
+ * Starts the profiler.  Uses timers 0 and 1.
+ */
+extern void initProfiler();
+
+/*
+ * Gets the ID of a scope, adding it if it doesn't exist yet.
+ * @param name The name of the scope.
+ * @return Returns the ID of the scope, or -1 if there is no room left or
+ * the profiler hasn't been started.
+ */
+extern int getProfileScope(const char* name);
+
+/*
+ * Starts timing a scope.
+ * @param id The ID of the scope.
+ */
+extern void beginProfileScope(int id);
+
+/*
+ * Stops timing the scope that was started last.
+ */
+extern void endProfileScope();
+
+/*
+ * Adds time that was measured outside of the scopes to a scope.  Used for
+ * the time spent in interrupts, which can't use the scope stack since they
+ * can happen in the middle of any scope.
+ * @param id The ID of the scope.
+ * @param ticks The time to add in timer ticks.
+ */
+extern void addProfileTicks(int id, u32 ticks);
+
+/*
+ * Ends the current frame, saving the time spent in each scope.
+ * Called once per frame by updateAll.
+ */
+extern void endProfileFrame();
+
+/*
+ * Gets the min, average and max time spent in a scope over the last frames.
+ * @param id The ID of the scope.
+ * @param min Set to the min time in microseconds.
+ * @param avg Set to the average time in microseconds.
+ * @param max Set to the max time in microseconds.
+ */
+extern void getProfileStats(int id, u32* min, u32* avg, u32* max);
+
+/*
+ * Shows or hides the profiler's overlay.
+ * @param screen The screen to show the overlay on (its text layer).
+ * @param show Whether to show the overlay.
+ */
+extern void showProfilerOverlay(int screen, bool show);
+
+/*
+ * Sets whether each frame's times are written to the emulator's debug
+ * output (no$gba style), one line per frame.
+ * @param log Whether to log the frames.
+ */
+extern void setProfilerLogging(bool log);
+
+/*
+ * Starts the profiler.
+ */
+#define PROFILE_INIT() initProfiler()
+
+/*
+ * Starts timing a named scope.  The name should be a string literal, since
+ * its ID is looked up once and then kept.
+ */
+#define PROFILE_BEGIN(name) \
+	do \
+	{ \
+		static int profileId = -1; \
+		if(profileId < 0) \
+		{ \
+			profileId = getProfileScope(name); \
+		} \
+		beginProfileScope(profileId); \
+	} while(0)
+
+/*
+ * Stops timing the scope that was started last.
+ */
+#define PROFILE_END() endProfileScope()
+
+/*
+ * Adds time measured with cpuGetTiming to a named scope.  Used in
+ * interrupts instead of PROFILE_BEGIN and PROFILE_END.
+ */
+#define PROFILE_ADD(name, ticks) \
+	do \
+	{ \
+		static int profileId = -1; \
+		if(profileId < 0) \
+		{ \
+			profileId = getProfileScope(name); \
+		} \
+		addProfileTicks(profileId, ticks); \
+	} while(0)
+
+/*
+ * Ends the current frame.
+ */
+#define PROFILE_FRAME() endProfileFrame()
+
+/*
+ * Shows or hides the overlay.
+ */
+#define PROFILE_OVERLAY(screen, show) showProfilerOverlay(screen, show)
+
+/*
+ * Starts or stops logging each frame's times.
+ */
+#define PROFILE_LOG(log) setProfilerLogging(log)
+
+#else
+
+#define PROFILE_INIT() ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#define PROFILE_ADD(name, ticks) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_OVERLAY(screen, show) ((void)0)
+#define PROFILE_LOG(log) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Contains a cooperative task scheduler.  Tasks are small state machines
+ * that are run once per frame by updateAll, and give up the CPU by
+ * yielding until the next frame.  This lets several things (fades,
+ * animations, waiting on input) happen at the same time without any of
+ * them owning the frame loop.
+ *
+ * A task is written with the TASK_ macros, which turn the body of the
+ * function into a switch so that it picks up where it left off:
+ *
+ * static bool blinkTask(task_t* task)
+ * {
+ *     TASK_BEGIN(task);
+ *     for(task->vars[0] = 0;task->vars[0] < 10;task->vars[0] += 1)
+ *     {
+ *         setSpriteVisible(0, 0, task->vars[0] & 1);
+ *         TASK_YIELD(task);
+ *     }
+ *     TASK_END(task);
+ * }
+ *
+ * Local variables are not kept between frames, so any state has to be
+ * stored in the task's vars or data.
+ */
+
+#ifndef _TASK_SCHEDULER_H_
+#define _TASK_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of tasks that can run at once.
+ */
+#define MAX_TASKS 16
+
+/*
+ * The amount of variables each task has for its own state.
+ */
+#define TASK_VAR_COUNT 4
+
+/*
+ * A structure for a task.
+ * line - Where the task left off (used by the TASK_ macros).
+ * vars - Variables for the task's state.
+ * data - The data the task was started with.
+ */
+typedef struct task_t
+{
+	int line;
+	int vars[TASK_VAR_COUNT];
+	void* data;
+} task_t;
+
+/*
+ * A task function.  Runs the task until it yields or ends.
+ * @param task The task being run.
+ * @return Returns true if the task is still running, false if it is done.
+ */
+typedef bool (*taskFunction_t)(task_t* task);
+
+/*
+ * Starts the body of a task.
+ */
+#define TASK_BEGIN(task) switch((task)->line) { case 0:
+
+/*
+ * Gives up the CPU until the next frame.
+ */
+#define TASK_YIELD(task) \
+	do \
+	{ \
+		(task)->line = __LINE__; \
+		return true; \
+		case __LINE__:; \
+	} while(0)
+
+/*
+ * Gives up the CPU each frame until the condition is true.
+ */
+#define TASK_WAIT_UNTIL(task, condition) \
+	do \
+	{ \
+		(task)->line = __LINE__; \
+		case __LINE__: \
+		if(!(condition)) \
+		{ \
+			return true; \
+		} \
+	} while(0)
+
+/*
+ * Ends the body of a task.
+ */
+#define TASK_END(task) } (task)->line = 0; return false
+
+/*
+ * Starts a task.  It is first run in the next updateAll.
+ * @param function The task function.
+ * @param data The data for the task (can be NULL).
+ * @return Returns the ID of the task, or -1 if too many are running.
+ */
+extern int startTask(taskFunction_t function, void* data);
+
+/*
+ * Gets a running task, so that its vars can be set before it first runs.
+ * @param id The ID of the task.
+ * @return Returns the task, or NULL if it isn't running.
+ */
+extern task_t* getTask(int id);
+
+/*
+ * Stops a task.
+ * @param id The ID of the task.
+ */
+extern void stopTask(int id);
+
+/*
+ * Checks if a task is still running.
+ * @param id The ID of the task.
+ * @return Returns true if the task is running, false otherwise.
+ */
+extern bool isTaskRunning(int id);
+
+/*
+ * Runs each task once.  Called by updateAll.
+ */
+extern void updateTasks();
+
+/*
+ * Keeps updating the game until a task is done.
+ * @param id The ID of the task.
+ */
+extern void waitForTask(int id);
+
+/*
+ * Keeps updating the game until one of the keys is pressed.
+ * @param keys The keys to wait for.
+ * @return Returns the keys that were pressed.
+ */
+extern u32 waitForKeysDown(u32 keys);
+
+/*
+ * Keeps updating the game until none of the keys are held.
+ * @param keys The keys to wait for.
+ */
+extern void waitForKeysReleased(u32 keys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
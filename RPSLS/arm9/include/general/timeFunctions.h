@@ -14,6 +14,11 @@ extern "C" {
 #include <nds.h>
 #include <time.h>
 
+/*
+ * The amount of clock ticks in a second (the bus clock / 1024).
+ */
+#define TIME_TICKS_PER_SECOND 32728
+
 /*
  * A structure for storing a specific date.
  * day - The day of the date.
@@ -46,10 +51,43 @@ typedef struct event_t
 }event_t;
 
 /*
- *  Holds the time of according to the DS.
+ *  Holds the time of according to the DS.  This is only worked out
+ *  when one of the getters is called, so use the getters instead of
+ *  reading it directly.
  */
 extern struct tm* DSTime;
 
+/*
+ * Starts the clock.  Timers 2 and 3 are cascaded into a 32 bit tick
+ * counter, and the RTC is read for the first time.  Called by updateTime
+ * if it hasn't been called already.
+ */
+extern void initTime();
+
+/*
+ * Gets the amount of ticks since the clock was started.
+ * There are TIME_TICKS_PER_SECOND ticks in a second.
+ * @return Returns the tick count.
+ */
+extern u32 getTimeTicks();
+
+/*
+ * Gets the current time according to the DS in seconds since 1970.
+ * @return Returns the time.
+ */
+extern time_t getTimeUnix();
+
+/*
+ * Gets the amount of milliseconds into the current second.
+ * @return Returns the milliseconds (0-999).
+ */
+extern int getTimeMilliseconds();
+
+/*
+ * Reads the RTC right away, rather than waiting for the next second.
+ */
+extern void refreshTime();
+
 /*
  * Gets the current secconds past according to the DS.
  * @return Returns the seconds as an integer.
@@ -107,7 +145,9 @@ extern int getTimeYear();
 extern char* getTimeText();
 
 /*
- *  Updates the current time according to the DS.
+ *  Updates the current time according to the DS.  The RTC is only read
+ *  when the next second is due, and the broken down time is only worked
+ *  out again when a getter needs it.
  */
 extern void updateTime();
 
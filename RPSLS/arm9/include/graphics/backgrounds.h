@@ -17,6 +17,18 @@ extern "C"
 #include <nds.h>
 #include "generic.h"
 
+/*
+ * The amount of VRAM set aside for each background's tiles
+ * (512 tiles at 8 bits per pixel).
+*/
+#define BG_TILE_VRAM_SIZE 0x8000
+
+/*
+ * The amount of VRAM that each background's map blocks are streamed
+ * into (two 4KB halves).
+*/
+#define BG_MAP_VRAM_SIZE 0x2000
+
 /*
  * Defines for a single tile type.
 */
@@ -41,7 +53,8 @@ typedef unsigned short* paletteData_t;
  * @param index The index (layer) to create the background on.
  * @param width The width of the background.
  * @param height The height of the background.
- * @return An integer that points to the background.
+ * @return An integer that points to the background, or -1 if there
+ * was not enough VRAM for it.
 */
 extern int createBg(int screen, int index, u32 width, u32 height);
 
@@ -70,6 +83,29 @@ extern void setBgTiles(int screen, int index, const unsigned int* tiles, u32 til
  */
 extern void setBgMap(int screen, int index, const unsigned short* map, u32 mapSize);
 
+/*
+ * Gives the desired background a map that was allocated with malloc.  The
+ * background keeps the map, instead of copying it, and frees it when it is
+ * replaced or the background is deleted.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param map The map's data, which must not be used or freed afterwards.
+ * @param mapSize The size of the map's data.
+ */
+extern void adoptBgMap(int screen, int index, unsigned short* map, u32 mapSize);
+
+/*
+ * Gets the desired background's tile memory, so that tiles can be streamed
+ * straight into it.  The background's copy of its previous tiles is freed,
+ * since it no longer matches VRAM.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param size Set to the amount of tile memory reserved for the background.
+ * @return Returns a pointer to the tile memory, or NULL if the background
+ * has not been created.
+ */
+extern void* beginBgTileStream(int screen, int index, u32* size);
+
 /*
  * Sets the desired background's map with the desired
  * scroll amount.
@@ -80,6 +116,16 @@ extern void setBgMap(int screen, int index, const unsigned short* map, u32 mapSi
  */
 extern void setBgPosition(int screen, int index, s32 x, s32 y);
 
+/*
+ * Sets the desired background's map with the desired scroll
+ * amount, without applying the background's parallax speeds.
+ * @param screen The screen to create the background on.
+ * @param index The index (layer) to create the background on.
+ * @param x The x position to scroll to.
+ * @param y The y position to scroll to.
+ */
+extern void setBgAbsolutePosition(int screen, int index, s32 x, s32 y);
+
 /*
  * Sets the desired backgrounds palette to be grayscale.
  * @param screen The screen that the background is on.
@@ -140,10 +186,42 @@ extern int getBgParallaxSpeedsY(int screen, int index);
 extern boundarySize_t getBgSize(int screen, int index);
 
 /*
- * Updates the background system.
+ * Get's the libnds id of the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @return Returns the background's id, or -1 if it has not been created.
+ */
+extern int getBgId(int screen, int index);
+
+/*
+ * Get's the desired background's hardware scroll values.
+ * @param screen The screen to get the scroll values from.
+ * @param index The index (layer) to get the scroll values from.
+ * @return Returns the scroll values written to the background's registers.
+ */
+extern coordinates_t getBgScroll(int screen, int index);
+
+/*
+ * Get's the desired background's absolute scroll position, which is the
+ * position of its map block plus its hardware scroll values.
+ * @param screen The screen to get the position from.
+ * @param index The index (layer) to get the position from.
+ * @return Returns the position of the background's top left corner on its map.
+ */
+extern coordinates_t getBgAbsoluteScroll(int screen, int index);
+
+/*
+ * Updates the background system.  Sets the shadow scroll values of each
+ * background, which are written to the registers when the frame is committed.
 */
 extern void updateBackgrounds();
 
+/*
+ * Writes the shadow scroll values to the background registers.  Called
+ * during the vertical blank when the frame is committed.
+*/
+extern void commitBackgrounds();
+
 /*
  * Sets the desired background's collision map data.  This data
  * is used for collision detection.
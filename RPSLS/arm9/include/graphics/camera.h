@@ -0,0 +1,168 @@
+/*
+ * Contains a camera for scrolling several backgrounds (and sprites) at
+ * once.  The camera's position is kept in 20.12 fixed point, and each
+ * background bound to it has its own fixed point speed, which allows any
+ * parallax ratio instead of only powers of two.
+ */
+
+#ifndef _CAMERA_H_
+#define _CAMERA_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "generic.h"
+
+/*
+ * The number of fractional bits used by the camera's fixed point values.
+ */
+#define CAMERA_FIXED_SHIFT 12
+
+/*
+ * The speed that moves a background or sprite at the same
+ * rate as the camera (1.0 in fixed point).
+ */
+#define CAMERA_SPEED_NORMAL (1 << CAMERA_FIXED_SHIFT)
+
+/*
+ * Converts an integer to the camera's fixed point format.
+ */
+#define intToCamera(n) ((s32)(n) << CAMERA_FIXED_SHIFT)
+
+/*
+ * Converts a value in the camera's fixed point format to an integer.
+ */
+#define cameraToInt(n) ((s32)(n) >> CAMERA_FIXED_SHIFT)
+
+/*
+ * The max amount of sprites that can be bound to a camera.
+ */
+#define MAX_CAMERA_SPRITES 32
+
+/*
+ * A structure for a sprite that is bound to a camera.
+ * active - Whether the slot is being used.
+ * screen - The screen the sprite is on.
+ * index - The index of the sprite.
+ * world - The sprite's position in the world.
+ * speed - The sprite's speed relative to the camera (fixed point).
+ * position - The last position the sprite was moved to.
+ */
+typedef struct cameraSprite_t
+{
+	bool active;
+	int screen;
+	int index;
+	coordinates_t world;
+	s32 speed;
+	coordinates_t position;
+} cameraSprite_t;
+
+/*
+ * A structure for a camera.
+ * x - The camera's x position (20.12 fixed point).
+ * y - The camera's y position (20.12 fixed point).
+ * boundLayers - Whether each background is bound to the camera.
+ * layerSpeedsX - The x speed of each background (fixed point).
+ * layerSpeedsY - The y speed of each background (fixed point).
+ * layerPositions - The last position each background was scrolled to.
+ * layerUpdated - Whether each background has been scrolled since it was bound.
+ * sprites - The sprites that are bound to the camera.
+ */
+typedef struct camera_t
+{
+	s32 x;
+	s32 y;
+	bool boundLayers[2][4];
+	s32 layerSpeedsX[2][4];
+	s32 layerSpeedsY[2][4];
+	coordinates_t layerPositions[2][4];
+	bool layerUpdated[2][4];
+	cameraSprite_t sprites[MAX_CAMERA_SPRITES];
+} camera_t;
+
+/*
+ * Initializes a camera at position (0, 0) with nothing bound to it.
+ * @param camera The camera to initialize.
+ */
+extern void initCamera(camera_t* camera);
+
+/*
+ * Sets the camera's position.
+ * @param camera The camera to move.
+ * @param x The x position (20.12 fixed point).
+ * @param y The y position (20.12 fixed point).
+ */
+extern void setCameraPosition(camera_t* camera, s32 x, s32 y);
+
+/*
+ * Moves the camera by the desired amount.
+ * @param camera The camera to move.
+ * @param dx The amount to move on the x axis (20.12 fixed point).
+ * @param dy The amount to move on the y axis (20.12 fixed point).
+ */
+extern void moveCamera(camera_t* camera, s32 dx, s32 dy);
+
+/*
+ * Binds a background to the camera.  The background's parallax speeds
+ * set with setBgParallaxSpeeds are not used while it is bound.
+ * @param camera The camera to bind to.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param speedX The x speed of the background (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ * @param speedY The y speed of the background (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ */
+extern void bindCameraLayer(camera_t* camera, int screen, int index, s32 speedX, s32 speedY);
+
+/*
+ * Unbinds a background from the camera.
+ * @param camera The camera to unbind from.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+extern void unbindCameraLayer(camera_t* camera, int screen, int index);
+
+/*
+ * Binds a sprite to the camera.
+ * @param camera The camera to bind to.
+ * @param screen The screen the sprite is on.
+ * @param index The index of the sprite.
+ * @param x The sprite's x position in the world.
+ * @param y The sprite's y position in the world.
+ * @param speed The sprite's speed (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ * @return Returns the slot the sprite was bound to, or -1 if there are no free slots.
+ */
+extern int bindCameraSprite(camera_t* camera, int screen, int index, int x, int y, s32 speed);
+
+/*
+ * Sets the world position of a sprite bound to the camera.
+ * @param camera The camera the sprite is bound to.
+ * @param slot The slot returned by bindCameraSprite.
+ * @param x The sprite's x position in the world.
+ * @param y The sprite's y position in the world.
+ */
+extern void setCameraSpritePosition(camera_t* camera, int slot, int x, int y);
+
+/*
+ * Unbinds a sprite from the camera.
+ * @param camera The camera the sprite is bound to.
+ * @param slot The slot returned by bindCameraSprite.
+ */
+extern void unbindCameraSprite(camera_t* camera, int slot);
+
+/*
+ * Moves all of the backgrounds and sprites bound to the camera.  Should be
+ * called once per frame.  Backgrounds whose position did not change are
+ * left alone, so their maps are only streamed when they actually move.
+ * @param camera The camera to update.
+ */
+extern void updateCamera(camera_t* camera);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
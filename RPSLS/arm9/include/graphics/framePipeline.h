@@ -0,0 +1,85 @@
+/*
+ * Contains the frame pipeline.  Each frame is split in two: updateAll
+ * prepares the frame while the screens are being drawn (shadow OAM, shadow
+ * scroll values, text widget changes and queued VRAM uploads), and the
+ * vertical blank interrupt then commits all of it at once, at the very
+ * start of the vertical blank.
+ */
+
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of VRAM uploads that can be queued in a frame.
+ */
+#define MAX_VRAM_UPLOADS 64
+
+/*
+ * The DMA channel used for VRAM uploads.  Channels 0 and 1 are used by the
+ * scanline effects, and channel 3 is used by dmaCopy outside of interrupts.
+ */
+#define VRAM_UPLOAD_DMA_CHANNEL 2
+
+/*
+ * Sets up the vertical blank interrupt that commits each frame.
+ * Called by initVideo.
+ */
+extern void initFramePipeline();
+
+/*
+ * Queues a copy to VRAM that is done when the frame is committed.  Copies
+ * to the same place are merged, so only the latest one is done.  The data
+ * must stay valid until the frame is committed.
+ * @param dest Where to copy to in VRAM.
+ * @param src The data to copy.
+ * @param size The amount of bytes to copy (a multiple of 2).
+ * @return Returns true if the copy was queued, false if the queue was full
+ * and the copy was done right away instead.
+ */
+extern bool queueVramUpload(void* dest, const void* src, u32 size);
+
+/*
+ * Removes any queued copies to a range of VRAM.  Used when the memory is
+ * given back before the frame is committed.
+ * @param dest The start of the range.
+ * @param size The size of the range in bytes.
+ */
+extern void cancelVramUploads(void* dest, u32 size);
+
+/*
+ * Marks the frame as prepared, so that it is committed in the next
+ * vertical blank.
+ */
+extern void submitFrame();
+
+/*
+ * Waits until the submitted frame has been committed.
+ */
+extern void waitForFrameCommit();
+
+/*
+ * Gets the amount of frames that have been committed.
+ * @return Returns the amount of committed frames.
+ */
+extern u32 getFrameCommitCount();
+
+/*
+ * Gets the amount of vertical blanks that happened with no frame ready to
+ * commit (IE: the frame took too long to prepare, or the game was waiting
+ * on its own).
+ * @return Returns the amount of idle vertical blanks.
+ */
+extern u32 getIdleVBlankCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Contains a set of functions for per scanline background effects.  Each
+ * screen keeps a table with the scroll values of its four backgrounds for
+ * every scanline, which is fed to the scroll registers by an HBlank DMA.
+ * This allows parallax, wave and split screen effects without using the
+ * CPU while the screen is being drawn.
+ */
+
+#ifndef _SCANLINE_EFFECTS_H_
+#define _SCANLINE_EFFECTS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+#include "backgrounds.h"
+
+/*
+ * The number of visible scanlines on each screen.
+ */
+#define SCANLINE_COUNT 192
+
+/*
+ * The DMA channel used for the top (main) screen's scroll table.
+ * Channel 3 is left alone since it is used by dmaCopy.
+ */
+#define SCANLINE_DMA_CHANNEL_MAIN 0
+/*
+ * The DMA channel used for the bottom (sub) screen's scroll table.
+ */
+#define SCANLINE_DMA_CHANNEL_SUB 1
+
+/*
+ * The parallax speed that leaves a scanline at the background's
+ * normal scroll value (1.0 in 8 bit fixed point).
+ */
+#define SCANLINE_SPEED_NORMAL 256
+
+/*
+ * Enables the scanline effects for the desired background.  All of its
+ * scanlines start at the background's normal scroll value.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+extern void enableBgScanlineEffects(int screen, int index);
+
+/*
+ * Disables the scanline effects for the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+extern void disableBgScanlineEffects(int screen, int index);
+
+/*
+ * Sets the scroll offset of a single scanline on the desired background.
+ * The offset is added to the background's normal scroll value.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param line The scanline to set (0-191).
+ * @param x The x offset for the scanline.
+ * @param y The y offset for the scanline.
+ */
+extern void setBgScanlineOffset(int screen, int index, int line, s32 x, s32 y);
+
+/*
+ * Sets the scroll offset of a band of scanlines on the desired background.
+ * Can be used for split screen effects.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param firstLine The first scanline of the band.
+ * @param lastLine The last scanline of the band.
+ * @param x The x offset for the band.
+ * @param y The y offset for the band.
+ */
+extern void setBgScanlineBand(int screen, int index, int firstLine, int lastLine, s32 x, s32 y);
+
+/*
+ * Sets the parallax speeds for a band of scanlines on the desired background.
+ * The speed is interpolated from the first line to the last line, and the
+ * background's absolute x position is multiplied by it on each scanline.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param firstLine The first scanline of the band.
+ * @param lastLine The last scanline of the band.
+ * @param startSpeed The speed at the first line (8 bit fixed point, 256 is normal).
+ * @param endSpeed The speed at the last line (8 bit fixed point, 256 is normal).
+ */
+extern void setBgScanlineParallax(int screen, int index, int firstLine, int lastLine,
+		int startSpeed, int endSpeed);
+
+/*
+ * Sets a horizontal wave on the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param amplitude The amplitude of the wave in pixels (0 to turn it off).
+ * @param wavelength The length of one wave in scanlines.
+ * @param speed How far the wave moves each frame (32768 is a full wave).
+ */
+extern void setBgScanlineWave(int screen, int index, int amplitude, int wavelength, int speed);
+
+/*
+ * Builds the scanline tables for the next frame.  Should be called once
+ * per frame before waiting for the vertical blank.
+ */
+extern void updateScanlineEffects();
+
+/*
+ * Swaps in the scanline tables and restarts the HBlank DMAs.  Must be
+ * called during the vertical blank.
+ */
+extern void commitScanlineEffects();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,6 +40,23 @@ extern "C"
 extern void createSprite(int screen, int index, int palSlot, const unsigned int* gfxData,
 		u32 gfxDataSize, const unsigned short* palData, int width, int height);
 
+/*
+ * Creates a sprite that uses data from the asset cache instead of its own
+ * copy.  The sprite releases the data back to the cache when it is deleted.
+ * @param screen The screen to create the sprite on.
+ * @param index The index of the sprite.
+ * @param palSlot The slot for the palette data.
+ * @param gfxData The graphical data, from acquireCachedAsset.
+ * @param gfxDataSize The size of the graphical data.
+ * @param palData The palette data (256 colors), from acquireCachedAsset.
+ * @param width The width of the sprite.
+ * @param height The height of the sprite.
+ * @return Returns true if the sprite was created and now owns the data,
+ * false if the sprite already exists.
+ */
+extern bool createSharedSprite(int screen, int index, int palSlot, const unsigned int* gfxData,
+		u32 gfxDataSize, const unsigned short* palData, int width, int height);
+
 /*
  * Creates a sprite on the screen.
  * @param screen The screen to create the sprite on.
@@ -16,6 +16,17 @@ extern "C"
 #include <stdio.h>
 #include <stdarg.h>
 
+/*
+ * The amount of VRAM used by a text console's map (32x32 tiles).
+ */
+#define TEXT_MAP_VRAM_SIZE 0x800
+
+/*
+ * The amount of VRAM set aside for a text console's font
+ * (256 characters at 8 bits per pixel).
+ */
+#define TEXT_TILE_VRAM_SIZE 0x4000
+
 /*
  * Initializes the text system.
  * @param loadDefaultFonts Indicates whether or not it should
@@ -24,8 +35,10 @@ extern "C"
  * top screen. (Use -1 to not load the top screen's text system)
  * @param bottomScreenLayer The background layer to display the text on on the
  * bottom screen. (Use -1 to not load the bottom screen's text system)
+ * @return Returns true if every console that was asked for was set up,
+ * false if there was not enough VRAM for one of them.
  */
-extern void initTextSystem(bool loadDefaultFonts, int topScreenLayer,
+extern bool initTextSystem(bool loadDefaultFonts, int topScreenLayer,
 		int bottomScreenLayer);
 
 /*
@@ -56,6 +69,65 @@ extern void setText(int screen, int x, int y);
  */
 extern void drawText(int screen, int x, int y, const char* text, ...);
 
+/*
+ * Draws a single character on the screen by writing it straight into the
+ * console's map.
+ * @param screen The screen to draw the character on.
+ * @param x The x position to put the character at.
+ * @param y The y position to put the character at.
+ * @param c The character to draw.
+ */
+extern void drawTextChar(int screen, int x, int y, char c);
+
+/*
+ * Gets the tab size of the desired screen's console.
+ * @param screen The screen to get the tab size of.
+ * @return Returns the amount of characters between tab stops.
+ */
+extern int getTextTabSize(int screen);
+
+/*
+ * Draws a string on the screen by writing its characters straight into the
+ * console's map.  No formatting is done, so each character costs the same.
+ * @param screen The screen to draw the text on.
+ * @param x The x position to put the text at.
+ * @param y The y position to put the text at.
+ * @param text The text to draw.  Supports new lines and tabs.
+ * @return Returns the x position after the last character drawn.
+ */
+extern int drawString(int screen, int x, int y, const char* text);
+
+/*
+ * Draws an integer on the screen without going through printf.
+ * @param screen The screen to draw the number on.
+ * @param x The x position to put the number at.
+ * @param y The y position to put the number at.
+ * @param value The number to draw.
+ * @return Returns the x position after the last digit drawn.
+ */
+extern int drawInt(int screen, int x, int y, int value);
+
+/*
+ * Draws a number in hexadecimal on the screen without going through printf.
+ * @param screen The screen to draw the number on.
+ * @param x The x position to put the number at.
+ * @param y The y position to put the number at.
+ * @param value The number to draw.
+ * @param digits The amount of digits to draw (1-8), padded with zeros.
+ * @return Returns the x position after the last digit drawn.
+ */
+extern int drawHex(int screen, int x, int y, u32 value, int digits);
+
+/*
+ * Clears an area of text on the screen.
+ * @param screen The screen to clear the text on.
+ * @param x The x position of the area.
+ * @param y The y position of the area.
+ * @param width The width of the area (in characters).
+ * @param height The height of the area (in characters).
+ */
+extern void clearTextArea(int screen, int x, int y, int width, int height);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+/*
+ * Contains retained text widgets.  A widget is a label with an optional
+ * integer bound to it, and it remembers what it last put on the screen.  When
+ * the label or the integer changes, only the characters that are different
+ * are written to the console's map, and only during the vertical blank.
+ */
+
+#ifndef _TEXT_WIDGETS_H_
+#define _TEXT_WIDGETS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of widgets on each screen.
+ */
+#define MAX_TEXT_WIDGETS 16
+
+/*
+ * The max amount of characters a widget can show.
+ */
+#define TEXT_WIDGET_LENGTH 32
+
+/*
+ * Creates a text widget on the chosen screen.
+ * @param screen The screen to create the widget on.
+ * @param index The index of the widget.
+ * @param x The x position of the widget (in characters).
+ * @param y The y position of the widget (in characters).
+ * @param label The label of the widget.  Supports tabs.
+ * @param value An integer to show after the label, or NULL for just the label.
+ * The integer must stay around for as long as the widget does.
+ */
+extern void createTextWidget(int screen, int index, int x, int y, const char* label,
+		const int* value);
+
+/*
+ * Deletes the desired text widget, clearing it off of the screen.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ */
+extern void deleteTextWidget(int screen, int index);
+
+/*
+ * Deletes all of the text widgets on a screen.
+ * @param screen The screen to delete the widgets on.
+ */
+extern void deleteTextWidgets(int screen);
+
+/*
+ * Sets the label of the desired text widget.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ * @param label The new label.
+ */
+extern void setTextWidgetLabel(int screen, int index, const char* label);
+
+/*
+ * Shows or hides the desired text widget.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ * @param visible Whether the widget should be shown.
+ */
+extern void setTextWidgetVisible(int screen, int index, bool visible);
+
+/*
+ * Shows or hides all of the text widgets on a screen.
+ * @param screen The screen the widgets are on.
+ * @param visible Whether the widgets should be shown.
+ */
+extern void setTextWidgetsVisible(int screen, bool visible);
+
+/*
+ * Works out which characters of the widgets changed since they were last
+ * drawn.  Called by updateAll before the vertical blank.
+ */
+extern void updateTextWidgets();
+
+/*
+ * Writes the characters that changed to the screens.  Called by the frame
+ * pipeline during the vertical blank.
+ */
+extern void commitTextWidgets();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
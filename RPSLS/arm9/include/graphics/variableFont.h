@@ -0,0 +1,188 @@
+/*
+ * Contains a variable width font renderer.  Fonts are packed into a one bit
+ * per pixel glyph atlas with the width of each glyph when they are loaded,
+ * and strings are drawn into a text area: a background layer whose tiles are
+ * used as a small canvas.  Rendered strings are cached by hash, so drawing
+ * the same label again only costs one lookup and a copy.
+ */
+
+#ifndef _VARIABLE_FONT_H_
+#define _VARIABLE_FONT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The max amount of glyphs in a font.
+ */
+#define MAX_FONT_GLYPHS 256
+
+/*
+ * The height of a glyph in pixels.
+ */
+#define FONT_GLYPH_HEIGHT 8
+
+/*
+ * The width given to glyphs with no pixels (IE: spaces).
+ */
+#define FONT_SPACE_WIDTH 3
+
+/*
+ * The max amount of kerning pairs in a font.
+ */
+#define MAX_FONT_KERNING_PAIRS 128
+
+/*
+ * The max width of a rendered string in pixels.
+ */
+#define FONT_MAX_STRING_WIDTH 256
+
+/*
+ * The amount of rendered strings that are cached.
+ */
+#define FONT_CACHE_SIZE 32
+
+/*
+ * The longest string that can be cached.
+ */
+#define FONT_CACHE_TEXT_LENGTH 48
+
+/*
+ * The palette bank used by the text areas.
+ */
+#define FONT_PALETTE_BANK 15
+
+/*
+ * A structure for a variable width font.
+ * id - A number given to the font when it is loaded, which tells its
+ * rendered strings apart from other fonts' in the cache.
+ * glyphRows - The glyph atlas.  Each glyph is one byte per row, with the
+ * leftmost pixel in the lowest bit.
+ * widths - The width of each glyph in pixels.
+ * firstChar - The character of the first glyph.
+ * glyphCount - The amount of glyphs in the font.
+ * spacing - The amount of pixels between glyphs.
+ * kerningPairs - The kerning pairs (left character << 8 | right character), sorted.
+ * kerningOffsets - The offset in pixels of each kerning pair.
+ * kerningCount - The amount of kerning pairs.
+ */
+typedef struct font_t
+{
+	u32 id;
+	u8 glyphRows[MAX_FONT_GLYPHS][FONT_GLYPH_HEIGHT];
+	u8 widths[MAX_FONT_GLYPHS];
+	u8 firstChar;
+	int glyphCount;
+	int spacing;
+	u16 kerningPairs[MAX_FONT_KERNING_PAIRS];
+	s8 kerningOffsets[MAX_FONT_KERNING_PAIRS];
+	int kerningCount;
+} font_t;
+
+/*
+ * Loads a font from 8x8 4bpp tiles (the same format used by setFont).
+ * Each glyph is packed into the font's atlas and has its width measured.
+ * @param font The font to load into.
+ * @param tiles The tiles of the font.
+ * @param firstChar The character of the first tile.
+ * @param glyphCount The amount of tiles.
+ * @param spacing The amount of pixels between glyphs.
+ */
+extern void loadFont(font_t* font, const unsigned int* tiles, int firstChar, int glyphCount,
+		int spacing);
+
+/*
+ * Adds a kerning pair to a font.
+ * @param font The font to add the pair to.
+ * @param left The character on the left.
+ * @param right The character on the right.
+ * @param offset The amount of pixels to move the right character by.
+ * @return Returns true if the pair was added, false if there is no room left.
+ */
+extern bool addFontKerning(font_t* font, char left, char right, int offset);
+
+/*
+ * Gets the kerning between two characters.
+ * @param font The font to check.
+ * @param left The character on the left.
+ * @param right The character on the right.
+ * @return Returns the amount of pixels to move the right character by.
+ */
+extern int getFontKerning(const font_t* font, char left, char right);
+
+/*
+ * Gets the width of a string in pixels.
+ * @param font The font to measure with.
+ * @param text The string to measure.
+ * @return Returns the width of the string.
+ */
+extern int getFontStringWidth(const font_t* font, const char* text);
+
+/*
+ * Creates a text area on the chosen screen.  The area takes up a whole
+ * background layer, and gets its own tiles so that it can be drawn to
+ * pixel by pixel.
+ * @param screen The screen to create the area on.
+ * @param layer The background layer to use.
+ * @param x The x position of the area (in tiles).
+ * @param y The y position of the area (in tiles).
+ * @param width The width of the area (in tiles).
+ * @param height The height of the area (in tiles).
+ * @return Returns true if the area was created, false if there was no room.
+ */
+extern bool createFontArea(int screen, int layer, int x, int y, int width, int height);
+
+/*
+ * Deletes the text area on the chosen screen.
+ * @param screen The screen to delete the area on.
+ */
+extern void deleteFontArea(int screen);
+
+/*
+ * Sets the color of the text in the text area.
+ * @param screen The screen of the area.
+ * @param color The color of the text.
+ */
+extern void setFontAreaColor(int screen, u16 color);
+
+/*
+ * Clears part of the text area.
+ * @param screen The screen of the area.
+ * @param x The x position to clear (in pixels).
+ * @param y The y position to clear (in pixels).
+ * @param width The width to clear (in pixels).
+ * @param height The height to clear (in pixels).
+ */
+extern void clearFontRect(int screen, int x, int y, int width, int height);
+
+/*
+ * Clears the whole text area.
+ * @param screen The screen of the area.
+ */
+extern void clearFontArea(int screen);
+
+/*
+ * Draws a string into the text area.
+ * @param screen The screen of the area.
+ * @param font The font to draw with.
+ * @param x The x position of the string in the area (in pixels).
+ * @param y The y position of the string in the area (in pixels).
+ * @param text The string to draw.
+ * @return Returns the width of the string in pixels.
+ */
+extern int drawFontString(int screen, const font_t* font, int x, int y, const char* text);
+
+/*
+ * Empties the rendered string cache.  Called when a font changes.
+ */
+extern void clearFontCache();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 #include <nds.h>
+#include "vramPlanner.h"
 
 /*
  *  A boolean value that represents whether the screens
@@ -26,12 +27,33 @@ extern bool screensFlipped;
  */
 extern void initVideo();
 
+/*
+ *  Initializes the video for the Nintendo DS with the desired VRAM layout.
+ *  Sets up the screens to use backgrounds and sprites with the
+ *  2D engine.
+ *  @param layout The layout of the VRAM banks.
+ *  @return Returns true if the layout was used, false if it was not valid
+ *  and the default layout was used instead.
+ */
+extern bool initVideoLayout(const vramLayout_t* layout);
+
 /*
  *  This function switches the sub screen and the main screen.
  *  Can be used for using 3D on the sub screen.
  */
 extern void switchScreens();
 
+/*
+ *  Starts a task that fades the screens' brightness, one step per frame.
+ *  @param screen The screens to fade (1 - main, 2 - sub, 3 - both).
+ *  @param from The brightness to start at (-16 is black, 16 is white).
+ *  @param to The brightness to end at.
+ *  @param speed The amount the brightness changes each frame.
+ *  @return Returns the ID of the fade's task, or -1 if it couldn't be
+ *  started (in which case the brightness is set to the end value).
+ */
+extern int startBrightnessFade(int screen, int from, int to, int speed);
+
 #ifdef __cplusplus
 }
 #endif
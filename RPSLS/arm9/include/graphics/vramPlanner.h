@@ -0,0 +1,221 @@
+/*
+ * Contains a planner for the Nintendo DS's VRAM banks.  The banks are set up
+ * from a layout that says what each bank is used for, and background map and
+ * tile memory is then handed out from the banks without overlapping.  The
+ * amount of memory used in each bank can be checked at any time.
+ */
+
+#ifndef _VRAM_PLANNER_H_
+#define _VRAM_PLANNER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <nds.h>
+
+/*
+ * The number of VRAM banks (A-I).
+ */
+#define VRAM_BANK_COUNT 9
+
+/*
+ * The size of the blocks that background memory is handed out in.
+ * This is the size of one map base.
+ */
+#define VRAM_BLOCK_SIZE 0x800
+
+/*
+ * The number of blocks that can be reached by a background on each
+ * screen (16 tile bases of 16KB).
+ */
+#define VRAM_BG_BLOCKS 128
+
+/*
+ * The size of one extended background palette slot.
+ */
+#define VRAM_BG_EXT_PALETTE_SIZE 0x2000
+
+/*
+ * The size of one extended sprite palette slot.
+ */
+#define VRAM_SPRITE_EXT_PALETTE_SIZE 0x200
+
+/*
+ * The VRAM banks.
+ */
+typedef enum
+{
+	VRAM_BANK_A = 0,
+	VRAM_BANK_B = 1,
+	VRAM_BANK_C = 2,
+	VRAM_BANK_D = 3,
+	VRAM_BANK_E = 4,
+	VRAM_BANK_F = 5,
+	VRAM_BANK_G = 6,
+	VRAM_BANK_H = 7,
+	VRAM_BANK_I = 8
+} vramBank_t;
+
+/*
+ * What a VRAM bank can be used for.  Not every bank supports every use:
+ * A, B - Main BG, main sprites.
+ * C - Main BG, sub BG.
+ * D - Main BG, sub sprites.
+ * E - Main sprites, main BG extended palettes.
+ * F, G - Main sprite extended palettes.
+ * H - Sub BG, sub BG extended palettes.
+ * I - Sub BG, sub sprites, sub sprite extended palettes.
+ * Every bank can be left unused or mapped to the LCD.
+ */
+typedef enum
+{
+	VRAM_USE_NONE = 0,
+	VRAM_USE_LCD = 1,
+	VRAM_USE_MAIN_BG = 2,
+	VRAM_USE_MAIN_SPRITE = 3,
+	VRAM_USE_MAIN_BG_EXT_PALETTE = 4,
+	VRAM_USE_MAIN_SPRITE_EXT_PALETTE = 5,
+	VRAM_USE_SUB_BG = 6,
+	VRAM_USE_SUB_SPRITE = 7,
+	VRAM_USE_SUB_BG_EXT_PALETTE = 8,
+	VRAM_USE_SUB_SPRITE_EXT_PALETTE = 9
+} vramUse_t;
+
+/*
+ * A structure describing what each VRAM bank is used for.
+ * banks - The use of each bank, indexed by vramBank_t.
+ */
+typedef struct vramLayout_t
+{
+	vramUse_t banks[VRAM_BANK_COUNT];
+} vramLayout_t;
+
+/*
+ * The layout used by initVideo.
+ */
+extern const vramLayout_t defaultVramLayout;
+
+/*
+ * Sets up the VRAM banks with the desired layout.  All of the background
+ * memory that was handed out is forgotten.
+ * @param layout The layout to use.
+ * @return Returns true if the layout was applied, false if it is not valid
+ * (IE: a bank was given a use it doesn't support, or two banks overlap).
+ */
+extern bool applyVramLayout(const vramLayout_t* layout);
+
+/*
+ * Gets the layout that is currently in use.
+ * @return Returns the current layout.
+ */
+extern const vramLayout_t* getVramLayout();
+
+/*
+ * Hands out memory for a background's map and tiles.
+ * @param screen The screen the background is on.
+ * @param mapSize The size of the map in bytes.
+ * @param tileSize The size of the tiles in bytes.
+ * @param mapBase Set to the map base to use.
+ * @param tileBase Set to the tile base to use.
+ * @return Returns true if there was enough room, false otherwise.
+ */
+extern bool allocBgVram(int screen, u32 mapSize, u32 tileSize, int* mapBase, int* tileBase);
+
+/*
+ * Gives back memory handed out by allocBgVram.
+ * @param screen The screen the background is on.
+ * @param mapBase The map base that was handed out.
+ * @param mapSize The size of the map in bytes.
+ * @param tileBase The tile base that was handed out.
+ * @param tileSize The size of the tiles in bytes.
+ */
+extern void freeBgVram(int screen, int mapBase, u32 mapSize, int tileBase, u32 tileSize);
+
+/*
+ * Keeps track of sprite graphics memory allocated on a screen.
+ * @param screen The screen the sprite graphics are on.
+ * @param size The amount of bytes allocated (negative when freed).
+ */
+extern void trackSpriteVram(int screen, s32 size);
+
+/*
+ * Gets the size of a VRAM bank.
+ * @param bank The bank to get the size of.
+ * @return Returns the size of the bank in bytes.
+ */
+extern u32 getVramBankSize(vramBank_t bank);
+
+/*
+ * Gets the amount of memory used in a VRAM bank.
+ * @param bank The bank to check.
+ * @return Returns the amount of bytes used.
+ */
+extern u32 getVramBankUsed(vramBank_t bank);
+
+/*
+ * Gets the amount of background memory available on a screen.
+ * @param screen The screen to check.
+ * @return Returns the size in bytes that backgrounds can use.
+ */
+extern u32 getBgVramSize(int screen);
+
+/*
+ * Gets the amount of background memory used on a screen.
+ * @param screen The screen to check.
+ * @return Returns the amount of bytes used by backgrounds.
+ */
+extern u32 getBgVramUsed(int screen);
+
+/*
+ * Maps the desired screen's extended background palette bank to the LCD
+ * so that it can be written to.
+ * @param screen The screen to write the palettes of.
+ */
+extern void beginBgExtPaletteWrite(int screen);
+
+/*
+ * Maps the desired screen's extended background palette bank back to its use.
+ * @param screen The screen the palettes were written for.
+ */
+extern void endBgExtPaletteWrite(int screen);
+
+/*
+ * Gets where an extended background palette slot is while its bank is
+ * mapped to the LCD.  Only valid between beginBgExtPaletteWrite and
+ * endBgExtPaletteWrite.
+ * @param screen The screen to get the palette for.
+ * @param slot The slot of the palette (the background layer).
+ * @return Returns a pointer to the palette, or NULL if the screen has none.
+ */
+extern u16* getBgExtPalette(int screen, int slot);
+
+/*
+ * Maps the desired screen's extended sprite palette bank to the LCD
+ * so that it can be written to.
+ * @param screen The screen to write the palettes of.
+ */
+extern void beginSpriteExtPaletteWrite(int screen);
+
+/*
+ * Maps the desired screen's extended sprite palette bank back to its use.
+ * @param screen The screen the palettes were written for.
+ */
+extern void endSpriteExtPaletteWrite(int screen);
+
+/*
+ * Gets where an extended sprite palette slot is while its bank is
+ * mapped to the LCD.  Only valid between beginSpriteExtPaletteWrite and
+ * endSpriteExtPaletteWrite.
+ * @param screen The screen to get the palette for.
+ * @param slot The slot of the palette.
+ * @return Returns a pointer to the palette, or NULL if the screen has none.
+ */
+extern u16* getSpriteExtPalette(int screen, int slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
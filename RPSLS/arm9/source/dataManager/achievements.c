@@ -4,251 +4,265 @@
  * can be read by the an application that makes use of this.
  * Each Achievement contains a point value, which can be used for
  * various DLC (Downloadable Content) in other games, or whatever else.
+ * The user's achievements are loaded into memory once, and new ones are
+ * written out together when the game flushes them.
  * Created by: Gerald McAlister
  */
 
 #include "GEM_functions.h"
 
 /*
- * Adds an achievement to the user's save profile.
- * @param pointValue The point value of how many points
- * the achievement is worth.
- * @param gameID The identification for the game.  Should be
- * 8 characters long.
- * @param achievementTitle The title of the achievement.
+ * The user's achievements, in the order they were unlocked.
  */
-void addAchievement(int pointValue, const char* gameID,
-		const char* achievementTitle)
+achievement_t achievementStore[MAX_ACHIEVEMENTS];
+
+/*
+ * The amount of achievements in the store.
+ */
+int achievementCount = 0;
+
+/*
+ * The amount of achievements at the start of the store that are saved.
+ * The ones after it make up the journal of achievements to write.
+ */
+int savedAchievementCount = 0;
+
+/*
+ * One bit for each achievement ID, set if it is unlocked.
+ */
+u32 unlockedAchievements[(MAX_ACHIEVEMENTS + 31) / 32];
+
+/*
+ * Tells whether the achievements have been loaded.
+ */
+bool achievementsLoaded = false;
+
+/*
+ * The user the achievements were loaded for.
+ */
+char achievementUser[11];
+
+/*
+ * Gets the path of a user's achievement file.
+ * @param user The name of the user.
+ * @param fileName Set to the file's path.
+ * @param size The size of the path.
+ * @return Returns true if there is somewhere to save achievements.
+ */
+static bool getAchievementFileName(const char* user, char* fileName, int size)
 {
-	/*
-	 * A temporary holding spot for a file name.
-	 */
-	char fileName[65];
-	/*
-	 * Copies the current user name to the first part of the file name.
-	 */
-	strncpy(fileName, currentUser->name, 10);
-	/*
-	 * Copies the achievement extension (.ach) to the end of the file name.
-	 */
-	strncat(fileName, ".ach", 4);
-	/*
-	 * Makes the end of the file name null terminated.
-	 */
-	fileName[strlen(currentUser->name) + 4] = '\0';
+	char name[16];
+
+	snprintf(name, sizeof(name), "%.10s.ach", user);
+	return getSavePath(name, fileName, size);
+}
+
+/*
+ * Marks an achievement ID as unlocked.
+ * @param id The ID of the achievement.
+ */
+static void setAchievementUnlocked(int id)
+{
+	if(id >= 0 && id < MAX_ACHIEVEMENTS)
+	{
+		unlockedAchievements[id >> 5] |= BIT(id & 31);
+	}
+}
+
+/*
+ * Loads the current user's achievements into memory.  Only the first call
+ * (or the first after the user changes) reads the save file.  It is called
+ * at startup, so that the other achievement functions only use memory.
+ * @return Returns true if the achievements are loaded.
+ */
+bool loadAchievements()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	char tempName[MAX_SAVE_TEMP_PATH_LENGTH];
+	fileBuffer_t file;
+	char user[11];
 
 	/*
-	 * Changes the directory to the data directory and checks
-	 * to make sure it changed correctly.
+	 * Nothing is read again unless the user changed.
 	 */
-	if (chdir("data") != 0)
+	getCurrentUserName(user, sizeof(user));
+	if(achievementsLoaded && strcmp(achievementUser, user) == 0)
 	{
-		/*
-		 * If it did not change correctly, then
-		 * the data folder is created.
-		 */
-		mkdir("data", 0777);
-
-		/*
-		 * Then it is switched to again.
-		 */
-		chdir("data");
+		return true;
 	}
 
 	/*
-	 * Changes the directory to the game's data directory and checks
-	 * to make sure it changed correctly.
+	 * Any achievements that weren't saved for the last user are saved
+	 * before they are forgotten.
 	 */
-	if (chdir(GAME_TITLE) != 0)
+	if(achievementsLoaded)
 	{
-		/*
-		 * If it did not change correctly, then
-		 * the game's data folder is created.
-		 */
-		mkdir(GAME_TITLE, 0777);
-
-		/*
-		 * Then it is switched to again.
-		 */
-		chdir(GAME_TITLE);
+		flushAchievements();
 	}
 
+	achievementCount = 0;
+	savedAchievementCount = 0;
+	memset(unlockedAchievements, 0, sizeof(unlockedAchievements));
+	strcpy(achievementUser, user);
+	achievementsLoaded = true;
+
 	/*
-	 * The file is then opened for appending in binary mode.
+	 * Without a save folder, the achievements are only kept in memory.
 	 */
-	FILE* file = fopen(fileName, "a+b");
+	if(!getAchievementFileName(achievementUser, fileName, sizeof(fileName)))
+	{
+		return true;
+	}
 
 	/*
-	 * Checks if the file was opened correctly.
+	 * Any queued saves are written first so the file is up to date.
+	 * A missing file just means nothing has been unlocked yet.
 	 */
-	if (file != NULL)
+	flushSaveQueue();
+	if(openFileBuffer(fileName, &file, 0) == 0)
 	{
+		closeBuffer(&file);
+
 		/*
-		 * Then, a temporary achievement is created.
-		 */
-		achievement_t* achievement = (achievement_t*) NULL;
-		/*
-		 * Then, variable i is created and set to 0.
-		 */
-		int i = 0;
-		/*
-		 * Then, i is incremented by 1 as long as
-		 * i is < 8.
-		 */
-		for (i = 0; i < 8; i += 1)
-		{
-			/*
-			 * Each time, a character from the game's id is set.
-			 */
-			achievement->gameID[i] = gameID[i];
-		}
-		/*
-		 * Then, i is incremented by 1 as long as it is less then the max length
-		 * of a achievement title.
+		 * If the power went while the file was being replaced, the
+		 * temporary file it was written to is loaded instead.
 		 */
-		for (i = 0; i < MAX_ACHIEVEMENT_TITLE_LENGTH && i < strlen(
-				achievementTitle); i += 1)
+		if(!getTempSavePath(fileName, tempName, sizeof(tempName)) || openFileBuffer(tempName, &file, 0) == 0)
 		{
-			/*
-			 * Each time, a character from the achievement title is set.
-			 */
-			achievement->achievementTitle[i] = achievementTitle[i];
+			closeBuffer(&file);
+			return true;
 		}
-		/*
-		 * The point value is then set.
-		 */
-		achievement->pointValue = pointValue;
-		/*
-		 * After that, the current day of the month as the unlocked date.
-		 */
-		achievement->unlockedDate.day = getTimeDayOfMonth();
-		/*
-		 * Then, the current month as the unlocked date.
-		 */
-		achievement->unlockedDate.month = getTimeMonth();
-		/*
-		 * Finally, the year that it was unlocked (aka: the current year) is set.
-		 */
-		achievement->unlockedDate.year = getTimeYear();
+	}
 
-		/*
-		 * Then, the end of the file is gone to.
-		 */
-		fseek(file, 0, SEEK_END);
-		/*
-		 * Then the achievement is written to the file.
-		 */
-		fwrite(achievement, 1, sizeof(achievement_t), file);
-		/*
-		 * After words, the file is closed.
-		 */
-		fclose(file);
+	while(achievementCount < MAX_ACHIEVEMENTS
+			&& readFileBufferNext(&file, &achievementStore[achievementCount], sizeof(achievement_t)) == sizeof(achievement_t))
+	{
+		achievementStore[achievementCount].achievementTitle[MAX_ACHIEVEMENT_TITLE_LENGTH - 1] = '\0';
+		setAchievementUnlocked(achievementStore[achievementCount].id);
+		achievementCount += 1;
 	}
-	/*
-	 * Finally, the directory is changed back to the root directory.
-	 */
-	chdir("../../");
+	savedAchievementCount = achievementCount;
+
+	closeBuffer(&file);
+	return true;
 }
 
 /*
- * Gets an achievement based on it's index (they are sorted by date.
- * @param index The index of the achievement.
- * @return The achievement as a structure.
+ * Unlocks an achievement for the current user.  The achievement is only
+ * kept in memory until flushAchievements is called, so this never touches
+ * the SD card.  loadAchievements must have been called first, or the
+ * achievement is only kept until the game is turned off.
+ * @param id The game's ID for the achievement (0 to MAX_ACHIEVEMENTS - 1).
+ * @param pointValue The point value of how many points
+ * the achievement is worth.
+ * @param gameID The identification for the game.  Should be
+ * 8 characters long.
+ * @param achievementTitle The title of the achievement.
+ * @return Returns true if the achievement was just unlocked, false if it
+ * already was (or the ID is not valid).
  */
-achievement_t getAchievementFromIndex(int index)
+bool unlockAchievement(int id, int pointValue, const char* gameID,
+		const char* achievementTitle)
 {
-	/*
-	 * A temporary holding spot for a file name.
-	 */
-	char fileName[65];
-	/*
-	 * Copies the current user name to the first part of the file name.
-	 */
-	strncpy(fileName, currentUser->name, 10);
-	/*
-	 * Copies the achievement extension (.ach) to the end of the file name.
-	 */
-	strncat(fileName, ".ach", 4);
-	/*
-	 * Makes the end of the file name null terminated.
-	 */
-	fileName[strlen(currentUser->name) + 4] = '\0';
-
-	/*
-	 * Changes the directory to the data directory and checks
-	 * to make sure it changed correctly.
-	 */
-	if (chdir("data") != 0)
+	if(id < 0 || id >= MAX_ACHIEVEMENTS || isAchievementUnlocked(id) || achievementCount >= MAX_ACHIEVEMENTS)
 	{
-		/*
-		 * If it did not change correctly, then
-		 * the data folder is created.
-		 */
-		mkdir("data", 0777);
-
-		/*
-		 * Then it is switched to again.
-		 */
-		chdir("data");
+		return false;
 	}
 
 	/*
-	 * Changes the directory to the game's data directory and checks
-	 * to make sure it changed correctly.
+	 * The achievement is added to the end of the store, which makes
+	 * it part of the journal until it is flushed.
 	 */
-	if (chdir(GAME_TITLE) != 0)
-	{
-		/*
-		 * If it did not change correctly, then
-		 * the game's data folder is created.
-		 */
-		mkdir(GAME_TITLE, 0777);
+	achievement_t* achievement = &achievementStore[achievementCount];
+	memset(achievement, 0, sizeof(achievement_t));
 
-		/*
-		 * Then it is switched to again.
-		 */
-		chdir(GAME_TITLE);
+	achievement->id = id;
+	achievement->pointValue = pointValue;
+	strncpy(achievement->gameID, gameID, sizeof(achievement->gameID));
+	strncpy(achievement->achievementTitle, achievementTitle, MAX_ACHIEVEMENT_TITLE_LENGTH - 1);
+	achievement->unlockedDate.day = getTimeDayOfMonth();
+	achievement->unlockedDate.month = getTimeMonth();
+	achievement->unlockedDate.year = getTimeYear();
+
+	setAchievementUnlocked(id);
+	achievementCount += 1;
+	return true;
+}
+
+/*
+ * Checks if an achievement is unlocked.
+ * @param id The game's ID for the achievement.
+ * @return Returns true if it is unlocked, false otherwise.
+ */
+bool isAchievementUnlocked(int id)
+{
+	if(id < 0 || id >= MAX_ACHIEVEMENTS)
+	{
+		return false;
 	}
 
-	/*
-	 * Then, the file with the chosen name is opened in reading binary mode.
-	 */
-	FILE* file = fopen(fileName, "rb");
+	return (unlockedAchievements[id >> 5] & BIT(id & 31)) != 0;
+}
 
-	/*
-	 * Then, a temporary achievement is created.
-	 */
-	achievement_t* achievement = (achievement_t*) NULL;
+/*
+ * Gets the amount of unlocked achievements.
+ * @return Returns the amount of achievements.
+ */
+int getAchievementCount()
+{
+	return achievementCount;
+}
 
-	/*
-	 * Checks if the file was opened correctly.
-	 */
-	if (file != NULL)
+/*
+ * Gets an achievement based on it's index (they are sorted by date.
+ * @param index The index of the achievement.
+ * @return The achievement as a structure, or an empty achievement with an
+ * ID of -1 if the index is not valid.
+ */
+achievement_t getAchievementFromIndex(int index)
+{
+	achievement_t achievement;
+
+	if(index < 0 || index >= achievementCount)
 	{
-		/*
-		 * If it was, then the index of the achievement is gotten to.
-		 */
-		fseek(file, index * sizeof(achievement_t), SEEK_CUR);
+		memset(&achievement, 0, sizeof(achievement_t));
+		achievement.id = -1;
+		return achievement;
+	}
 
-		/*
-		 * Then, the achievement is read to the temporary achievement.
-		 */
-		fread(achievement, 1, sizeof(achievement_t), file);
+	return achievementStore[index];
+}
 
-		/*
-		 * Afterwards, the file is closed.
-		 */
-		fclose(file);
+/*
+ * Checks if there are unlocked achievements that haven't been saved yet.
+ * @return Returns true if there are, false otherwise.
+ */
+bool hasUnsavedAchievements()
+{
+	return achievementsLoaded && savedAchievementCount < achievementCount;
+}
+
+/*
+ * Queues the achievements unlocked since the last flush to be added to the
+ * save file, all as one save.  The save queue then writes them over the
+ * next few frames.
+ * @return Returns true if there was anything to save.
+ */
+bool flushAchievements()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+
+	if(!hasUnsavedAchievements() || !getAchievementFileName(achievementUser, fileName, sizeof(fileName)))
+	{
+		return false;
 	}
 
 	/*
-	 * Then, the directory is changed to the root directory.
+	 * The whole journal is queued as one save.
 	 */
-	chdir("../../");
+	queueSave(fileName, &achievementStore[savedAchievementCount],
+			(achievementCount - savedAchievementCount) * sizeof(achievement_t), true);
+	savedAchievementCount = achievementCount;
 
-	/*
-	 * Finally, the achievement is returned.
-	 */
-	return *achievement;
+	return true;
 }
-
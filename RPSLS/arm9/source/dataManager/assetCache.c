@@ -0,0 +1,265 @@
+/*
+ * A cache that keeps loaded assets in memory, so that assets which are used
+ * over and over (IE: the sprites made for each match) are only loaded once.
+ * Assets that are in use are reference counted, and the least recently used
+ * assets that aren't are freed when the cache goes over its memory budget.
+ */
+#include "assetCache.h"
+
+/*
+ * An asset in the cache.
+ * name - The name of the asset.
+ * part - The part of the asset.
+ * data - The asset's data, or NULL if the entry is empty.
+ * size - The size of the asset's data.
+ * references - The amount of users of the asset.
+ * lastUse - When the asset was last acquired.
+ */
+typedef struct cachedAsset_t
+{
+	char name[MAX_CACHED_ASSET_NAME];
+	assetPart_t part;
+	void* data;
+	u32 size;
+	int references;
+	u32 lastUse;
+} cachedAsset_t;
+
+/*
+ * The assets in the cache.
+ */
+cachedAsset_t cachedAssets[MAX_CACHED_ASSETS];
+
+/*
+ * The amount of memory the cache can use, and is using.
+ */
+u32 assetCacheBudget = DEFAULT_ASSET_CACHE_BUDGET;
+u32 assetCacheUsage = 0;
+
+/*
+ * Counts up each time an asset is acquired, for working out which asset
+ * was used least recently.
+ */
+u32 assetCacheClock = 0;
+
+/*
+ * The amount of cache hits and misses.
+ */
+u32 assetCacheHits = 0;
+u32 assetCacheMisses = 0;
+
+/*
+ * Frees an asset in the cache.
+ * @param asset The asset to free.
+ */
+static void freeCachedAsset(cachedAsset_t* asset)
+{
+	free(asset->data);
+	asset->data = NULL;
+	assetCacheUsage -= asset->size;
+	asset->size = 0;
+}
+
+/*
+ * Frees the least recently used asset that isn't in use.
+ * @return Returns true if an asset was freed, false if they are all in use.
+ */
+static bool evictCachedAsset()
+{
+	cachedAsset_t* oldest = NULL;
+	int i = 0;
+
+	for(i = 0;i < MAX_CACHED_ASSETS;i += 1)
+	{
+		if(cachedAssets[i].data != NULL && cachedAssets[i].references == 0
+				&& (oldest == NULL || cachedAssets[i].lastUse < oldest->lastUse))
+		{
+			oldest = &cachedAssets[i];
+		}
+	}
+
+	if(oldest == NULL)
+	{
+		return false;
+	}
+
+	freeCachedAsset(oldest);
+	return true;
+}
+
+/*
+ * Gets part of an asset from the cache, loading it if it isn't there.
+ * Each call must be matched by a call to releaseCachedAsset.  Palettes
+ * are always given as a full 256 colors.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to get.
+ * @param size Set to the size of the asset's data.
+ * @return Returns the asset's data, or NULL if it couldn't be loaded or
+ * the cache is full of assets in use.
+ */
+const void* acquireCachedAsset(const char* name, assetPart_t part, u32* size)
+{
+	cachedAsset_t* empty = NULL;
+	u32 assetSize = 0;
+	u32 allocSize = 0;
+	int i = 0;
+
+	*size = 0;
+	if(strlen(name) >= MAX_CACHED_ASSET_NAME)
+	{
+		return NULL;
+	}
+
+	/*
+	 * Looks for the asset in the cache first.
+	 */
+	for(i = 0;i < MAX_CACHED_ASSETS;i += 1)
+	{
+		if(cachedAssets[i].data == NULL)
+		{
+			if(empty == NULL)
+			{
+				empty = &cachedAssets[i];
+			}
+		}
+		else if(cachedAssets[i].part == part && strcmp(cachedAssets[i].name, name) == 0)
+		{
+			assetCacheHits += 1;
+			cachedAssets[i].references += 1;
+			cachedAssets[i].lastUse = ++assetCacheClock;
+			*size = cachedAssets[i].size;
+			return cachedAssets[i].data;
+		}
+	}
+
+	assetCacheMisses += 1;
+
+	/*
+	 * Otherwise it is loaded.  Palettes are given the same room as a
+	 * sprite's own palette buffer, since sprites always use a whole one.
+	 */
+	assetSize = getAssetSize(name, part);
+	allocSize = (part == ASSET_PALETTE && assetSize < 512 * sizeof(u16)) ? 512 * sizeof(u16) : assetSize;
+	if(assetSize == 0)
+	{
+		return NULL;
+	}
+
+	/*
+	 * Room is made for the asset by freeing the least recently used
+	 * assets that aren't in use.  If they are all in use, the cache is
+	 * allowed to go over its budget rather than fail.
+	 */
+	while(assetCacheUsage + allocSize > assetCacheBudget && evictCachedAsset())
+	{
+	}
+	if(empty == NULL)
+	{
+		if(!evictCachedAsset())
+		{
+			return NULL;
+		}
+		for(empty = cachedAssets; empty->data != NULL; empty += 1)
+		{
+		}
+	}
+
+	empty->data = calloc(allocSize, 1);
+	if(empty->data == NULL)
+	{
+		return NULL;
+	}
+
+	/*
+	 * A failed or short read is never cached, so it can be tried again.
+	 */
+	if(streamAsset(name, part, empty->data, assetSize, false) != assetSize)
+	{
+		free(empty->data);
+		empty->data = NULL;
+		return NULL;
+	}
+
+	strcpy(empty->name, name);
+	empty->part = part;
+	empty->size = allocSize;
+	empty->references = 1;
+	empty->lastUse = ++assetCacheClock;
+	assetCacheUsage += allocSize;
+
+	*size = allocSize;
+	return empty->data;
+}
+
+/*
+ * Tells the cache that an asset from acquireCachedAsset is no longer used.
+ * It stays in the cache until it is pushed out by other assets.
+ * @param data The asset's data.
+ */
+void releaseCachedAsset(const void* data)
+{
+	int i = 0;
+
+	for(i = 0;i < MAX_CACHED_ASSETS;i += 1)
+	{
+		if(cachedAssets[i].data == data && data != NULL)
+		{
+			if(cachedAssets[i].references > 0)
+			{
+				cachedAssets[i].references -= 1;
+			}
+			return;
+		}
+	}
+}
+
+/*
+ * Sets how much memory the cache can use.  Assets that aren't in use are
+ * freed straight away if the cache is over the new budget.
+ * @param bytes The budget in bytes.
+ */
+void setAssetCacheBudget(u32 bytes)
+{
+	assetCacheBudget = bytes;
+
+	while(assetCacheUsage > assetCacheBudget && evictCachedAsset())
+	{
+	}
+}
+
+/*
+ * Frees every asset in the cache that isn't in use.
+ */
+void clearAssetCache()
+{
+	while(evictCachedAsset())
+	{
+	}
+}
+
+/*
+ * Gets the amount of memory the cache is using.
+ * @return Returns the amount in bytes.
+ */
+u32 getAssetCacheUsage()
+{
+	return assetCacheUsage;
+}
+
+/*
+ * Gets the amount of times an asset was found in the cache.
+ * @return Returns the amount of hits.
+ */
+u32 getAssetCacheHits()
+{
+	return assetCacheHits;
+}
+
+/*
+ * Gets the amount of times an asset had to be loaded.
+ * @return Returns the amount of misses.
+ */
+u32 getAssetCacheMisses()
+{
+	return assetCacheMisses;
+}
@@ -0,0 +1,507 @@
+/*
+ * A system for loading graphics from NitroFS instead of compiling them into
+ * the game.  Assets are read in fixed size chunks through a small reusable
+ * buffer, and are streamed straight into VRAM where possible, so they only
+ * take up main memory while they are in use.  The graphics are packed into
+ * one asset pack (made by tools/packAssets.c) with a hashed table of
+ * contents, so finding an asset is a single lookup rather than a NitroFS
+ * directory search.
+ */
+#include "assets.h"
+#include "backgrounds.h"
+#include "sprites.h"
+#include "assetCache.h"
+
+#include <stdio.h>
+#include <filesystem.h>
+
+/*
+ * The file extensions grit uses for each part of an asset.
+ */
+const char* assetExtensions[3] = {".img.bin", ".map.bin", ".pal.bin"};
+
+/*
+ * The reusable buffer that chunks are read into before being
+ * copied to VRAM.
+ */
+u8 assetBuffer[ASSET_CHUNK_SIZE] ALIGN(32);
+
+/*
+ * A buffer for palettes, which are always 256 colors.
+ */
+u16 assetPalette[256] ALIGN(32);
+
+/*
+ * The asset pack, which is kept open while the game runs.
+ */
+FILE* assetPack = NULL;
+
+/*
+ * The asset pack's table of contents.  The amount of entries is a power
+ * of two, and each asset is in the first free entry from its hash.
+ */
+assetPackEntry_t* assetPackEntries = NULL;
+
+/*
+ * The amount of entries in the table of contents.
+ */
+u32 assetPackEntryCount = 0;
+
+/*
+ * Works out the FNV-1a hash of part of an asset's file name.  This must
+ * match the hash in tools/packAssets.c.
+ * @param hash The hash of the name before this (2166136261 to start).
+ * @param text The text to add to the hash.
+ * @return Returns the hash.
+ */
+static u32 hashAssetName(u32 hash, const char* text)
+{
+	while(*text != '\0')
+	{
+		hash = (hash ^ (u8)*text) * 16777619u;
+		text += 1;
+	}
+
+	return hash;
+}
+
+/*
+ * Opens the asset pack and reads its table of contents.
+ * @return Returns true if the pack was opened.
+ */
+static bool openAssetPack()
+{
+	u32 header[4];
+
+	assetPack = fopen(ASSET_PACK, "rb");
+	if(assetPack == NULL)
+	{
+		return false;
+	}
+
+	/*
+	 * The header holds the magic number, the version, and the amount
+	 * of entries in the table of contents.
+	 */
+	if(fread(header, sizeof(u32), 4, assetPack) == 4 && header[0] == ASSET_PACK_MAGIC
+			&& (header[1] & 0xFFFF) == ASSET_PACK_VERSION
+			&& header[2] != 0 && (header[2] & (header[2] - 1)) == 0)
+	{
+		assetPackEntries = (assetPackEntry_t*)malloc(header[2] * sizeof(assetPackEntry_t));
+		if(assetPackEntries != NULL
+				&& fread(assetPackEntries, sizeof(assetPackEntry_t), header[2], assetPack) == header[2])
+		{
+			assetPackEntryCount = header[2];
+			return true;
+		}
+	}
+
+	free(assetPackEntries);
+	assetPackEntries = NULL;
+	fclose(assetPack);
+	assetPack = NULL;
+	return false;
+}
+
+/*
+ * Initializes the asset system (and NitroFS), and opens the asset pack.
+ * @return Returns true if NitroFS could be opened, false otherwise.
+ */
+bool initAssets()
+{
+	if(!nitroFSInit(NULL))
+	{
+		return false;
+	}
+
+	/*
+	 * Without a pack, the assets are loaded from their own files.
+	 */
+	openAssetPack();
+	return true;
+}
+
+/*
+ * Finds part of an asset in the asset pack.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to find.
+ * @return Returns the asset's ID, or -1 if it isn't in the pack.
+ */
+int findAsset(const char* name, assetPart_t part)
+{
+	u32 hash = 0;
+	u32 mask = 0;
+	u32 index = 0;
+	u32 i = 0;
+
+	if(assetPackEntries == NULL)
+	{
+		return -1;
+	}
+
+	/*
+	 * The pack uses the asset's file name, so the part's extension is
+	 * added to the hash.  A hash of 0 marks an empty entry, so it is
+	 * moved to 1 like the tool does.
+	 */
+	hash = hashAssetName(hashAssetName(2166136261u, name), assetExtensions[part]);
+	if(hash == 0)
+	{
+		hash = 1;
+	}
+
+	/*
+	 * Looks from the hash's entry until the asset or an empty entry
+	 * is found.  The table is never more than half full, so this is
+	 * almost always the first entry.
+	 */
+	mask = assetPackEntryCount - 1;
+	index = hash & mask;
+	for(i = 0;i < assetPackEntryCount;i += 1)
+	{
+		if(assetPackEntries[index].hash == hash)
+		{
+			return index;
+		}
+		if(assetPackEntries[index].hash == 0)
+		{
+			break;
+		}
+		index = (index + 1) & mask;
+	}
+
+	return -1;
+}
+
+/*
+ * Gets the size of an asset in the asset pack.
+ * @param id The asset's ID, from findAsset.
+ * @return Returns the size in bytes, or 0 if the ID is not valid.
+ */
+u32 getAssetSizeById(int id)
+{
+	if(id < 0 || (u32)id >= assetPackEntryCount)
+	{
+		return 0;
+	}
+
+	return assetPackEntries[id].size;
+}
+
+/*
+ * Opens part of an asset for reading from its own file, when there is
+ * no asset pack.
+ * @param name The name of the asset.
+ * @param part The part of the asset to open.
+ * @param size Set to the size of the file.
+ * @return Returns the opened file, or NULL if it couldn't be opened.
+ */
+static FILE* openAsset(const char* name, assetPart_t part, u32* size)
+{
+	/*
+	 * Creates the asset's file name.
+	 */
+	char fileName[128];
+	snprintf(fileName, sizeof(fileName), "%s%s%s", ASSET_DIRECTORY, name, assetExtensions[part]);
+
+	FILE* file = fopen(fileName, "rb");
+	if(file == NULL)
+	{
+		*size = 0;
+		return NULL;
+	}
+
+	/*
+	 * Gets the size of the file.
+	 */
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	return file;
+}
+
+/*
+ * Gets the size of part of an asset.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to get the size of.
+ * @return Returns the size in bytes, or 0 if it doesn't exist.
+ */
+u32 getAssetSize(const char* name, assetPart_t part)
+{
+	u32 size = 0;
+
+	if(assetPack != NULL)
+	{
+		return getAssetSizeById(findAsset(name, part));
+	}
+
+	FILE* file = openAsset(name, part, &size);
+	if(file != NULL)
+	{
+		fclose(file);
+	}
+	return size;
+}
+
+/*
+ * Copies data from a file to the desired destination in chunks.
+ * @param file The file, at the start of the data.
+ * @param size The size of the data.
+ * @param dest Where to copy the data to.
+ * @param maxSize The max amount of bytes to copy.
+ * @param vram Whether the destination is in VRAM.
+ * @return Returns the amount of bytes that were copied.
+ */
+static u32 streamFromFile(FILE* file, u32 size, void* dest, u32 maxSize, bool vram)
+{
+	u32 copied = 0;
+
+	/*
+	 * Makes sure that the destination does not overflow.
+	 */
+	if(size > maxSize)
+	{
+		size = maxSize;
+	}
+
+	/*
+	 * Copies the file one chunk at a time.
+	 */
+	while(copied < size)
+	{
+		u32 chunk = (size - copied > ASSET_CHUNK_SIZE) ? ASSET_CHUNK_SIZE : size - copied;
+
+		if(vram)
+		{
+			/*
+			 * VRAM can't be written a byte at a time, so the chunk is read into
+			 * the asset buffer and then copied over with DMA.
+			 */
+			chunk = fread(assetBuffer, 1, chunk, file);
+			if(chunk == 0)
+			{
+				break;
+			}
+			DC_FlushRange(assetBuffer, chunk);
+			dmaCopy(assetBuffer, (u8*)dest + copied, chunk);
+		}
+		else
+		{
+			/*
+			 * Main memory can be read into directly.
+			 */
+			chunk = fread((u8*)dest + copied, 1, chunk, file);
+			if(chunk == 0)
+			{
+				break;
+			}
+		}
+		copied += chunk;
+	}
+
+	return copied;
+}
+
+/*
+ * Streams an asset from the asset pack to the desired destination in chunks.
+ * @param id The asset's ID, from findAsset.
+ * @param dest Where to copy the data to.
+ * @param maxSize The max amount of bytes to copy.
+ * @param vram Whether the destination is in VRAM.
+ * @return Returns the amount of bytes that were copied.
+ */
+u32 streamAssetById(int id, void* dest, u32 maxSize, bool vram)
+{
+	u32 size = getAssetSizeById(id);
+
+	if(size == 0 || fseek(assetPack, assetPackEntries[id].offset, SEEK_SET) != 0)
+	{
+		return 0;
+	}
+
+	return streamFromFile(assetPack, size, dest, maxSize, vram);
+}
+
+/*
+ * Streams part of an asset to the desired destination in chunks.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to stream.
+ * @param dest Where to copy the data to.
+ * @param maxSize The max amount of bytes to copy.
+ * @param vram Whether the destination is in VRAM.  VRAM is written with
+ * DMA from the asset buffer, main memory is read into directly.
+ * @return Returns the amount of bytes that were copied.
+ */
+u32 streamAsset(const char* name, assetPart_t part, void* dest, u32 maxSize, bool vram)
+{
+	u32 size = 0;
+
+	if(assetPack != NULL)
+	{
+		return streamAssetById(findAsset(name, part), dest, maxSize, vram);
+	}
+
+	FILE* file = openAsset(name, part, &size);
+	if(file == NULL)
+	{
+		return 0;
+	}
+
+	u32 copied = streamFromFile(file, size, dest, maxSize, vram);
+	fclose(file);
+
+	return copied;
+}
+
+/*
+ * Loads part of an asset into newly allocated memory.
+ * @param name The name of the asset (IE: "rock").
+ * @param part The part of the asset to load.
+ * @param size Set to the size of the loaded data.
+ * @return Returns the data (free it when done), or NULL if it couldn't be loaded.
+ */
+void* loadAsset(const char* name, assetPart_t part, u32* size)
+{
+	FILE* file = NULL;
+	int id = -1;
+
+	/*
+	 * The asset is only looked up (or opened) once, and the same
+	 * handle is used to read it.
+	 */
+	if(assetPack != NULL)
+	{
+		id = findAsset(name, part);
+		*size = getAssetSizeById(id);
+	}
+	else
+	{
+		file = openAsset(name, part, size);
+	}
+
+	void* data = (*size > 0) ? malloc(*size) : NULL;
+	if(data == NULL)
+	{
+		if(file != NULL)
+		{
+			fclose(file);
+		}
+		*size = 0;
+		return NULL;
+	}
+
+	if(file != NULL)
+	{
+		*size = streamFromFile(file, *size, data, *size, false);
+		fclose(file);
+	}
+	else
+	{
+		*size = streamAssetById(id, data, *size, false);
+	}
+
+	return data;
+}
+
+/*
+ * Loads a background asset onto a background created with createBg.
+ * The tiles are streamed straight into VRAM, and the loaded map is
+ * handed over to the background rather than copied.
+ * @param screen The screen the background is on.
+ * @param layer The layer of the background.
+ * @param name The name of the asset (IE: "top_main").
+ */
+void loadBgAsset(int screen, int layer, const char* name)
+{
+	u32 mapSize = 0;
+	u32 tileVramSize = 0;
+
+	/*
+	 * Makes sure the background was actually created.
+	 */
+	void* tileVram = beginBgTileStream(screen, layer, &tileVramSize);
+	if(tileVram == NULL)
+	{
+		return;
+	}
+
+	/*
+	 * Sets the background's palette first.
+	 */
+	memset(assetPalette, 0, sizeof(assetPalette));
+	streamAsset(name, ASSET_PALETTE, assetPalette, sizeof(assetPalette), false);
+	setBgPalette(screen, layer, assetPalette);
+
+	/*
+	 * Then streams the tiles into the background's graphics memory, without
+	 * going past the memory that was set aside for them.
+	 */
+	streamAsset(name, ASSET_TILES, tileVram, tileVramSize, true);
+
+	/*
+	 * The map is kept in memory by the background for scrolling,
+	 * so the loaded copy is given to it.
+	 */
+	unsigned short* map = (unsigned short*)loadAsset(name, ASSET_MAP, &mapSize);
+	if(map != NULL)
+	{
+		adoptBgMap(screen, layer, map, mapSize);
+	}
+}
+
+/*
+ * Creates a sprite from a sprite asset.  The tiles and palette come from
+ * the asset cache, so creating the same sprite again doesn't load or copy
+ * them.
+ * @param screen The screen to create the sprite on.
+ * @param index The index of the sprite.
+ * @param palSlot The slot for the palette data.
+ * @param name The name of the asset (IE: "rock").
+ * @param width The width of the sprite.
+ * @param height The height of the sprite.
+ */
+void createSpriteAsset(int screen, int index, int palSlot, const char* name,
+		int width, int height)
+{
+	u32 tilesSize = 0;
+	u32 paletteSize = 0;
+
+	/*
+	 * The sprite uses the cached data, and releases it when it is deleted.
+	 */
+	const unsigned int* tiles = (const unsigned int*)acquireCachedAsset(name, ASSET_TILES, &tilesSize);
+	const unsigned short* palette = (const unsigned short*)acquireCachedAsset(name, ASSET_PALETTE, &paletteSize);
+
+	if(tiles != NULL && palette != NULL
+			&& createSharedSprite(screen, index, palSlot, tiles, tilesSize, palette, width, height))
+	{
+		return;
+	}
+
+	releaseCachedAsset(tiles);
+	releaseCachedAsset(palette);
+
+	/*
+	 * If the cache couldn't hold the asset, the sprite is given its own
+	 * copy instead.
+	 */
+	if(tiles == NULL || palette == NULL)
+	{
+		unsigned int* copy = (unsigned int*)loadAsset(name, ASSET_TILES, &tilesSize);
+		if(copy == NULL)
+		{
+			return;
+		}
+
+		memset(assetPalette, 0, sizeof(assetPalette));
+		streamAsset(name, ASSET_PALETTE, assetPalette, sizeof(assetPalette), false);
+
+		createSprite(screen, index, palSlot, copy, tilesSize, assetPalette, width, height);
+
+		/*
+		 * The sprite copies the data, so the loaded tiles can be freed.
+		 */
+		free(copy);
+	}
+}
@@ -1,92 +1,286 @@
 /*
- * A system for opening and closing file buffers.
+ * A system for opening and closing file buffers.  A file buffer reads a
+ * file through a small cache of fixed-size pages, so any part of a file can
+ * be read without loading the whole file into memory.
  * Created by: Gerald McAlister
  */
 
 #include "fileIO.h"
 
-#include <stdio.h>
+/*
+ * Reads a page of the file into one of the buffer's pages.
+ * @param fileBuffer The buffer to read into.
+ * @param page The page to read into.
+ * @param index The index of the page in the file.
+ */
+static void loadFilePage(fileBuffer_t* fileBuffer, fileBufferPage_t* page, s32 index)
+{
+	u32 start = index * FILE_BUFFER_PAGE_SIZE;
+	u32 length = fileBuffer->size - start;
+
+	if(length > FILE_BUFFER_PAGE_SIZE)
+	{
+		length = FILE_BUFFER_PAGE_SIZE;
+	}
+
+	// Only seek when the page doesn't follow the last one read, since the
+	// file is already at the right place otherwise.
+	if(fileBuffer->lastPageRead != index - 1)
+	{
+		fseek(fileBuffer->file, fileBuffer->offset + start, SEEK_SET);
+	}
+
+	page->length = fread(page->data, 1, length, fileBuffer->file);
+	page->index = (page->length > 0) ? index : -1;
+	fileBuffer->lastPageRead = (page->length == length) ? index : -2;
+}
 
 /*
- * Loads a file into the desired buffer and returns the size of it.
- * @param fileName The name of the file to load.
- * @param fileBuffer The buffer to store the file in.
- * @param offset The offset to start reading the file at.
- * @return Returns the size of the file.
+ * Gets the page to replace, which is the one used the longest ago.
+ * @param fileBuffer The buffer to get the page from.
+ * @param keep A page index that should not be replaced, or -1.
+ * @return Returns the page to replace.
  */
-u32 openFile(char* fileName, fileBuffer_t* fileBuffer, int offset)
+static fileBufferPage_t* getOldestFilePage(fileBuffer_t* fileBuffer, s32 keep)
 {
-	// Allocate memory for the file name.
-	fileBuffer->name = (char*)calloc(strlen(fileName) + 1, sizeof(char));
-	// Copy the file name to the file buffer.
-	strcpy(fileBuffer->name, fileName);
+	fileBufferPage_t* oldest = NULL;
+	int i = 0;
+
+	for(i = 0;i < FILE_BUFFER_PAGES;i += 1)
+	{
+		fileBufferPage_t* page = &fileBuffer->pages[i];
+		if(keep >= 0 && page->index == keep)
+		{
+			continue;
+		}
+		// Empty pages are always used first.
+		if(page->index < 0)
+		{
+			return page;
+		}
+		if(oldest == NULL || page->lastUse < oldest->lastUse)
+		{
+			oldest = page;
+		}
+	}
 
-	// Set the file offset.
-	fileBuffer->offset = offset;
+	return oldest;
+}
+
+/*
+ * Gets a page of the file, reading it in if it isn't already.
+ * @param fileBuffer The buffer to get the page from.
+ * @param index The index of the page.
+ * @return Returns the page, or NULL if it couldn't be read.
+ */
+static fileBufferPage_t* getFilePage(fileBuffer_t* fileBuffer, s32 index)
+{
+	int i = 0;
+
+	for(i = 0;i < FILE_BUFFER_PAGES;i += 1)
+	{
+		if(fileBuffer->pages[i].index == index)
+		{
+			fileBuffer->useCount += 1;
+			fileBuffer->pages[i].lastUse = fileBuffer->useCount;
+			return &fileBuffer->pages[i];
+		}
+	}
+
+	// Reading straight through the file reads the page after this one too,
+	// while the file is already at the right place.
+	bool sequential = (fileBuffer->lastPageRead == index - 1);
+
+	fileBufferPage_t* page = getOldestFilePage(fileBuffer, -1);
+	loadFilePage(fileBuffer, page, index);
+	if(page->index < 0)
+	{
+		return NULL;
+	}
+	fileBuffer->useCount += 1;
+	page->lastUse = fileBuffer->useCount;
+
+	if(sequential && (u32)(index + 1) * FILE_BUFFER_PAGE_SIZE < fileBuffer->size)
+	{
+		fileBufferPage_t* next = getOldestFilePage(fileBuffer, index);
+		loadFilePage(fileBuffer, next, index + 1);
+		// The page read ahead is marked as used just before this one, so
+		// that it is the next to go if it is never used.
+		next->lastUse = page->lastUse - 1;
+	}
+
+	return page;
+}
+
+/*
+ * Opens a file buffer and returns the size of the file.
+ * @param fileName The name of the file to open.
+ * @param fileBuffer The buffer to open the file in.
+ * @param offset The offset to start the buffer at.  Positions given to
+ * the buffer are from this offset.
+ * @return Returns the size of the file from the offset, or 0 if it could
+ * not be opened.
+ */
+u32 openFileBuffer(const char* fileName, fileBuffer_t* fileBuffer, int offset)
+{
+	int i = 0;
+
+	// Clear out the buffer's fields, so that closeBuffer is always safe to call.
+	memset(fileBuffer, 0, sizeof(fileBuffer_t));
+	for(i = 0;i < FILE_BUFFER_PAGES;i += 1)
+	{
+		fileBuffer->pages[i].index = -1;
+	}
+	fileBuffer->lastPageRead = -2;
 
 	// Open the file to read.
-	FILE* f = fopen(fileBuffer->name, "rb");
+	fileBuffer->file = fopen(fileName, "rb");
 
 	// Check that that file was opened successfully.
-	if(!f)
+	if(!fileBuffer->file)
 	{
 		// Return 0 as the file size if the file wasn't opened properly.
 		return 0;
 	}
 
-	// Seek the end of the file.
-	fseek(f, 0, SEEK_END);
-	// Set the size to be the position of the end (which is the size of the file).
-	fileBuffer->size = ftell(f) - fileBuffer->offset;
-	// Rewind the file to the beginnning.
-	rewind(f);
-	// Set the read position to the current position to read from.
-	fseek(f, fileBuffer->offset, SEEK_CUR);
-
-	// Check if there is already a buffer.
-	if(fileBuffer->buffer)
+	// Copy the file name to the file buffer.
+	fileBuffer->name = (char*)calloc(strlen(fileName) + 1, sizeof(char));
+	if(fileBuffer->name)
 	{
-		// Free the buffer if there is.
-		free(fileBuffer->buffer);
-		// Set the buffer to NULL after freeing it.
-		fileBuffer->buffer = NULL;
+		strcpy(fileBuffer->name, fileName);
 	}
-	// Allocate memory for the buffer.
-	fileBuffer->buffer = (char*)calloc(fileBuffer->size, sizeof(char));
 
-	// Check if the buffer was setup properly.
-	if(fileBuffer->buffer == NULL)
+	// Seek the end of the file to get its size, and take the offset out of it.
+	fseek(fileBuffer->file, 0, SEEK_END);
+	long fileSize = ftell(fileBuffer->file);
+	fileBuffer->offset = (offset < 0) ? 0 : offset;
+	fileBuffer->size = (fileSize > (long)fileBuffer->offset) ? (unsigned int)(fileSize - fileBuffer->offset) : 0;
+
+	// Allocate all of the pages at once.
+	u8* pageData = (u8*)malloc(FILE_BUFFER_PAGES * FILE_BUFFER_PAGE_SIZE);
+	if(pageData == NULL || fileBuffer->size == 0)
 	{
-		// Set the size to 0 if it was not.
-		fileBuffer->size = 0;
+		free(pageData);
+		closeBuffer(fileBuffer);
+		return 0;
 	}
-	else
+	for(i = 0;i < FILE_BUFFER_PAGES;i += 1)
 	{
-		// Otherwise, read the file into the buffer.
-		fread(fileBuffer->buffer, 1, fileBuffer->size - fileBuffer->offset, f);
+		fileBuffer->pages[i].data = pageData + (i * FILE_BUFFER_PAGE_SIZE);
 	}
 
-	// Close the file.
-	fclose(f);
-
 	// Return the size of the buffer.
 	return fileBuffer->size;
 }
 
 /*
- * Unloads a buffer from memory.
+ * Reads part of a file buffer.
+ * @param fileBuffer The buffer to read from.
+ * @param position Where to read from.
+ * @param dest Where to copy the data to.
+ * @param length The amount of bytes to read.
+ * @return Returns the amount of bytes read, which is less than the length
+ * at the end of the file.
+ */
+u32 readFileBuffer(fileBuffer_t* fileBuffer, u32 position, void* dest, u32 length)
+{
+	u32 read = 0;
+
+	if(fileBuffer->file == NULL || position >= fileBuffer->size)
+	{
+		return 0;
+	}
+	if(length > fileBuffer->size - position)
+	{
+		length = fileBuffer->size - position;
+	}
+
+	// Copy the data out of each page it covers.
+	while(read < length)
+	{
+		fileBufferPage_t* page = getFilePage(fileBuffer, (position + read) / FILE_BUFFER_PAGE_SIZE);
+		u32 pageOffset = (position + read) % FILE_BUFFER_PAGE_SIZE;
+
+		if(page == NULL || pageOffset >= page->length)
+		{
+			break;
+		}
+
+		u32 amount = page->length - pageOffset;
+		if(amount > length - read)
+		{
+			amount = length - read;
+		}
+
+		memcpy((u8*)dest + read, page->data + pageOffset, amount);
+		read += amount;
+	}
+
+	return read;
+}
+
+/*
+ * Reads the next part of a file buffer, starting where the last call
+ * ended.
+ * @param fileBuffer The buffer to read from.
+ * @param dest Where to copy the data to.
+ * @param length The amount of bytes to read.
+ * @return Returns the amount of bytes read.
+ */
+u32 readFileBufferNext(fileBuffer_t* fileBuffer, void* dest, u32 length)
+{
+	u32 read = readFileBuffer(fileBuffer, fileBuffer->position, dest, length);
+	fileBuffer->position += read;
+	return read;
+}
+
+/*
+ * Sets where readFileBufferNext reads from.
+ * @param fileBuffer The buffer.
+ * @param position The position to read from next.
+ */
+void seekFileBuffer(fileBuffer_t* fileBuffer, u32 position)
+{
+	fileBuffer->position = (position > fileBuffer->size) ? fileBuffer->size : position;
+}
+
+/*
+ * Closes a buffer's file and frees its pages.  The buffer can be opened
+ * again afterwards.
  * @param fileBuffer The buffer to close.
  */
 void closeBuffer(fileBuffer_t* fileBuffer)
 {
+	int i = 0;
+
 	/*
-	 * Checks that the buffer is not empty.
+	 * Checks that the file is open.
 	*/
-	if(fileBuffer->buffer)
+	if(fileBuffer->file)
 	{
-		free(fileBuffer->buffer);
-		fileBuffer->buffer = NULL;
+		fclose(fileBuffer->file);
+		fileBuffer->file = NULL;
 	}
-}
 
+	/*
+	 * The pages were all allocated together, starting with the first.
+	*/
+	if(fileBuffer->pages[0].data)
+	{
+		free(fileBuffer->pages[0].data);
+	}
+	for(i = 0;i < FILE_BUFFER_PAGES;i += 1)
+	{
+		fileBuffer->pages[i].data = NULL;
+		fileBuffer->pages[i].index = -1;
+	}
 
+	if(fileBuffer->name)
+	{
+		free(fileBuffer->name);
+		fileBuffer->name = NULL;
+	}
+
+	fileBuffer->size = 0;
+	fileBuffer->position = 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Local leaderboards for the game's high scores.  Each leaderboard is a
+ * fixed size array kept sorted from the best score down, held in memory
+ * and saved as a single small block whenever it changes.
+ */
+#include "GEM_functions.h"
+
+/*
+ * The most data the leaderboard save can hold.
+ */
+#define LEADERBOARD_SAVE_SIZE 512
+
+/*
+ * The entries on each leaderboard, from the best score down.
+ */
+leaderboardEntry_t leaderboardEntries[LEADERBOARDS][MAX_LEADERBOARD_ENTRIES];
+
+/*
+ * The amount of entries on each leaderboard.
+ */
+int leaderboardCounts[LEADERBOARDS];
+
+/*
+ * Tells whether the leaderboards have been loaded.
+ */
+bool leaderboardsLoaded = false;
+
+/*
+ * Loads the leaderboards into memory.  Only the first call reads the save
+ * file; the other leaderboard functions call this themselves, but it is
+ * also called at startup so that submitting a score only writes.
+ */
+void loadLeaderboards()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8 data[LEADERBOARD_SAVE_SIZE];
+	saveReader_t reader;
+	u16 version;
+	leaderboardEntry_t* entry = NULL;
+	int board = 0;
+	int count = 0;
+	int i = 0;
+
+	if(leaderboardsLoaded)
+	{
+		return;
+	}
+	leaderboardsLoaded = true;
+	memset(leaderboardCounts, 0, sizeof(leaderboardCounts));
+
+	/*
+	 * A missing or broken save just starts the leaderboards empty.
+	 */
+	if(!getSavePath(LEADERBOARD_FILE, fileName, sizeof(fileName))
+			|| !readSaveFile(fileName, LEADERBOARD_MAGIC, LEADERBOARD_VERSION, &version, data, sizeof(data), &reader))
+	{
+		return;
+	}
+
+	for(board = 0;board < LEADERBOARDS;board += 1)
+	{
+		count = readSaveU8(&reader);
+		if(count > MAX_LEADERBOARD_ENTRIES)
+		{
+			count = MAX_LEADERBOARD_ENTRIES;
+		}
+
+		for(i = 0;i < count;i += 1)
+		{
+			entry = &leaderboardEntries[board][i];
+
+			readSaveBytes(&reader, entry->name, sizeof(entry->name) - 1);
+			entry->name[sizeof(entry->name) - 1] = '\0';
+			entry->score = readSaveU32(&reader);
+			entry->date.day = readSaveU8(&reader);
+			entry->date.month = readSaveU8(&reader);
+			entry->date.year = readSaveU16(&reader);
+		}
+		leaderboardCounts[board] = count;
+	}
+}
+
+/*
+ * Queues the leaderboards to be saved.  They all fit in one block, so
+ * this is a single small write no matter how many scores were submitted.
+ */
+static void saveLeaderboards()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8 data[LEADERBOARD_SAVE_SIZE];
+	saveWriter_t writer;
+	const leaderboardEntry_t* entry = NULL;
+	int board = 0;
+	int i = 0;
+
+	if(!getSavePath(LEADERBOARD_FILE, fileName, sizeof(fileName)))
+	{
+		return;
+	}
+
+	initSaveWriter(&writer, data, sizeof(data));
+	for(board = 0;board < LEADERBOARDS;board += 1)
+	{
+		writeSaveU8(&writer, leaderboardCounts[board]);
+
+		for(i = 0;i < leaderboardCounts[board];i += 1)
+		{
+			entry = &leaderboardEntries[board][i];
+
+			writeSaveBytes(&writer, entry->name, sizeof(entry->name) - 1);
+			writeSaveU32(&writer, entry->score);
+			writeSaveU8(&writer, entry->date.day);
+			writeSaveU8(&writer, entry->date.month);
+			writeSaveU16(&writer, entry->date.year);
+		}
+	}
+
+	writeSaveFile(fileName, LEADERBOARD_MAGIC, LEADERBOARD_VERSION, &writer);
+}
+
+/*
+ * Submits a score to a leaderboard.  Each player has at most one entry on
+ * a leaderboard.  If the player is already on it, their entry is only
+ * changed when the new score beats it; otherwise the score is added if it
+ * makes the leaderboard.  Either way, the entry is moved to its place and
+ * the leaderboards are queued to be saved.
+ * @param board The leaderboard.
+ * @param name The name of the player.
+ * @param score The player's score.
+ * @return Returns the score's place on the leaderboard (0 is first), or -1
+ * if it didn't make it or didn't beat the player's entry.
+ */
+int submitScore(leaderboard_t board, const char* name, u32 score)
+{
+	leaderboardEntry_t* entries = NULL;
+	int count = 0;
+	int existing = -1;
+	int low = 0;
+	int high = 0;
+	int middle = 0;
+	int i = 0;
+
+	loadLeaderboards();
+
+	if(board < 0 || board >= LEADERBOARDS || score == 0)
+	{
+		return -1;
+	}
+
+	entries = leaderboardEntries[board];
+	count = leaderboardCounts[board];
+
+	/*
+	 * Looks for the player's entry.  A score that doesn't beat it leaves
+	 * the leaderboard as it is.
+	 */
+	for(i = 0;i < count;i += 1)
+	{
+		if(strncmp(entries[i].name, name, sizeof(entries[i].name) - 1) == 0)
+		{
+			existing = i;
+			break;
+		}
+	}
+
+	if(existing >= 0 && entries[existing].score >= score)
+	{
+		return -1;
+	}
+
+	/*
+	 * Finds the score's place with a binary search.  It goes after any
+	 * equal scores, so older scores keep their place.  A better score
+	 * than the player's entry always goes above it.
+	 */
+	low = 0;
+	high = (existing >= 0) ? existing : count;
+	while(low < high)
+	{
+		middle = (low + high) / 2;
+		if(entries[middle].score >= score)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if(low >= MAX_LEADERBOARD_ENTRIES)
+	{
+		return -1;
+	}
+
+	if(existing >= 0)
+	{
+		/*
+		 * The scores between the new place and the player's old entry
+		 * are moved down a place, over the old entry.
+		 */
+		memmove(&entries[low + 1], &entries[low], (existing - low) * sizeof(leaderboardEntry_t));
+	}
+	else
+	{
+		/*
+		 * The lower scores are moved down a place (the last one falls off
+		 * if the leaderboard is full), and the new score goes in the gap.
+		 */
+		if(count < MAX_LEADERBOARD_ENTRIES)
+		{
+			count += 1;
+		}
+		memmove(&entries[low + 1], &entries[low], (count - 1 - low) * sizeof(leaderboardEntry_t));
+	}
+
+	memset(&entries[low], 0, sizeof(leaderboardEntry_t));
+	strncpy(entries[low].name, name, sizeof(entries[low].name) - 1);
+	entries[low].score = score;
+	entries[low].date.day = getTimeDayOfMonth();
+	entries[low].date.month = getTimeMonth();
+	entries[low].date.year = getTimeYear();
+	leaderboardCounts[board] = count;
+
+	saveLeaderboards();
+
+	return low;
+}
+
+/*
+ * Gets the amount of entries on a leaderboard.
+ * @param board The leaderboard.
+ * @return Returns the amount of entries.
+ */
+int getLeaderboardCount(leaderboard_t board)
+{
+	loadLeaderboards();
+
+	if(board < 0 || board >= LEADERBOARDS)
+	{
+		return 0;
+	}
+
+	return leaderboardCounts[board];
+}
+
+/*
+ * Gets an entry on a leaderboard.
+ * @param board The leaderboard.
+ * @param place The entry's place (0 is first).
+ * @return Returns the entry, or NULL if there is no entry in that place.
+ */
+const leaderboardEntry_t* getLeaderboardEntry(leaderboard_t board, int place)
+{
+	loadLeaderboards();
+
+	if(board < 0 || board >= LEADERBOARDS || place < 0 || place >= leaderboardCounts[board])
+	{
+		return NULL;
+	}
+
+	return &leaderboardEntries[board][place];
+}
@@ -0,0 +1,278 @@
+/*
+ * Keeps statistics of the current user's matches: how often each choice is
+ * picked, how each match ends, and what each choice was played against.
+ * The statistics are kept in memory, so recording a match and reading the
+ * history never touch the SD card, and are saved all at once when a
+ * session ends.
+ */
+#include "GEM_functions.h"
+
+/*
+ * The most data a statistics save can hold.
+ */
+#define MATCH_STATS_SAVE_SIZE 256
+
+/*
+ * The current user's statistics for each game mode.
+ */
+matchStats_t matchStats[STATS_MODES];
+
+/*
+ * The user the statistics were loaded for.
+ */
+char matchStatsUser[11];
+
+/*
+ * Tells whether the statistics have been loaded.
+ */
+bool matchStatsLoaded = false;
+
+/*
+ * Tells whether matches have been recorded since the statistics were saved.
+ */
+bool matchStatsChanged = false;
+
+/*
+ * Adds one to a counter, unless it is already at its max value.
+ * @param counter The counter.
+ */
+static inline void addToCounter(u16* counter)
+{
+	if(*counter < 0xFFFF)
+	{
+		*counter += 1;
+	}
+}
+
+/*
+ * Clears the statistics.
+ */
+static void clearMatchStats()
+{
+	int mode = 0;
+
+	memset(matchStats, 0, sizeof(matchStats));
+	for(mode = 0;mode < STATS_MODES;mode += 1)
+	{
+		matchStats[mode].lastChoice = -1;
+	}
+}
+
+/*
+ * Gets the path of a user's statistics file.
+ * @param user The name of the user.
+ * @param fileName Set to the file's path.
+ * @param size The size of the path.
+ * @return Returns true if there is somewhere to save the statistics.
+ */
+static bool getMatchStatsFileName(const char* user, char* fileName, int size)
+{
+	char name[16];
+
+	snprintf(name, sizeof(name), "%.10s.sta", user);
+	return getSavePath(name, fileName, size);
+}
+
+/*
+ * Loads the current user's statistics into memory.  Only the first call
+ * (or the first after the user changes) reads the save file; the other
+ * statistics functions call this themselves, but it is also called at
+ * startup so that recording the first match doesn't read the SD card.
+ */
+void loadMatchStats()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	char user[11];
+	u8 data[MATCH_STATS_SAVE_SIZE];
+	saveReader_t reader;
+	u16 version;
+	matchStats_t* stats = NULL;
+	int mode = 0;
+	int i = 0;
+	int j = 0;
+
+	/*
+	 * Nothing is read again unless the user changed.
+	 */
+	getCurrentUserName(user, sizeof(user));
+	if(matchStatsLoaded && strcmp(matchStatsUser, user) == 0)
+	{
+		return;
+	}
+
+	/*
+	 * The last user's statistics are saved before they are forgotten.
+	 */
+	if(matchStatsLoaded)
+	{
+		saveMatchStats();
+	}
+
+	clearMatchStats();
+	strcpy(matchStatsUser, user);
+	matchStatsLoaded = true;
+	matchStatsChanged = false;
+
+	/*
+	 * A missing or broken save just starts the statistics again.
+	 */
+	if(!getMatchStatsFileName(user, fileName, sizeof(fileName))
+			|| !readSaveFile(fileName, MATCH_STATS_MAGIC, MATCH_STATS_VERSION, &version, data, sizeof(data), &reader))
+	{
+		return;
+	}
+
+	for(mode = 0;mode < STATS_MODES;mode += 1)
+	{
+		stats = &matchStats[mode];
+
+		stats->matches = readSaveU32(&reader);
+		for(i = 0;i < STATS_CHOICES;i += 1)
+		{
+			stats->choices[i] = readSaveU16(&reader);
+		}
+		for(i = 0;i < STATS_OUTCOMES;i += 1)
+		{
+			stats->outcomes[i] = readSaveU16(&reader);
+		}
+		for(i = 0;i < STATS_CHOICES;i += 1)
+		{
+			for(j = 0;j < STATS_CHOICES;j += 1)
+			{
+				stats->versus[i][j] = readSaveU16(&reader);
+			}
+		}
+		stats->lastChoice = (s16)readSaveU16(&reader);
+		stats->streak = readSaveU16(&reader);
+		stats->bestStreak = readSaveU16(&reader);
+
+		if(stats->lastChoice >= STATS_CHOICES)
+		{
+			stats->lastChoice = -1;
+		}
+	}
+}
+
+/*
+ * Records a match.
+ * @param mode The game mode the match was played in.
+ * @param choice The player's choice.
+ * @param opponentChoice The opponent's choice.
+ * @param result The result of the match for the player (-1 is a loss,
+ * 0 is a tie and 1 is a win).
+ */
+void recordMatch(statsMode_t mode, int choice, int opponentChoice, int result)
+{
+	matchStats_t* stats = NULL;
+	int outcome = 0;
+
+	loadMatchStats();
+
+	if(mode < 0 || mode >= STATS_MODES || choice < 0 || choice >= STATS_CHOICES
+			|| opponentChoice < 0 || opponentChoice >= STATS_CHOICES)
+	{
+		return;
+	}
+
+	stats = &matchStats[mode];
+	outcome = (result < 0) ? STATS_LOSS : (result > 0) ? STATS_WIN : STATS_TIE;
+
+	if(stats->matches < 0xFFFFFFFF)
+	{
+		stats->matches += 1;
+	}
+	addToCounter(&stats->choices[choice]);
+	addToCounter(&stats->outcomes[outcome]);
+	addToCounter(&stats->versus[choice][opponentChoice]);
+	stats->lastChoice = choice;
+
+	/*
+	 * Ties don't break a streak, but don't add to it either.
+	 */
+	if(outcome == STATS_WIN)
+	{
+		addToCounter(&stats->streak);
+		if(stats->streak > stats->bestStreak)
+		{
+			stats->bestStreak = stats->streak;
+		}
+	}
+	else if(outcome == STATS_LOSS)
+	{
+		stats->streak = 0;
+	}
+
+	matchStatsChanged = true;
+}
+
+/*
+ * Gets the current user's statistics for a game mode.
+ * @param mode The game mode.
+ * @return Returns the statistics.
+ */
+const matchStats_t* getMatchStats(statsMode_t mode)
+{
+	loadMatchStats();
+
+	if(mode < 0 || mode >= STATS_MODES)
+	{
+		mode = STATS_SINGLE;
+	}
+
+	return &matchStats[mode];
+}
+
+/*
+ * Queues the statistics to be saved, if any matches were recorded since
+ * they were last saved.  Should be called at the end of a session.
+ */
+void saveMatchStats()
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8 data[MATCH_STATS_SAVE_SIZE];
+	saveWriter_t writer;
+	const matchStats_t* stats = NULL;
+	int mode = 0;
+	int i = 0;
+	int j = 0;
+
+	if(!matchStatsLoaded || !matchStatsChanged || !getMatchStatsFileName(matchStatsUser, fileName, sizeof(fileName)))
+	{
+		return;
+	}
+
+	/*
+	 * Each counter is packed on its own, in the same order it is read.
+	 * New counters go on the end, along with a new MATCH_STATS_VERSION.
+	 */
+	initSaveWriter(&writer, data, sizeof(data));
+	for(mode = 0;mode < STATS_MODES;mode += 1)
+	{
+		stats = &matchStats[mode];
+
+		writeSaveU32(&writer, stats->matches);
+		for(i = 0;i < STATS_CHOICES;i += 1)
+		{
+			writeSaveU16(&writer, stats->choices[i]);
+		}
+		for(i = 0;i < STATS_OUTCOMES;i += 1)
+		{
+			writeSaveU16(&writer, stats->outcomes[i]);
+		}
+		for(i = 0;i < STATS_CHOICES;i += 1)
+		{
+			for(j = 0;j < STATS_CHOICES;j += 1)
+			{
+				writeSaveU16(&writer, stats->versus[i][j]);
+			}
+		}
+		writeSaveU16(&writer, (u16)stats->lastChoice);
+		writeSaveU16(&writer, stats->streak);
+		writeSaveU16(&writer, stats->bestStreak);
+	}
+
+	if(writeSaveFile(fileName, MATCH_STATS_MAGIC, MATCH_STATS_VERSION, &writer))
+	{
+		matchStatsChanged = false;
+	}
+}
@@ -0,0 +1,306 @@
+/*
+ * A container for save files.  Each save starts with a header holding a
+ * magic number, a version, the length of the data and a CRC32 of it, so
+ * a save can be checked before it is used and older versions can be
+ * moved forward.  The data is packed one field at a time in little endian
+ * order, so it doesn't depend on how the compiler lays out structures.
+ */
+#include <stdio.h>
+
+#include "GEM_functions.h"
+
+/*
+ * The table for working out CRC32s, built the first time it is needed.
+ */
+u32 crc32Table[256];
+
+/*
+ * Tells whether the CRC32 table has been built.
+ */
+bool crc32TableBuilt = false;
+
+/*
+ * Works out the CRC32 of some data.
+ * @param crc The CRC of the data before this (0 to start).
+ * @param data The data.
+ * @param length The length of the data.
+ * @return Returns the CRC of all of the data.
+ */
+u32 calculateCrc32(u32 crc, const void* data, int length)
+{
+	const u8* bytes = (const u8*)data;
+	int i = 0;
+	int bit = 0;
+
+	if(!crc32TableBuilt)
+	{
+		for(i = 0;i < 256;i += 1)
+		{
+			u32 value = i;
+			for(bit = 0;bit < 8;bit += 1)
+			{
+				value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+			}
+			crc32Table[i] = value;
+		}
+		crc32TableBuilt = true;
+	}
+
+	crc = ~crc;
+	for(i = 0;i < length;i += 1)
+	{
+		crc = crc32Table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+/*
+ * Sets up a save writer.
+ * @param writer The writer to set up.
+ * @param buffer The buffer to pack the data into.
+ * @param capacity The size of the buffer.
+ */
+void initSaveWriter(saveWriter_t* writer, void* buffer, int capacity)
+{
+	writer->data = (u8*)buffer;
+	writer->size = 0;
+	writer->capacity = capacity;
+	writer->overflowed = false;
+}
+
+/*
+ * Packs bytes into a save.
+ * @param writer The save writer.
+ * @param data The data to pack.
+ * @param length The amount of bytes to pack.
+ */
+void writeSaveBytes(saveWriter_t* writer, const void* data, int length)
+{
+	if(writer->size + length > writer->capacity)
+	{
+		writer->overflowed = true;
+		return;
+	}
+
+	memcpy(writer->data + writer->size, data, length);
+	writer->size += length;
+}
+
+/*
+ * Packs an 8 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+void writeSaveU8(saveWriter_t* writer, u8 value)
+{
+	writeSaveBytes(writer, &value, 1);
+}
+
+/*
+ * Packs a 16 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+void writeSaveU16(saveWriter_t* writer, u16 value)
+{
+	u8 bytes[2] = {value & 0xFF, value >> 8};
+	writeSaveBytes(writer, bytes, 2);
+}
+
+/*
+ * Packs a 32 bit value into a save.
+ * @param writer The save writer.
+ * @param value The value to pack.
+ */
+void writeSaveU32(saveWriter_t* writer, u32 value)
+{
+	u8 bytes[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24};
+	writeSaveBytes(writer, bytes, 4);
+}
+
+/*
+ * Unpacks bytes from a save.  Anything past the end of the save is
+ * unpacked as zeros.
+ * @param reader The save reader.
+ * @param data Set to the unpacked bytes.
+ * @param length The amount of bytes to unpack.
+ */
+void readSaveBytes(saveReader_t* reader, void* data, int length)
+{
+	int available = reader->size - reader->position;
+
+	if(available < 0)
+	{
+		available = 0;
+	}
+	if(available > length)
+	{
+		available = length;
+	}
+
+	memcpy(data, reader->data + reader->position, available);
+	memset((u8*)data + available, 0, length - available);
+	reader->position += length;
+}
+
+/*
+ * Unpacks an 8 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+u8 readSaveU8(saveReader_t* reader)
+{
+	u8 value;
+	readSaveBytes(reader, &value, 1);
+	return value;
+}
+
+/*
+ * Unpacks a 16 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+u16 readSaveU16(saveReader_t* reader)
+{
+	u8 bytes[2];
+	readSaveBytes(reader, bytes, 2);
+	return bytes[0] | (bytes[1] << 8);
+}
+
+/*
+ * Unpacks a 32 bit value from a save.
+ * @param reader The save reader.
+ * @return Returns the unpacked value.
+ */
+u32 readSaveU32(saveReader_t* reader)
+{
+	u8 bytes[4];
+	readSaveBytes(reader, bytes, 4);
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((u32)bytes[3] << 24);
+}
+
+/*
+ * Queues a save to be written.  The header is added, the save is padded
+ * to whole blocks, and it is written to a temporary file which then
+ * replaces the old save.
+ * @param fileName The name of the save file.
+ * @param magic The magic number for the type of save.
+ * @param version The version of the save's layout.
+ * @param writer The writer holding the save's data.
+ * @return Returns true if the save was queued, false if it couldn't be.
+ */
+bool writeSaveFile(const char* fileName, u32 magic, u16 version, const saveWriter_t* writer)
+{
+	saveWriter_t header;
+	bool queued = false;
+
+	if(writer->overflowed)
+	{
+		return false;
+	}
+
+	/*
+	 * The save is built in one buffer that is a whole number of blocks,
+	 * with the unused end left as zeros.
+	 */
+	int size = (SAVE_HEADER_SIZE + writer->size + SAVE_BLOCK_SIZE - 1) & ~(SAVE_BLOCK_SIZE - 1);
+	u8* block = (u8*)calloc(size, 1);
+	if(block == NULL)
+	{
+		return false;
+	}
+
+	initSaveWriter(&header, block, SAVE_HEADER_SIZE);
+	writeSaveU32(&header, magic);
+	writeSaveU16(&header, version);
+	writeSaveU16(&header, SAVE_HEADER_SIZE);
+	writeSaveU32(&header, writer->size);
+	writeSaveU32(&header, calculateCrc32(0, writer->data, writer->size));
+	memcpy(block + SAVE_HEADER_SIZE, writer->data, writer->size);
+
+	queued = queueSave(fileName, block, size, false);
+	free(block);
+
+	return queued;
+}
+
+/*
+ * Loads a save from a file and checks it.
+ * @param fileName The name of the file.
+ * @param magic The magic number for the type of save.
+ * @param newestVersion The newest version of the save's layout that this
+ * build can read.  Saves from newer builds are not loaded.
+ * @param version Set to the version of the save's layout.
+ * @param buffer The buffer to load the save's data into.
+ * @param capacity The size of the buffer.
+ * @param reader Set up to read the save's data.
+ * @return Returns true if the save is valid.
+ */
+static bool readSaveFrom(const char* fileName, u32 magic, u16 newestVersion, u16* version, void* buffer, int capacity, saveReader_t* reader)
+{
+	u8 headerData[SAVE_HEADER_SIZE];
+	saveReader_t header = {headerData, SAVE_HEADER_SIZE, 0};
+
+	FILE* file = fopen(fileName, "rb");
+	if(file == NULL)
+	{
+		return false;
+	}
+
+	/*
+	 * The header is checked first, then the data is read and its CRC
+	 * is checked against the header's.
+	 */
+	bool valid = fread(headerData, 1, SAVE_HEADER_SIZE, file) == SAVE_HEADER_SIZE;
+	u32 fileMagic = readSaveU32(&header);
+	u16 fileVersion = readSaveU16(&header);
+	u16 headerSize = readSaveU16(&header);
+	u32 length = readSaveU32(&header);
+	u32 crc = readSaveU32(&header);
+
+	valid = valid && fileMagic == magic && fileVersion >= 1 && fileVersion <= newestVersion && headerSize >= SAVE_HEADER_SIZE && length <= (u32)capacity;
+	valid = valid && fseek(file, headerSize, SEEK_SET) == 0;
+	valid = valid && fread(buffer, 1, length, file) == length;
+	valid = valid && calculateCrc32(0, buffer, length) == crc;
+	fclose(file);
+
+	if(valid)
+	{
+		*version = fileVersion;
+		reader->data = (const u8*)buffer;
+		reader->size = length;
+		reader->position = 0;
+	}
+	return valid;
+}
+
+/*
+ * Loads a save and checks it.  If the save is missing or broken, but a
+ * temporary file was left by a save that didn't finish, that is used.
+ * @param fileName The name of the save file.
+ * @param magic The magic number for the type of save.
+ * @param newestVersion The newest version of the save's layout that this
+ * build can read.  Saves from newer builds are not loaded.
+ * @param version Set to the version of the save's layout.
+ * @param buffer The buffer to load the save's data into.
+ * @param capacity The size of the buffer.
+ * @param reader Set up to read the save's data.
+ * @return Returns true if a valid save was loaded, false otherwise.
+ */
+bool readSaveFile(const char* fileName, u32 magic, u16 newestVersion, u16* version, void* buffer, int capacity, saveReader_t* reader)
+{
+	char tempName[MAX_SAVE_TEMP_PATH_LENGTH];
+
+	/*
+	 * Any queued saves are written first so the file is up to date.
+	 */
+	flushSaveQueue();
+
+	if(readSaveFrom(fileName, magic, newestVersion, version, buffer, capacity, reader))
+	{
+		return true;
+	}
+
+	return getTempSavePath(fileName, tempName, sizeof(tempName))
+			&& readSaveFrom(tempName, magic, newestVersion, version, buffer, capacity, reader);
+}
@@ -0,0 +1,151 @@
+/*
+ * Finds the game's save folder (data/GAME_TITLE on the SD card) once at
+ * startup, creating it if needed, and builds the paths of save files from
+ * it.  The paths include the SD card's device name, so they still work
+ * after NitroFS changes the working directory.
+ */
+#include <sys/stat.h>
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fat.h>
+
+#include "GEM_functions.h"
+
+/*
+ * The path of the save folder, ending with a slash (IE: "fat:/data/RPSLS/").
+ */
+char savePathPrefix[MAX_SAVE_PATH_LENGTH];
+
+/*
+ * Tells whether the save folder can be used.
+ */
+bool savePathReady = false;
+
+/*
+ * Tells whether save files may be read and written.
+ */
+bool saveFilesEnabled = true;
+
+/*
+ * Makes sure that a folder exists.
+ * @param path The path of the folder.
+ * @return Returns true if the folder exists.
+ */
+static bool createFolder(const char* path)
+{
+	struct stat info;
+
+	if(stat(path, &info) == 0)
+	{
+		return S_ISDIR(info.st_mode);
+	}
+
+	return mkdir(path, 0777) == 0;
+}
+
+/*
+ * Starts the file system and finds (or creates) the game's save folder.
+ * @return Returns true if the save folder can be used, false otherwise.
+ */
+bool initSavePath()
+{
+	char workingFolder[PATH_MAX];
+	char dataFolder[sizeof(savePathPrefix)];
+	char gameFolder[sizeof(savePathPrefix)];
+	char* deviceEnd = NULL;
+	int length = 0;
+
+	if(savePathReady)
+	{
+		return true;
+	}
+
+	/*
+	 * Without a file system (IE: an emulator without an SD card), the
+	 * game still runs but nothing is saved.
+	 */
+	if(!fatInitDefault())
+	{
+		return false;
+	}
+
+	/*
+	 * fatInitDefault moves the working directory onto the card it found,
+	 * to the folder the game was started from if it was given one (IE:
+	 * "fat:/_nds/games/").  Only the device name ("fat:/" or "sd:/") is
+	 * kept for the paths, since NitroFS moves the working directory to
+	 * "nitro:/" later on.
+	 */
+	if(getcwd(workingFolder, sizeof(workingFolder)) == NULL)
+	{
+		return false;
+	}
+
+	deviceEnd = strstr(workingFolder, ":/");
+	if(deviceEnd == NULL)
+	{
+		return false;
+	}
+	deviceEnd[2] = '\0';
+
+	length = snprintf(dataFolder, sizeof(dataFolder), "%sdata", workingFolder);
+	if(length < 0 || length >= (int)sizeof(dataFolder))
+	{
+		return false;
+	}
+
+	/*
+	 * The game's folder is made one shorter than the prefix, so the
+	 * prefix always has room for the slash on the end.
+	 */
+	length = snprintf(gameFolder, sizeof(gameFolder) - 1, "%s/%s", dataFolder, GAME_TITLE);
+	if(length < 0 || length >= (int)sizeof(gameFolder) - 1)
+	{
+		return false;
+	}
+	snprintf(savePathPrefix, sizeof(savePathPrefix), "%s/", gameFolder);
+
+	savePathReady = createFolder(dataFolder) && createFolder(gameFolder);
+	return savePathReady;
+}
+
+/*
+ * Tells whether the save folder can be used.
+ * @return Returns true if it can, false otherwise.
+ */
+bool isSavePathReady()
+{
+	return savePathReady && saveFilesEnabled;
+}
+
+/*
+ * Turns the reading and writing of save files on or off.  While it is
+ * off, getSavePath fails, so everything that is saved starts out empty
+ * and nothing is written.  Used while a replay is played back, so that
+ * the playback neither depends on nor changes what is on the SD card.
+ * @param enabled Whether save files can be used.
+ */
+void setSaveFilesEnabled(bool enabled)
+{
+	saveFilesEnabled = enabled;
+}
+
+/*
+ * Gets the path of a file in the save folder.
+ * @param fileName The name of the file (IE: "player.usr").
+ * @param path Set to the file's path.
+ * @param size The size of the path, which should be MAX_SAVE_PATH_LENGTH.
+ * @return Returns true if the path was made, false if there is no save
+ * folder, save files are turned off, or the path is too long.
+ */
+bool getSavePath(const char* fileName, char* path, int size)
+{
+	if(!isSavePathReady())
+	{
+		return false;
+	}
+
+	int length = snprintf(path, size, "%s%s", savePathPrefix, fileName);
+	return length >= 0 && length < size;
+}
@@ -0,0 +1,421 @@
+/*
+ * A queue for writing save files a little at a time.  Saves are copied
+ * into the queue and written in small chunks from updateAll, with a limit
+ * on how long each frame can spend writing, so a slow SD card doesn't
+ * stall the game.  Saves to the same file that haven't started yet are
+ * merged together.
+ */
+#include <stdio.h>
+
+#include "GEM_functions.h"
+
+/*
+ * A save waiting to be written.
+ * fileName - The name of the file to write.
+ * data - The copy of the data to write.
+ * size - The size of the data.
+ * written - The amount of the data that has been written.
+ * append - Whether the data is added to the end of the file.
+ * file - The temporary file being written, or NULL if it hasn't been started.
+ * oldFile - For an append, the file being copied into the temporary file
+ * before the data, or NULL once it has all been copied.
+ * queuedTicks - When the save was first queued.
+ */
+typedef struct saveRequest_t
+{
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8* data;
+	int size;
+	int written;
+	bool append;
+	FILE* file;
+	FILE* oldFile;
+	u32 queuedTicks;
+} saveRequest_t;
+
+/*
+ * The saves waiting to be written, in the order they were queued.
+ */
+saveRequest_t saveRequests[MAX_SAVE_REQUESTS];
+
+/*
+ * The amount of saves in the queue.
+ */
+int saveRequestCount = 0;
+
+/*
+ * How long each frame can spend writing saves, in clock ticks.
+ */
+u32 saveBudget = DEFAULT_SAVE_BUDGET;
+
+/*
+ * The time the last save took, and the longest time a save has taken.
+ */
+u32 lastSaveLatency = 0;
+u32 maxSaveLatency = 0;
+
+/*
+ * The amount of saves that failed to write.
+ */
+u32 failedSaveCount = 0;
+
+/*
+ * A buffer for copying a file that is being appended to.
+ */
+u8 saveCopyBuffer[SAVE_CHUNK_SIZE];
+
+/*
+ * Gets the name of the temporary file a save is written to before it
+ * replaces the file.
+ * @param fileName The name of the file being saved.
+ * @param tempName Set to the temporary file's name.
+ * @param size The size of tempName, which should be MAX_SAVE_TEMP_PATH_LENGTH.
+ * @return Returns true if the name fit.
+ */
+bool getTempSavePath(const char* fileName, char* tempName, int size)
+{
+	int length = snprintf(tempName, size, "%s.tmp", fileName);
+	return length >= 0 && length < size;
+}
+
+/*
+ * Closes the temporary file a save was written to, which then replaces
+ * the file being saved.
+ * @param file The temporary file that was written.
+ * @param fileName The name of the file being saved.
+ * @return Returns true if the save is in place.
+ */
+static bool closeSaveFile(FILE* file, const char* fileName)
+{
+	char tempName[MAX_SAVE_TEMP_PATH_LENGTH];
+
+	fclose(file);
+
+	/*
+	 * FAT can't rename over a file, so the old file is removed first.
+	 * If the power goes between the two, the temporary file is still
+	 * there to be loaded.
+	 */
+	if(!getTempSavePath(fileName, tempName, sizeof(tempName)))
+	{
+		return false;
+	}
+	remove(fileName);
+	return rename(tempName, fileName) == 0;
+}
+
+/*
+ * Puts a temporary file back in place of the file it was saving, if the
+ * power went after the file was removed but before the temporary file
+ * was renamed.  Must be done before an append, which would otherwise
+ * write over the temporary file, the only copy of the save.
+ * @param fileName The name of the file being saved.
+ * @param tempName The name of its temporary file.
+ * @return Returns false if the temporary file couldn't be put in place.
+ */
+static bool restoreTempSaveFile(const char* fileName, const char* tempName)
+{
+	FILE* file = fopen(fileName, "rb");
+
+	if(file != NULL)
+	{
+		fclose(file);
+		return true;
+	}
+
+	/*
+	 * Neither file being there just means nothing has been saved yet.
+	 */
+	file = fopen(tempName, "rb");
+	if(file == NULL)
+	{
+		return true;
+	}
+	fclose(file);
+
+	return rename(tempName, fileName) == 0;
+}
+
+/*
+ * Removes the save at the front of the queue.  A save that failed part
+ * of the way through has its files closed.
+ */
+static void popSaveRequest()
+{
+	if(saveRequests[0].oldFile != NULL)
+	{
+		fclose(saveRequests[0].oldFile);
+	}
+	free(saveRequests[0].data);
+	saveRequestCount -= 1;
+	memmove(&saveRequests[0], &saveRequests[1], saveRequestCount * sizeof(saveRequest_t));
+}
+
+/*
+ * Queues data to be written to a file.  The data is copied, so it can
+ * be changed straight after.  Every save is written to a temporary file
+ * which replaces the file once it has all been written, so the old file is
+ * never left half written; appends copy the old file into the temporary
+ * file first.  If the file already has a save waiting that hasn't started,
+ * they are merged: a new whole file replaces the old data, and appends are
+ * added to the end of it.
+ * @param fileName The name of the file to write.
+ * @param data The data to write.
+ * @param size The size of the data in bytes.
+ * @param append Whether to add the data to the end of the file instead of
+ * replacing the file.
+ * @return Returns true if the save was queued, false if it couldn't be.
+ */
+bool queueSave(const char* fileName, const void* data, int size, bool append)
+{
+	int i;
+
+	/*
+	 * Looks for a save to the same file that can be merged with.  Only
+	 * the last save to the file is checked, so that the file's saves are
+	 * still written in order.
+	 */
+	for(i = saveRequestCount - 1; i >= 0; i -= 1)
+	{
+		if(strcmp(saveRequests[i].fileName, fileName) == 0)
+		{
+			break;
+		}
+	}
+
+	if(i >= 0 && saveRequests[i].file == NULL)
+	{
+		saveRequest_t* request = &saveRequests[i];
+		int offset = append ? request->size : 0;
+		u8* merged = (u8*)realloc(request->data, offset + size);
+
+		if(merged != NULL)
+		{
+			memcpy(merged + offset, data, size);
+			request->data = merged;
+			request->size = offset + size;
+
+			/*
+			 * A whole file replaces whatever was going to be written,
+			 * while appends keep the old save's mode.
+			 */
+			if(!append)
+			{
+				request->append = false;
+			}
+			return true;
+		}
+	}
+
+	/*
+	 * Otherwise the save is added to the end of the queue.  If the queue
+	 * is full, the queued saves are written first to make room, so that
+	 * the file's saves stay in order.
+	 */
+	if(saveRequestCount >= MAX_SAVE_REQUESTS)
+	{
+		flushSaveQueue();
+	}
+	if(strlen(fileName) >= MAX_SAVE_PATH_LENGTH)
+	{
+		failedSaveCount += 1;
+		return false;
+	}
+
+	saveRequest_t* request = &saveRequests[saveRequestCount];
+
+	request->data = (u8*)malloc(size);
+	if(request->data == NULL)
+	{
+		failedSaveCount += 1;
+		return false;
+	}
+
+	memcpy(request->data, data, size);
+	strcpy(request->fileName, fileName);
+	request->size = size;
+	request->written = 0;
+	request->append = append;
+	request->file = NULL;
+	request->oldFile = NULL;
+	request->queuedTicks = getTimeTicks();
+	saveRequestCount += 1;
+	return true;
+}
+
+/*
+ * Writes the next chunk of the save at the front of the queue.  An append
+ * first copies the old file into the temporary file, one chunk at a time.
+ * @return Returns false if the save failed.
+ */
+static bool writeSaveChunk()
+{
+	saveRequest_t* request = &saveRequests[0];
+	char tempName[MAX_SAVE_TEMP_PATH_LENGTH];
+
+	if(request->file == NULL)
+	{
+		if(getTempSavePath(request->fileName, tempName, sizeof(tempName))
+				&& (!request->append || restoreTempSaveFile(request->fileName, tempName)))
+		{
+			request->file = fopen(tempName, "wb");
+		}
+		if(request->file == NULL)
+		{
+			failedSaveCount += 1;
+			popSaveRequest();
+			return false;
+		}
+
+		/*
+		 * A missing file just means there is nothing to append to.
+		 */
+		if(request->append)
+		{
+			request->oldFile = fopen(request->fileName, "rb");
+		}
+	}
+
+	if(request->oldFile != NULL)
+	{
+		size_t copied = fread(saveCopyBuffer, 1, SAVE_CHUNK_SIZE, request->oldFile);
+		if(copied > 0 && fwrite(saveCopyBuffer, 1, copied, request->file) != copied)
+		{
+			fclose(request->file);
+			failedSaveCount += 1;
+			popSaveRequest();
+			return false;
+		}
+		if(copied < SAVE_CHUNK_SIZE)
+		{
+			fclose(request->oldFile);
+			request->oldFile = NULL;
+		}
+		return true;
+	}
+
+	int length = request->size - request->written;
+	if(length > SAVE_CHUNK_SIZE)
+	{
+		length = SAVE_CHUNK_SIZE;
+	}
+
+	if(length > 0 && fwrite(request->data + request->written, 1, length, request->file) != (size_t)length)
+	{
+		fclose(request->file);
+		failedSaveCount += 1;
+		popSaveRequest();
+		return false;
+	}
+	request->written += length;
+
+	/*
+	 * Once all of the data is written, the temporary file replaces the
+	 * file and the save's latency is recorded.
+	 */
+	if(request->written >= request->size)
+	{
+		if(!closeSaveFile(request->file, request->fileName))
+		{
+			failedSaveCount += 1;
+			popSaveRequest();
+			return false;
+		}
+
+		lastSaveLatency = getTimeTicks() - request->queuedTicks;
+		if(lastSaveLatency > maxSaveLatency)
+		{
+			maxSaveLatency = lastSaveLatency;
+		}
+
+		popSaveRequest();
+	}
+
+	return true;
+}
+
+/*
+ * Writes the queued saves until the frame's time budget is spent.
+ * Called by updateAll each frame.
+ */
+void updateSaveQueue()
+{
+	u32 start = getTimeTicks();
+
+	/*
+	 * At least one chunk is written each frame, so saves always
+	 * finish no matter how small the budget is.
+	 */
+	do
+	{
+		if(saveRequestCount == 0)
+		{
+			return;
+		}
+		writeSaveChunk();
+	}
+	while(getTimeTicks() - start < saveBudget);
+}
+
+/*
+ * Writes every queued save straight away.  Should be called before
+ * reading a file that may have a save waiting, and before the game exits.
+ * @return Returns true if every save was written, false if any failed.
+ */
+bool flushSaveQueue()
+{
+	bool written = true;
+
+	while(saveRequestCount > 0)
+	{
+		written = writeSaveChunk() && written;
+	}
+
+	return written;
+}
+
+/*
+ * Sets how long each frame can spend writing saves.
+ * @param ticks The time in clock ticks (0 writes one chunk per frame).
+ */
+void setSaveBudget(u32 ticks)
+{
+	saveBudget = ticks;
+}
+
+/*
+ * Gets the amount of saves waiting to be written.
+ * @return Returns the amount of saves.
+ */
+int getSaveQueueDepth()
+{
+	return saveRequestCount;
+}
+
+/*
+ * Gets how long the last save took, from being queued to being written.
+ * @return Returns the time in clock ticks.
+ */
+u32 getLastSaveLatency()
+{
+	return lastSaveLatency;
+}
+
+/*
+ * Gets the longest time a save has taken, from being queued to being
+ * written.
+ * @return Returns the time in clock ticks.
+ */
+u32 getMaxSaveLatency()
+{
+	return maxSaveLatency;
+}
+
+/*
+ * Gets the amount of saves that failed to write.
+ * @return Returns the amount of failed saves.
+ */
+u32 getFailedSaveCount()
+{
+	return failedSaveCount;
+}
@@ -5,8 +5,6 @@
  * features.
  * Created by: Gerald McAlister
  */
-#include <unistd.h>
-#include <dirent.h>
 #include <stdio.h>
 
 #include "GEM_functions.h"
@@ -96,98 +94,103 @@ void createUserData(const char* user)
 }
 
 /*
- * Loads user data with the given file name.
- * @param user The name of the usr file to create.
+ * Gets the path of a user's data file.
+ * @param user The name of the user.
+ * @param fileName Set to the file's path.
+ * @param size The size of the path.
+ * @return Returns true if there is somewhere to save the user's data.
  */
-void loadUserData(const char* user)
+static bool getUserDataFileName(const char* user, char* fileName, int size)
 {
-	/*
-	 * Creates a temporary file name for the file.
-	 */
-	char fileName[65];
+	char name[68];
 
-	/*
-	 * Copies the user's name to the file name.
-	 */
-	strncpy(fileName, user, (strlen(user) > 60) ? 60 : strlen(user));
-	/*
-	 * Concatenates the .usr extension to the end of the user file.
-	 */
-	strncat(fileName, ".usr", 4);
-	/*
-	 * Finally, the last character in the file name is set to be null terminated.
-	 */
-	fileName[strlen(user) + 4] = '\0';
+	snprintf(name, sizeof(name), "%.60s.usr", user);
+	return getSavePath(name, fileName, size);
+}
 
-	/*
-	 * Then, it attempts to switch to the data directory.
-	 */
-	if (chdir("data") != 0)
+/*
+ * Reads user data saved before the save container was added, which was
+ * the userData_t structure written as it is in memory.
+ * @param fileName The name of the file.
+ * @return Returns true if the user's data was read.
+ */
+static bool loadLegacyUserData(const char* fileName)
+{
+	FILE* file = fopen(fileName, "rb");
+
+	if(file == NULL)
 	{
-		/*
-		 * If it fails to switch to the data directory, then
-		 * the data directory is created.
-		 */
-		mkdir("data", 0777);
-		/*
-		 * It is then switched to again.
-		 */
-		chdir("data");
+		return false;
 	}
+
 	/*
-	 * It then attempts to switch to the applications speicifc data
-	 * directory.
+	 * The old file is exactly the size of the structure, so anything
+	 * else is not a save.
 	 */
-	if (chdir(GAME_TITLE) != 0)
-	{
-		/*
-		 * If that fails, then it creates the directory.
-		 */
-		mkdir(GAME_TITLE, 0777);
-		/*
-		 * Then, it goes into it.
-		 */
-		chdir(GAME_TITLE);
-	}
+	fseek(file, 0, SEEK_END);
+	bool valid = ftell(file) == sizeof(userData_t);
+	fseek(file, 0, SEEK_SET);
 
+	valid = valid && fread(currentUser, 1, sizeof(userData_t), file) == sizeof(userData_t);
+	fclose(file);
+
+	currentUser->name[sizeof(currentUser->name) - 1] = '\0';
+	currentUser->message[sizeof(currentUser->message) - 1] = '\0';
+	return valid;
+}
+
+/*
+ * Loads user data with the given file name.
+ * @param user The name of the usr file to create.
+ */
+void loadUserData(const char* user)
+{
 	/*
-	 * Then, the file is opened in reading binary mode.
+	 * Creates a temporary file name for the file, and a buffer for
+	 * the save's data.
 	 */
-	FILE* file = fopen(fileName, "rb");
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8 data[USER_DATA_SAVE_SIZE];
+	saveReader_t reader;
+	u16 version;
+	bool hasFile = getUserDataFileName(user, fileName, sizeof(fileName));
 
 	/*
-	 * Checks if the file exists.
+	 * The current user is allocated the first time a user is loaded.
 	 */
-	if (file != NULL)
+	if (currentUser == NULL)
 	{
-		/*
-		 * If so, then the current users is allocated to the size of a user.
-		 */
 		currentUser = (userData_t*) malloc(sizeof(userData_t));
-		/*
-		 * Then, the user's data is read into the current user structure.
-		 */
-		fread(currentUser, 1, sizeof(userData_t), file);
+	}
+	memset(currentUser, 0, sizeof(userData_t));
 
+	/*
+	 * Then, the save is loaded and checked.
+	 */
+	if (hasFile && readSaveFile(fileName, USER_DATA_MAGIC, USER_DATA_VERSION, &version, data, sizeof(data), &reader))
+	{
 		/*
-		 * Afterwards, the file is closed.
+		 * Each field is unpacked in the order it was added.  Fields added
+		 * in later versions read as zero from older saves, so each
+		 * version only has to fill in the fields it added.
 		 */
-		fclose(file);
-
+		readSaveBytes(&reader, currentUser->name, sizeof(currentUser->name) - 1);
+		readSaveBytes(&reader, currentUser->message, sizeof(currentUser->message) - 1);
+		currentUser->birthday.day = readSaveU8(&reader);
+		currentUser->birthday.month = readSaveU8(&reader);
+		currentUser->birthday.year = readSaveU16(&reader);
+	}
+	else if (hasFile && loadLegacyUserData(fileName))
+	{
 		/*
-		 * And the system goes back to the root directory.
+		 * A save in the old format is saved again in the new one.
 		 */
-		chdir("../..");
+		saveUserData(user);
 	}
 	else
 	{
 		/*
-		 * Otherwise, the system goes back to the root directory.
-		 */
-		chdir("../..");
-
-		/*
-		 * And the user's data file is created.
+		 * Otherwise, the user's data file is created.
 		 */
 		createUserData(user);
 	}
@@ -205,74 +208,39 @@ void loadUserData(const char* user)
 void saveUserData(const char* user)
 {
 	/*
-	 * Creates a temporary file name for the file.
+	 * Creates a temporary file name for the file, and a buffer for
+	 * the save's data.
 	 */
-	char fileName[65];
+	char fileName[MAX_SAVE_PATH_LENGTH];
+	u8 data[USER_DATA_SAVE_SIZE];
+	saveWriter_t writer;
 
 	/*
-	 * Copies the user's name to the file name.
-	 */
-	strncpy(fileName, user, (strlen(user) > 60) ? 60 : strlen(user));
-	/*
-	 * Concatenates the .usr extension to the end of the user file.
+	 * Without a save folder, there is nowhere to save.
 	 */
-	strncat(fileName, ".usr", 4);
-	/*
-	 * Finally, the last character in the file name is set to be null terminated.
-	 */
-	fileName[strlen(user) + 4] = '\0';
-
-	/*
-	 * Then, it attempts to switch to the data directory.
-	 */
-	if (chdir("data") != 0)
-	{
-		/*
-		 * If it fails to switch to the data directory, then
-		 * the data directory is created.
-		 */
-		mkdir("data", 0777);
-		/*
-		 * It is then switched to again.
-		 */
-		chdir("data");
-	}
-	/*
-	 * It then attempts to switch to the applications speicifc data
-	 * directory.
-	 */
-	if (chdir(GAME_TITLE) != 0)
+	if (!getUserDataFileName(user, fileName, sizeof(fileName)))
 	{
-		/*
-		 * If that fails, then it creates the directory.
-		 */
-		mkdir(GAME_TITLE, 0777);
-		/*
-		 * Then, it goes into it.
-		 */
-		chdir(GAME_TITLE);
+		return;
 	}
 
 	/*
-	 * Then, the file is opened in writing binary mode.
+	 * Each field is packed on its own, so the save doesn't depend on
+	 * how the structure is laid out.  New fields go on the end, along
+	 * with a new USER_DATA_VERSION.
 	 */
-	FILE* file = fopen(fileName, "wb");
+	initSaveWriter(&writer, data, sizeof(data));
+	writeSaveBytes(&writer, currentUser->name, sizeof(currentUser->name) - 1);
+	writeSaveBytes(&writer, currentUser->message, sizeof(currentUser->message) - 1);
+	writeSaveU8(&writer, currentUser->birthday.day);
+	writeSaveU8(&writer, currentUser->birthday.month);
+	writeSaveU16(&writer, currentUser->birthday.year);
 
 	/*
-	 * Afterwards, the current user's data is written to the
-	 * file.
+	 * The save is then queued to be written to a temporary file that
+	 * replaces the old one, so that the game doesn't stall while it is
+	 * saved and a save is never left half written.
 	 */
-	fwrite(currentUser, 1, sizeof(userData_t), file);
-
-	/*
-	 * The the file is closed.
-	 */
-	fclose(file);
-
-	/*
-	 * And the Nintendo DS/DSi switches back to the root directory.
-	 */
-	chdir("../..");
+	writeSaveFile(fileName, USER_DATA_MAGIC, USER_DATA_VERSION, &writer);
 }
 
 /*
@@ -284,61 +252,86 @@ void deleteUserData(const char* user)
 	/*
 	 * Creates a temporary file name for the file.
 	 */
-	char fileName[65];
+	char fileName[MAX_SAVE_PATH_LENGTH];
+
+	if (!getUserDataFileName(user, fileName, sizeof(fileName)))
+	{
+		return;
+	}
 
 	/*
-	 * Copies the user's name to the file name.
-	 */
-	strncpy(fileName, user, (strlen(user) > 60) ? 60 : strlen(user));
-	/*
-	 * Concatenates the .usr extension to the end of the user file.
-	 */
-	strncat(fileName, ".usr", 4);
-	/*
-	 * Finally, the last character in the file name is set to be null terminated.
+	 * Any queued saves are written first, so that they don't create
+	 * the file again afterwards.
 	 */
-	fileName[strlen(user) + 4] = '\0';
+	flushSaveQueue();
 
 	/*
-	 * Then, it attempts to switch to the data directory.
+	 * The file is then removed from the device.
 	 */
-	if (chdir("data") != 0)
+	remove(fileName);
+}
+
+/*
+ * Copies a name into a form that is safe to use in a file name.  Anything
+ * other than letters, numbers, '-' and '_' becomes '_'.
+ * @param name The name, as 16 bit characters.
+ * @param length The length of the name.
+ * @param dest Set to the safe name.
+ * @param size The size of the safe name.
+ * @return Returns the length of the safe name.
+ */
+static int sanitizeUserName(const u16* name, int length, char* dest, int size)
+{
+	int i = 0;
+
+	for (i = 0; i < length && i < size - 1 && name[i] != 0; i += 1)
 	{
-		/*
-		 * If it fails to switch to the data directory, then
-		 * the data directory is created.
-		 */
-		mkdir("data", 0777);
-		/*
-		 * It is then switched to again.
-		 */
-		chdir("data");
+		u16 c = name[i];
+		bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+				|| c == '-' || c == '_';
+		dest[i] = safe ? (char)c : '_';
 	}
-	/*
-	 * It then attempts to switch to the applications speicifc data
-	 * directory.
-	 */
-	if (chdir(GAME_TITLE) != 0)
+	dest[i] = '\0';
+
+	return i;
+}
+
+/*
+ * Gets the name of the current user, in a form that is safe to use in a
+ * file name.  If no user is loaded, the name set on the Nintendo DS/DSi
+ * is used.
+ * @param name Set to the user's name.
+ * @param size The size of the name (at least 11).
+ */
+void getCurrentUserName(char* name, int size)
+{
+	u16 wideName[10];
+	int length = 0;
+
+	if (currentUser != NULL)
 	{
 		/*
-		 * If that fails, then it creates the directory.
-		 */
-		mkdir(GAME_TITLE, 0777);
-		/*
-		 * Then, it goes into it.
+		 * The loaded user's name is widened so it can be checked in
+		 * the same way as the DS/DSi's.
 		 */
-		chdir(GAME_TITLE);
+		for (length = 0; length < 10 && currentUser->name[length] != '\0'; length += 1)
+		{
+			wideName[length] = (u8)currentUser->name[length];
+		}
+	}
+	else
+	{
+		length = (PersonalData->nameLen > 10) ? 10 : PersonalData->nameLen;
+		memcpy(wideName, (const void*)PersonalData->name, length * sizeof(u16));
 	}
 
 	/*
-	 * The file is then removed from the device.
-	 */
-	remove(fileName);
-
-	/*
-	 * And the directory is set to the root directory again.
+	 * An empty name (IE: on an emulator) falls back to "player".
 	 */
-	chdir("../..");
+	if (sanitizeUserName(wideName, length, name, size) == 0)
+	{
+		snprintf(name, size, "player");
+	}
 }
 
 /*
@@ -0,0 +1,268 @@
+/*
+ * The computer opponent for single player.  It keeps a model of the
+ * player's choices (how often each is picked, and what tends to follow the
+ * last one and the last two), predicts the next choice from it, and plays
+ * whatever does best against the prediction.  Updating the model and
+ * choosing a move both take the same small amount of work every match, and
+ * all of the tables are fixed size so nothing is allocated while playing.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "aiOpponent.h"
+
+/*
+ * The settings for each difficulty level.
+ * randomChance - The chance out of 256 of playing a random move.
+ * decayShift - How quickly old choices are forgotten; each update keeps
+ * 1 - 1 / 2^decayShift of a row.
+ * weights - How much each table counts towards the prediction (frequency,
+ * after the last choice, after the last two choices).
+ */
+typedef struct aiLevel_t
+{
+	int randomChance;
+	int decayShift;
+	int weights[3];
+} aiLevel_t;
+
+const aiLevel_t aiLevels[AI_DIFFICULTIES] = {
+	{192, 2, {4, 0, 0}},
+	{80, 3, {1, 2, 0}},
+	{24, 4, {1, 2, 4}}
+};
+
+/*
+ * The results table the computer plays by.
+ */
+const int (*aiResults)[AI_CHOICES] = NULL;
+
+/*
+ * The computer's difficulty level.
+ */
+aiDifficulty_t aiDifficulty = AI_NORMAL;
+
+/*
+ * How often the player picks each choice.
+ */
+u16 aiFrequency[AI_CHOICES];
+
+/*
+ * How often the player picks each choice after each choice.
+ */
+u16 aiOrder1[AI_CHOICES][AI_CHOICES];
+
+/*
+ * How often the player picks each choice after each pair of choices.
+ */
+u16 aiOrder2[AI_CHOICES][AI_CHOICES][AI_CHOICES];
+
+/*
+ * The player's last two choices, or -1 if there haven't been any.
+ */
+int aiLastChoice = -1;
+int aiSecondLastChoice = -1;
+
+/*
+ * Sets up the computer opponent, clearing its model of the player.
+ * @param results The results table, where results[a][b] is the result of
+ * choice a against choice b (-1 is a loss, 0 a tie, 1 a win).
+ * @param difficulty The difficulty level.
+ */
+void initAiOpponent(const int results[AI_CHOICES][AI_CHOICES], aiDifficulty_t difficulty)
+{
+	aiResults = results;
+	setAiDifficulty(difficulty);
+
+	memset(aiFrequency, 0, sizeof(aiFrequency));
+	memset(aiOrder1, 0, sizeof(aiOrder1));
+	memset(aiOrder2, 0, sizeof(aiOrder2));
+	aiLastChoice = aiSecondLastChoice = -1;
+}
+
+/*
+ * Starts the model's choice counts from the player's saved history, so the
+ * computer doesn't start from nothing each session.
+ * @param choices The amount of times each choice has been picked.
+ * @param lastChoice The player's last choice, or -1 if there isn't one.
+ */
+void seedAiOpponent(const u16 choices[AI_CHOICES], int lastChoice)
+{
+	u32 total = 0;
+	int i = 0;
+
+	for(i = 0;i < AI_CHOICES;i += 1)
+	{
+		total += choices[i];
+	}
+
+	/*
+	 * The history is scaled down to the weight of a few matches, so
+	 * that this session's choices soon take over.
+	 */
+	for(i = 0;i < AI_CHOICES && total > 0;i += 1)
+	{
+		aiFrequency[i] = (choices[i] * 4 * AI_COUNT_ONE) / total;
+	}
+
+	aiLastChoice = (lastChoice >= 0 && lastChoice < AI_CHOICES) ? lastChoice : -1;
+	aiSecondLastChoice = -1;
+}
+
+/*
+ * Sets the computer's difficulty level.
+ * @param difficulty The difficulty level.
+ */
+void setAiDifficulty(aiDifficulty_t difficulty)
+{
+	aiDifficulty = (difficulty >= 0 && difficulty < AI_DIFFICULTIES) ? difficulty : AI_NORMAL;
+}
+
+/*
+ * Gets the computer's difficulty level.
+ * @return Returns the difficulty level.
+ */
+aiDifficulty_t getAiDifficulty()
+{
+	return aiDifficulty;
+}
+
+/*
+ * Adds a row of a table to the prediction.  Each row is scaled to the same
+ * total first, so the weights decide how much each table counts.
+ * @param prediction The prediction to add to.
+ * @param row The row of the table.
+ * @param weight How much the row counts.
+ */
+static void addToPrediction(u32 prediction[AI_CHOICES], const u16 row[AI_CHOICES], int weight)
+{
+	u32 total = 0;
+	int i = 0;
+
+	for(i = 0;i < AI_CHOICES;i += 1)
+	{
+		total += row[i];
+	}
+
+	if(total == 0 || weight == 0)
+	{
+		return;
+	}
+
+	for(i = 0;i < AI_CHOICES;i += 1)
+	{
+		prediction[i] += ((row[i] << 12) / total) * weight;
+	}
+}
+
+/*
+ * Chooses the computer's next move.
+ * @return Returns the choice (0 to AI_CHOICES - 1).
+ */
+int chooseAiMove()
+{
+	const aiLevel_t* level = &aiLevels[aiDifficulty];
+	u32 prediction[AI_CHOICES] = {0};
+	int best = rand() % AI_CHOICES;
+	int start = best;
+	s32 bestScore = 0;
+	s32 score = 0;
+	int move = 0;
+	int choice = 0;
+	int i = 0;
+
+	/*
+	 * Some moves are random, so the computer can't be read either.
+	 */
+	if(aiResults == NULL || (rand() & 0xFF) < level->randomChance)
+	{
+		return best;
+	}
+
+	/*
+	 * Predicts the player's next choice from each table that has
+	 * something to go on.
+	 */
+	addToPrediction(prediction, aiFrequency, level->weights[0]);
+	if(aiLastChoice >= 0)
+	{
+		addToPrediction(prediction, aiOrder1[aiLastChoice], level->weights[1]);
+	}
+	if(aiSecondLastChoice >= 0)
+	{
+		addToPrediction(prediction, aiOrder2[aiSecondLastChoice][aiLastChoice], level->weights[2]);
+	}
+
+	/*
+	 * Then plays the move with the best expected result against the
+	 * prediction.  Starting from a random move breaks ties fairly.
+	 */
+	for(i = 0;i < AI_CHOICES;i += 1)
+	{
+		move = (start + i) % AI_CHOICES;
+		score = 0;
+
+		for(choice = 0;choice < AI_CHOICES;choice += 1)
+		{
+			score += aiResults[move][choice] * (s32)prediction[choice];
+		}
+
+		if(i == 0 || score > bestScore)
+		{
+			bestScore = score;
+			best = move;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Fades a row of a table and adds a choice to it.
+ * @param row The row of the table.
+ * @param choice The choice to add.
+ * @param decayShift How quickly the row fades.
+ */
+static void updateRow(u16 row[AI_CHOICES], int choice, int decayShift)
+{
+	int i = 0;
+
+	for(i = 0;i < AI_CHOICES;i += 1)
+	{
+		row[i] -= row[i] >> decayShift;
+	}
+
+	/*
+	 * The decay keeps the counts well below the max, but it is checked
+	 * anyway so a count can never wrap around.
+	 */
+	row[choice] = (row[choice] > 0xFFFF - AI_COUNT_ONE) ? 0xFFFF : row[choice] + AI_COUNT_ONE;
+}
+
+/*
+ * Adds the player's choice to the computer's model.  Should be called
+ * after each match.
+ * @param choice The player's choice.
+ */
+void observePlayerMove(int choice)
+{
+	int decayShift = aiLevels[aiDifficulty].decayShift;
+
+	if(choice < 0 || choice >= AI_CHOICES)
+	{
+		return;
+	}
+
+	updateRow(aiFrequency, choice, decayShift);
+	if(aiLastChoice >= 0)
+	{
+		updateRow(aiOrder1[aiLastChoice], choice, decayShift);
+	}
+	if(aiSecondLastChoice >= 0)
+	{
+		updateRow(aiOrder2[aiSecondLastChoice][aiLastChoice], choice, decayShift);
+	}
+
+	aiSecondLastChoice = aiLastChoice;
+	aiLastChoice = choice;
+}
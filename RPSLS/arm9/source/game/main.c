@@ -6,38 +6,27 @@
 // Inlcude the functions from the game library.
 #include "GEM_functions.h"
 
-// Include the background images.
-#include "top_main.h"
-#include "gameover_top.h"
-#include "gameover_top_p1.h"
-#include "gameover_top_p2.h"
-#include "gameover_bottom.h"
+// Include the computer opponent for single player.
+#include "aiOpponent.h"
 
+// Include the logo images.  The rest of the graphics are
+// loaded from NitroFS when they are needed.
 #include "neocompoLogo.h"
 #include "devLogo.h"
 
-// Include the top screen logo.
-#include "logo.h"
-
-// Include the menu buttons.
-#include "singlePlayerButtonLeft.h"
-#include "singlePlayerButtonRight.h"
-#include "multiPlayerButtonLeft.h"
-#include "multiPlayerButtonRight.h"
-
-// Include the bottom screen's sprites.
-#include "rock.h"
-#include "paper.h"
-#include "scissors.h"
-#include "lizard.h"
-#include "spock.h"
-
-// Include the top screen's sprites.
-#include "healthbar.h"
+// Include the font for the variable width text.
+#include "font.h"
 
 // The total number of buttons to choose from.
 #define TOTAL_BUTTONS 5
 
+// The game's ID for its achievements.
+#define GAME_ID "RPSLS"
+
+// The IDs of the game's achievements.
+#define ACHIEVEMENT_FIRST_WIN 0
+#define ACHIEVEMENT_TEN_WINS 1
+
 // A enumorator for the game mode.
 // Has a single player and multiplayer mode.
 // Multiplayer mode is not implemented in the game yet.
@@ -60,12 +49,18 @@ const int resultsTable[5][5] = {
 	{1, -1, 1, -1, 0}
 };
 
-// An array holding pointers to the graphics for each selection.
-const unsigned int* selectionSprites[5] = {rockTiles, paperTiles, scissorsTiles, lizardTiles, spockTiles};
-// An array holding pointers to the graphic's size for each selection.
-const u32 selectionSpritesSizes[5] = {rockTilesLen, paperTilesLen, scissorsTilesLen, lizardTilesLen, spockTilesLen};
-// An array holding pointers to the palette for each selection.
-const unsigned short* selectionSpritesPal[5] = {rockPal, paperPal, scissorsPal, lizardPal, spockPal};
+// The variable width font, loaded from the font's tiles at startup.
+font_t gameFont;
+
+// An array holding the names of the graphics for each selection.
+const char* selectionSprites[5] = {"rock", "paper", "scissors", "lizard", "spock"};
+
+// The buttons each player presses for each selection in multiplayer.
+// Player 1 uses the left side of the DS, and player 2 the right side.
+const u32 choiceKeys[2][5] = {
+	{KEY_L, KEY_LEFT, KEY_DOWN, KEY_UP, KEY_RIGHT},
+	{KEY_R, KEY_A, KEY_B, KEY_X, KEY_Y}
+};
 
 /*
  * Gets what button on the main menu is pressed at a given X and Y position.
@@ -138,27 +133,6 @@ unsigned int buttonTouched(int x, int y)
 	return -1;
 }
 
-/*
- * Loads a background into the game with the given data.
- * @param screen The screen to load the background on to.
- * @param layer The layer to set the background to.
- * @param tiles The tiles for the background.
- * @param tilesLen The size of the tiles.
- * @param map The background's map data.
- * @param mapLen The size of the map data.
- * @param pal The backgrounds palette.
- */
-void loadBg(int screen, int layer, const unsigned int* tiles, u32 tilesLen,
-	const unsigned short* map, u32 mapLen, const unsigned short* pal)
-{
-	// Set the backgrounds palette data.
-	setBgPalette(screen, layer, pal);
-	// Set the backgrounds tiles.
-	setBgTiles(screen, layer, tiles, tilesLen);
-	// Map out the backgrounds tiles with the map data.
-	setBgMap(screen, layer, map, mapLen);
-}
-
 /*
  * Chooses a winner for the match.
  * @param choice1 The first player's choice.
@@ -179,9 +153,9 @@ int chooseWinner(int choice1, int choice2)
 int runMatch(int choice1, int choice2)
 {
 	// Create the first player's sprite based on the choice.
-	createSprite(1, 0, 0, selectionSprites[choice1], selectionSpritesSizes[choice1], selectionSpritesPal[choice1], 64, 64);
+	createSpriteAsset(1, 0, 0, selectionSprites[choice1], 64, 64);
 	// Create the second player's sprite based on the choice.
-	createSprite(1, 1, 1, selectionSprites[choice2], selectionSpritesSizes[choice2], selectionSpritesPal[choice2], 64, 64);
+	createSpriteAsset(1, 1, 1, selectionSprites[choice2], 64, 64);
 
 	// The X positions of the sprites.
 	int x1 = -64;
@@ -192,6 +166,8 @@ int runMatch(int choice1, int choice2)
 	int y = 128 - 32;
 	// The rotation of the losing sprite.
 	int rotation = 0;
+	// The amount of logic steps left to run this frame.
+	int steps = 0;
 
 	// The the sprites to the correct positions.
 	setSpriteXY(1, 0, x1, y);
@@ -200,12 +176,19 @@ int runMatch(int choice1, int choice2)
 	// Set the speed to be 4 pixels per movement.
 	int speed = 4;
 
+	// The sprites move a set amount each logic step (60 per second), so
+	// the match runs at the same speed even if a frame is drawn late.
+	startFrameTimer();
+
 	// Move the sprites together until they touch.
 	while(x1 + 64 != x2)
 	{
-		// Update the positions.
-		x1 += speed;
-		x2 -= speed;
+		// Update the positions once for each step that is due.
+		for(steps = getFrameSteps();steps > 0 && x1 + 64 != x2;steps -= 1)
+		{
+			x1 += speed;
+			x2 -= speed;
+		}
 
 		// Set the positions.
 		setSpriteXY(1, 0, x1, y);
@@ -223,13 +206,16 @@ int runMatch(int choice1, int choice2)
 	{
 		while(x2 < 256 && y < 192)
 		{
-			x2 += 1;
-			y += 1;
-			if(rotation >= 360)
+			for(steps = getFrameSteps();steps > 0 && x2 < 256 && y < 192;steps -= 1)
 			{
-				rotation = 0;
+				x2 += 1;
+				y += 1;
+				if(rotation >= 360)
+				{
+					rotation = 0;
+				}
+				rotation -= 4;
 			}
-			rotation -= 4;
 
 			setSpriteXY(1, 1, x2, y);
 			setSpriteAngle(1, 1, 0, rotation);
@@ -242,13 +228,16 @@ int runMatch(int choice1, int choice2)
 	{
 		while(x1 > -64 && y < 192)
 		{
-			x1 -= 1;
-			y += 1;
-			if(rotation >= 360)
+			for(steps = getFrameSteps();steps > 0 && x1 > -64 && y < 192;steps -= 1)
 			{
-				rotation = 0;
+				x1 -= 1;
+				y += 1;
+				if(rotation >= 360)
+				{
+					rotation = 0;
+				}
+				rotation += 4;
 			}
-			rotation += 4;
 
 			setSpriteXY(1, 0, x1, y);
 			setSpriteAngle(1, 0, 0, rotation);
@@ -261,14 +250,17 @@ int runMatch(int choice1, int choice2)
 	{
 		while(x1 > -64 && x2 < 256 && y < 192)
 		{
-			x1 -= 1;
-			x2 += 1;
-			y += 1;
-			if(rotation >= 360)
+			for(steps = getFrameSteps();steps > 0 && x1 > -64 && x2 < 256 && y < 192;steps -= 1)
 			{
-				rotation = 0;
+				x1 -= 1;
+				x2 += 1;
+				y += 1;
+				if(rotation >= 360)
+				{
+					rotation = 0;
+				}
+				rotation += 4;
 			}
-			rotation += 4;
 
 			setSpriteXY(1, 0, x1, y);
 			setSpriteXY(1, 1, x2, y);
@@ -294,13 +286,8 @@ int runMatch(int choice1, int choice2)
  */
 void initializeMainGameGraphics(playerMode mode)
 {
-	int i = 0;
 	// Fade out to black.
-	for(i = 0;i > -16;i -= 2)
-	{
-		setBrightness(3, i);
-		swiWaitForVBlank();
-	}
+	waitForTask(startBrightnessFade(3, 0, -16, 2));
 	// Delete the two screens backgrounds in case of game over.
 	deleteBg(0, 1);
 	deleteBg(1, 1);
@@ -314,42 +301,41 @@ void initializeMainGameGraphics(playerMode mode)
 	if(mode == MENU_MAIN)
 	{
 		createBg(1, 1, 256, 192);
-		loadBg(1, 1, top_mainTiles, top_mainTilesLen,
-			top_mainMap, top_mainMapLen, top_mainPal);
+		loadBgAsset(1, 1, "top_main");
 		
-		createSprite(1, 0, 0, logoTiles, logoTilesLen, logoPal, 64, 64);
+		createSpriteAsset(1, 0, 0, "logo", 64, 64);
 		setSpriteXY(1, 0, 256 / 2 - 24, 192 / 2 - 32);
 	
-		createSprite(0, 0, 0, singlePlayerButtonLeftTiles, singlePlayerButtonLeftTilesLen, singlePlayerButtonLeftPal, 64, 64);
+		createSpriteAsset(0, 0, 0, "singlePlayerButtonLeft", 64, 64);
 		setSpriteXY(0, 0, 256 / 2 - 64, 192 / 2 - 64);
-		createSprite(0, 1, 1, singlePlayerButtonRightTiles, singlePlayerButtonRightTilesLen, singlePlayerButtonRightPal, 64, 64);
+		createSpriteAsset(0, 1, 1, "singlePlayerButtonRight", 64, 64);
 		setSpriteXY(0, 1, 256 / 2 - 64 + 64, 192 / 2 - 64);
 
-		createSprite(0, 2, 2, multiPlayerButtonLeftTiles, multiPlayerButtonLeftTilesLen, multiPlayerButtonLeftPal, 64, 64);
+		createSpriteAsset(0, 2, 2, "multiPlayerButtonLeft", 64, 64);
 		setSpriteXY(0, 2, 256 / 2 - 64, 192 / 2 - 0);
-		createSprite(0, 3, 3, multiPlayerButtonRightTiles, multiPlayerButtonRightTilesLen, multiPlayerButtonRightPal, 64, 64);
+		createSpriteAsset(0, 3, 3, "multiPlayerButtonRight", 64, 64);
 		setSpriteXY(0, 3, 256 / 2 - 64 + 64, 192 / 2 - 0);
 	}
 	// Check if the mode is for a single player.
 	else if(mode == SINGLE_NORMAL)
 	{
 		// Player 1's choices.
-		createSprite(0, 0, 0, rockTiles, rockTilesLen, rockPal, 64, 64);
+		createSpriteAsset(0, 0, 0, "rock", 64, 64);
 		setSpriteXY(0, 0, 32 + (64 * 0), 32 + (64 * 0));
 
-		createSprite(0, 1, 1, paperTiles, paperTilesLen, paperPal, 64, 64);
+		createSpriteAsset(0, 1, 1, "paper", 64, 64);
 		setSpriteXY(0, 1, 32 + (64 * 1), 32 + (64 * 0));
 
-		createSprite(0, 2, 2, scissorsTiles, scissorsTilesLen, scissorsPal, 64, 64);
+		createSpriteAsset(0, 2, 2, "scissors", 64, 64);
 		setSpriteXY(0, 2, 32 + (64 * 2), 32 + (64 * 0));
 
-		createSprite(0, 3, 3, lizardTiles, lizardTilesLen, lizardPal, 64, 64);
+		createSpriteAsset(0, 3, 3, "lizard", 64, 64);
 		setSpriteXY(0, 3, 32 + 32 + (64 * 0), 32 + (64 * 1));
 
-		createSprite(0, 4, 4, spockTiles, spockTilesLen, spockPal, 64, 64);
+		createSpriteAsset(0, 4, 4, "spock", 64, 64);
 		setSpriteXY(0, 4, 32 + 32 + (64 * 1), 32 + (64 * 1));
 
-		createSprite(1, 4, 4, healthbarTiles, healthbarTilesLen, healthbarPal, 64, 64);
+		createSpriteAsset(1, 4, 4, "healthbar", 64, 64);
 		setSpriteXY(1, 4, 0, 0);
 		setSpriteFrame(1, 4, 0);
 		// Player 2's choice don't need to be shown.
@@ -358,22 +344,22 @@ void initializeMainGameGraphics(playerMode mode)
 	else if(mode == MULTI_NORMAL)
 	{
 		// Player 1's choices.
-		createSprite(0, 0, 0, rockTiles, rockTilesLen, rockPal, 64, 64);
+		createSpriteAsset(0, 0, 0, "rock", 64, 64);
 		setSpriteXY(0, 0, 0, 64 * 0);
 
-		createSprite(0, 1, 1, paperTiles, paperTilesLen, paperPal, 64, 64);
+		createSpriteAsset(0, 1, 1, "paper", 64, 64);
 		setSpriteXY(0, 1, 0, 64 * 1);
 
-		createSprite(0, 2, 2, scissorsTiles, scissorsTilesLen, scissorsPal, 64, 64);
+		createSpriteAsset(0, 2, 2, "scissors", 64, 64);
 		setSpriteXY(0, 2, 0, 64 * 2);
 
-		createSprite(0, 3, 3, lizardTiles, lizardTilesLen, lizardPal, 64, 64);
+		createSpriteAsset(0, 3, 3, "lizard", 64, 64);
 		setSpriteXY(0, 3, 64, 64 * 0 + 32);
 
-		createSprite(0, 4, 4, spockTiles, spockTilesLen, spockPal, 64, 64);
+		createSpriteAsset(0, 4, 4, "spock", 64, 64);
 		setSpriteXY(0, 4, 64, 64 * 1 + 32);
 
-		createSprite(1, 4, 4, healthbarTiles, healthbarTilesLen, healthbarPal, 64, 64);
+		createSpriteAsset(1, 4, 4, "healthbar", 64, 64);
 		setSpriteXY(1, 4, 0, 0);
 		setSpriteFrame(1, 4, 0);
 
@@ -393,16 +379,12 @@ void initializeMainGameGraphics(playerMode mode)
 		copySprite(0, 9, 4, 0, 4);
 		setSpriteXY(0, 9, 256 - 128, 64 * 1 + 32);
 
-		createSprite(1, 5, 5, healthbarTiles, healthbarTilesLen, healthbarPal, 64, 64);
+		createSpriteAsset(1, 5, 5, "healthbar", 64, 64);
 		setSpriteXY(1, 5, 256 - 64, 0);
 		setSpriteFrame(1, 5, 0);
 	}
 	// Fade in from black.
-	for(i = -16;i < 0;i += 2)
-	{
-		setBrightness(3, i);
-		swiWaitForVBlank();
-	}
+	waitForTask(startBrightnessFade(3, -16, 0, 2));
 }
 
 /*
@@ -413,11 +395,7 @@ void gameOverScreen(playerMode mode)
 {
 	int i = 0;
 	// Fade out to black.
-	for(i = 0;i > -16;i -= 2)
-	{
-		setBrightness(3, i);
-		swiWaitForVBlank();
-	}
+	waitForTask(startBrightnessFade(3, 0, -16, 2));
 	// Set the number of the sprites.
 	int totalSprites = 5;
 	if(mode == MULTI_NORMAL || mode == MULTI_P1 || mode == MULTI_P2)
@@ -457,115 +435,71 @@ void gameOverScreen(playerMode mode)
 	if(mode == SINGLE_NORMAL)
 	{
 		// Load the game over backgrounds' data.
-		loadBg(0, 1, gameover_bottomTiles, gameover_bottomTilesLen,
-			gameover_bottomMap, gameover_bottomMapLen, gameover_bottomPal);
-		loadBg(1, 1, gameover_topTiles, gameover_topTilesLen,
-			gameover_topMap, gameover_topMapLen, gameover_topPal);
+		loadBgAsset(0, 1, "gameover_bottom");
+		loadBgAsset(1, 1, "gameover_top");
 	}
 	else if(mode == MULTI_NORMAL)
 	{
 		// Load the game over backgrounds' data.
-		loadBg(0, 1, gameover_bottomTiles, gameover_bottomTilesLen,
-			gameover_bottomMap, gameover_bottomMapLen, gameover_bottomPal);
-		loadBg(1, 1, gameover_topTiles, gameover_topTilesLen,
-			gameover_topMap, gameover_topMapLen, gameover_topPal);
+		loadBgAsset(0, 1, "gameover_bottom");
+		loadBgAsset(1, 1, "gameover_top");
 	}
 	else if(mode == MULTI_P1)
 	{
 		// Load the game over backgrounds' data.
-		loadBg(0, 1, gameover_bottomTiles, gameover_bottomTilesLen,
-			gameover_bottomMap, gameover_bottomMapLen, gameover_bottomPal);
-		loadBg(1, 1, gameover_top_p2Tiles, gameover_top_p2TilesLen,
-			gameover_top_p2Map, gameover_top_p2MapLen, gameover_top_p2Pal);
+		loadBgAsset(0, 1, "gameover_bottom");
+		loadBgAsset(1, 1, "gameover_top_p2");
 	}
 	else if(mode == MULTI_P2)
 	{
 		// Load the game over backgrounds' data.
-		loadBg(0, 1, gameover_bottomTiles, gameover_bottomTilesLen,
-			gameover_bottomMap, gameover_bottomMapLen, gameover_bottomPal);
-		loadBg(1, 1, gameover_top_p1Tiles, gameover_top_p1TilesLen,
-			gameover_top_p1Map, gameover_top_p1MapLen, gameover_top_p1Pal);
+		loadBgAsset(0, 1, "gameover_bottom");
+		loadBgAsset(1, 1, "gameover_top_p1");
 	}
 	// Fade in from black.
-	for(i = -16;i < 0;i += 2)
+	waitForTask(startBrightnessFade(3, -16, 0, 2));
+}
+
+/*
+ * Draws the scores from a single player game onto the game over screen
+ * in the variable width font.
+ * @param wins The amount of wins in the game.
+ * @param bestStreak The most wins in a row in the game.
+ */
+void drawGameOverScores(int wins, int bestStreak)
+{
+	char text[32];
+
+	// Make a text area across the lower part of the top screen.
+	if(!createFontArea(1, 0, 2, 17, 28, 5))
 	{
-		setBrightness(3, i);
-		swiWaitForVBlank();
+		return;
 	}
+
+	// Draw each line centered in the area.
+	sprintf(text, "Wins: %d", wins);
+	drawFontString(1, &gameFont, (224 - getFontStringWidth(&gameFont, text)) / 2, 4, text);
+	sprintf(text, "Best streak: %d", bestStreak);
+	drawFontString(1, &gameFont, (224 - getFontStringWidth(&gameFont, text)) / 2, 24, text);
 }
 
 /*
- * Initializes the game's graphics.
+ * Gets the choice a player pressed a button for this frame.
  * @param player The player to get the button press for.
+ * @return Returns the index of the choice, or -1 if no choice was pressed.
  */
 int buttonPressed(int player)
 {
-	// Check if the player's index equals 0. (Player 1)
-	if(player == 0)
-	{
-		// Check for the left key.
-		if(keysHeld() & KEY_LEFT)
-		{
-			// Returns paper.
-			return 1;
-		}
-		// Check for the right key.
-		if(keysHeld() & KEY_RIGHT)
-		{
-			// Returns spock.
-			return 4;
-		}
-		// Check for the up key.
-		if(keysHeld() & KEY_UP)
-		{
-			// Returns lizard.
-			return 3;
-		}
-		// Check for the down key.
-		if(keysHeld() & KEY_DOWN)
-		{
-			// Returns scissor.
-			return 2;
-		}
-		// Check for the L key.
-		if(keysHeld() & KEY_L)
-		{
-			// Returns rock.
-			return 0;
-		}
-	}
-	// Check if the player's index equals 1. (Player 2)
-	else if(player == 1)
+	// Get the player's buttons that were pressed since the last frame.
+	u32 pressed = getPlayerKeysDown(player);
+	int i = 0;
+
+	// Find the first choice whose button was pressed.
+	for(i = 0;i < TOTAL_BUTTONS;i += 1)
 	{
-		// Check for the A key.
-		if(keysHeld() & KEY_A)
-		{
-			// Returns paper.
-			return 1;
-		}
-		// Check for the Y key.
-		if(keysHeld() & KEY_Y)
-		{
-			// Returns spock.
-			return 4;
-		}
-		// Check for the X key.
-		if(keysHeld() & KEY_X)
-		{
-			// Returns lizard.
-			return 3;
-		}
-		// Check for the B key.
-		if(keysHeld() & KEY_B)
-		{
-			// Returns scissor.
-			return 2;
-		}
-		// Check for the R key.
-		if(keysHeld() & KEY_R)
+		if(pressed & choiceKeys[player][i])
 		{
-			// Returns rock.
-			return 0;
+			return i;
 		}
 	}
 	return -1;
@@ -576,27 +510,18 @@ int mainMenu()
 	// Initialize the game's graphics for single player.
 	initializeMainGameGraphics(MENU_MAIN);
 
-	// Create a touch position variable for the touch screen.
-	touchPosition touch;
-
 	// Enter the main game loop.
 	while(1)
 	{
-		// Read the keys being pressed and touch screen data.
-		scanKeys();
-		touchRead(&touch);
+		// Get where the touch screen was touched since the last frame.
+		touchPosition touch = getTouchPosition();
 
 		int choice = menuButtonTouched(touch.px, touch.py);
 
 		if(choice > -1)
 		{
 			// Wait until the player is not holding down on the touch screen.
-			while(keysHeld() & KEY_TOUCH)
-			{
-				scanKeys();
-				// Update all of the game.
-				updateAll();
-			}
+			waitForKeysReleased(KEY_TOUCH);
 			int i = 0;
 			// Delete all of the button sprites.
 			for(i = 0;i < 4;i += 1)
@@ -615,6 +540,21 @@ int mainMenu()
 	return -1;
 }
 
+/*
+ * Submits the scores from a single player game to the leaderboards.
+ * @param wins The amount of wins in the game.
+ * @param bestStreak The most wins in a row in the game.
+ */
+void submitSinglePlayerScores(int wins, int bestStreak)
+{
+	char name[11];
+
+	// Get the player's name, then submit each score.
+	getCurrentUserName(name, sizeof(name));
+	submitScore(LEADERBOARD_WINS, name, wins);
+	submitScore(LEADERBOARD_STREAK, name, bestStreak);
+}
+
 /*
  * Starts the game in single player mode.
  */
@@ -626,72 +566,94 @@ void singlePlayerLoop()
 	// Set the damage, wins, and ties to 0.
 	int damage = 0, wins = 0, ties = 0;
 
-	// Create a touch position variable for the touch screen.
-	touchPosition touch;
+	// The wins in a row, and the most wins in a row this game.
+	int streak = 0, bestStreak = 0;
+
+	// Set up the computer, starting its model of the player from
+	// their saved statistics.  Replays start it from nothing, since the
+	// statistics aren't part of the recording.
+	const matchStats_t* stats = getMatchStats(STATS_SINGLE);
+	initAiOpponent(resultsTable, getAiDifficulty());
+	if(!isReplayRecording() && !isReplayPlaying())
+	{
+		seedAiOpponent(stats->choices, stats->lastChoice);
+	}
+
+	// The computer's difficulty as shown on screen (1 to 3).
+	int level = getAiDifficulty() + 1;
 
 	// Clear the console of any possible old text.
-	consoleClear();
+	clearTextArea(1, 0, 0, 32, 24);
 
-	// Draw the text for the top screen.
-	drawText(1, 16, 2, "Wins: %d", wins);
-	drawText(1, 16, 4, "Ties: %d", ties);
-	drawText(1, 8, 8, "You			Computer");
+	// Create the text for the top screen.  The wins, ties and level
+	// are redrawn on their own whenever they change.
+	createTextWidget(1, 0, 16, 2, "Wins: ", &wins);
+	createTextWidget(1, 1, 16, 4, "Ties: ", &ties);
+	createTextWidget(1, 2, 8, 8, "You			Computer", NULL);
+	createTextWidget(1, 3, 16, 6, "Level: ", &level);
 
 	// Enter the main game loop.
 	while(1)
 	{
-		// Read the keys being pressed and touch screen data.
-		scanKeys();
-		touchRead(&touch);
+		// Get where the touch screen was touched since the last frame.
+		touchPosition touch = getTouchPosition();
 
-		// Check if the start key is down.
-		if(keysDown() & KEY_START)
+		// Check if the start key was pressed.
+		if(consumeKeysDown(KEY_START))
 		{
-			// If so, clear the console and display the game over screen.
-			consoleClear();
+			// If so, hide the text and display the game over screen.
+			setTextWidgetsVisible(1, false);
 			gameOverScreen(SINGLE_NORMAL);
+			drawGameOverScores(wins, bestStreak);
+
+			// Put the game's scores on the leaderboards.
+			submitSinglePlayerScores(wins, bestStreak);
 
 			// While the touchscreen is not being touched, wait
 			// and update the graphics.
-			while(!(keysHeld() & KEY_TOUCH))
-			{
-				scanKeys();
-				if(keysDown() & KEY_START)
-				{
-					break;
-				}
-				updateAll();
-			}
+			waitForKeysDown(KEY_TOUCH | KEY_START);
 			// Once it has been touched, wait until it no longer is.
-			while(keysHeld() & KEY_TOUCH)
-			{
-				scanKeys();
-			}
+			waitForKeysReleased(KEY_TOUCH);
 
-			// Delete the two screens backgrounds in case of game over.
+			// Delete the two screens backgrounds and the text in case of game over.
 			deleteBg(0, 1);
 			deleteBg(1, 1);
+			deleteFontArea(1);
+			deleteTextWidgets(1);
 
 			// Finally, exit the game.
 			return;
 		}
 
+		// The R button changes the computer's difficulty.
+		if(consumeKeysDown(KEY_R))
+		{
+			setAiDifficulty((getAiDifficulty() + 1) % AI_DIFFICULTIES);
+			level = getAiDifficulty() + 1;
+		}
+
 		// Get the player's button choice.
 		int choice = buttonTouched(touch.px, touch.py);
 
 		// If the choie is not negative (IE: The player pressed a button), then run a match.
 		if(choice > -1)
 		{
-			// Run the match with a random number (IE: A "CPU") and store the results
-			// in the choice variable.
-			choice = runMatch(choice, rand() % 5);
+			// Run the match against the computer's choice.
+			int cpuChoice = chooseAiMove();
+			int results = runMatch(choice, cpuChoice);
 
-			// Check the value of hte choice.
-			switch(choice)
+			// Let the computer learn from the player's choice, and record
+			// the match in the player's statistics.
+			observePlayerMove(choice);
+			recordMatch(STATS_SINGLE, choice, cpuChoice, results);
+
+			// Check the value of the results.
+			switch(results)
 			{
 			case -1:
 				// Result of -1 does damage.
 				damage += 1;
+				streak = 0;
 				break;
 			default:
 				// Anything else is a tie.
@@ -700,14 +662,24 @@ void singlePlayerLoop()
 			case 1:
 				// Result of 1 is a win.
 				wins += 1;
+				streak += 1;
+				if(streak > bestStreak)
+				{
+					bestStreak = streak;
+				}
+
+				// Unlock the win achievements.  These are only saved
+				// once the game is over.
+				unlockAchievement(ACHIEVEMENT_FIRST_WIN, 10, GAME_ID, "First Win");
+				if(wins >= 10)
+				{
+					unlockAchievement(ACHIEVEMENT_TEN_WINS, 25, GAME_ID, "Ten Wins");
+				}
 				break;
 			}
 
 			// Wait until the player is not holding down on the touch screen.
-			while(keysHeld() & KEY_TOUCH)
-			{
-				scanKeys();
-			}
+			waitForKeysReleased(KEY_TOUCH);
 
 			// Check that the player has not died yet.
 			if(damage > -1 && damage < 4)
@@ -715,48 +687,44 @@ void singlePlayerLoop()
 				// If so, then set the health bar's frame.
 				setSpriteFrame(1, 4, damage);
 			}
-
-			// Clear the console's old text.
-			consoleClear();
-
-			// Display the current results after the match.
-			drawText(1, 16, 2, "Wins: %d", wins);
-			drawText(1, 16, 4, "Ties: %d", ties);
-			drawText(1, 8, 8, "You			Computer");
 		}
 
 		// Check if the player has recieved too much damage.
 		if(damage > 3)
 		{
-			// If so, clear the console and display the game over screen.
-			consoleClear();
+			// If so, hide the text and display the game over screen.
+			setTextWidgetsVisible(1, false);
 			gameOverScreen(SINGLE_NORMAL);
+			drawGameOverScores(wins, bestStreak);
+
+			// Put the game's scores on the leaderboards.
+			submitSinglePlayerScores(wins, bestStreak);
+
+			// Save any achievements unlocked and the statistics from
+			// this game.
+			flushAchievements();
+			saveMatchStats();
 
 			// While the touchscreen is not being touched, wait
 			// and update the graphics.
-			while(!(keysHeld() & KEY_TOUCH))
-			{
-				scanKeys();
-				updateAll();
-			}
+			waitForKeysDown(KEY_TOUCH);
 			// Once it has been touched, wait until it no longer is.
-			while(keysHeld() & KEY_TOUCH)
-			{
-				scanKeys();
-			}
+			waitForKeysReleased(KEY_TOUCH);
+
+			// Remove the scores from the game over screen.
+			deleteFontArea(1);
 
 			// Then, initialize the graphics for single player again.
 			initializeMainGameGraphics(SINGLE_NORMAL);
 			// Reset the damage, wins', and ties' variables.
 			damage = wins = ties = 0;
+			streak = bestStreak = 0;
 
 			// Set the heatlhbar frame to the initial frame.
 			setSpriteFrame(1, 4, damage);
 
-			// Reset the text.
-			drawText(1, 16, 2, "Wins: %d", wins);
-			drawText(1, 16, 4, "Ties: %d", ties);
-			drawText(1, 8, 8, "You			Computer");
+			// Show the text again.
+			setTextWidgetsVisible(1, true);
 		}
 
 		// Update all of the game.
@@ -775,51 +743,56 @@ void multiPlayerLoop()
 	// Set the damage, wins, and ties to 0.
 	int p1damage = 0, p2damage = 0, p1wins = 0, p2wins = 0, ties = 0;
 
+	// The players' choices.  Each player's choice is kept from when
+	// they press it until the other player has chosen too.
+	int p1choice = -1, p2choice = -1;
+
+	// Give each player their own side of the buttons.
+	setPlayerKeys(0, choiceKeys[0][0] | choiceKeys[0][1] | choiceKeys[0][2] | choiceKeys[0][3] | choiceKeys[0][4]);
+	setPlayerKeys(1, choiceKeys[1][0] | choiceKeys[1][1] | choiceKeys[1][2] | choiceKeys[1][3] | choiceKeys[1][4]);
+
 	// Clear the console of any possible old text.
-	consoleClear();
+	clearTextArea(1, 0, 0, 32, 24);
 
-	// Draw the text for the top screen.
-	drawText(1, 10, 2, "P1 Wins: %d", p1wins);
-	drawText(1, 10, 4, "P2 Wins: %d", p2wins);
-	drawText(1, 10, 6, "Ties: %d", ties);
-	drawText(1, 8, 8, "P1				P2");
+	// Create the text for the top screen.  The wins and ties are
+	// redrawn on their own whenever they change.
+	createTextWidget(1, 0, 10, 2, "P1 Wins: ", &p1wins);
+	createTextWidget(1, 1, 10, 4, "P2 Wins: ", &p2wins);
+	createTextWidget(1, 2, 10, 6, "Ties: ", &ties);
+	createTextWidget(1, 3, 8, 8, "P1				P2", NULL);
 
 	// Enter the main game loop.
 	while(1)
 	{
-		// Read the keys being pressed and touch screen data.
-		scanKeys();
-
-		// Check if the start key is down.
-		if(keysDown() & KEY_START)
+		// Check if the start key was pressed.
+		if(consumeKeysDown(KEY_START))
 		{
-			// If so, clear the console and display the game over screen.
-			consoleClear();
+			// If so, hide the text and display the game over screen.
+			setTextWidgetsVisible(1, false);
 			gameOverScreen(MULTI_NORMAL);
 
 			// While the game is running, wait for the start button.
-			while(1)
-			{
-				scanKeys();
-				if(keysDown() & KEY_START)
-				{
-					break;
-				}
-				updateAll();
-			}
+			waitForKeysDown(KEY_START);
 
-			// Delete the two screens backgrounds in case of game over.
+			// Delete the two screens backgrounds and the text in case of game over.
 			deleteBg(0, 1);
 			deleteBg(1, 1);
+			deleteTextWidgets(1);
 
 			// Finally, exit the game.
 			return;
 		}
 
-		// Get the player 1's button choice.
-		int p1choice = buttonPressed(0);
-		// Get the player 2's button choice.
-		int p2choice = buttonPressed(1);
+		// Get the player 1's button choice, if they haven't chosen yet.
+		if(p1choice < 0)
+		{
+			p1choice = buttonPressed(0);
+		}
+		// Get the player 2's button choice, if they haven't chosen yet.
+		if(p2choice < 0)
+		{
+			p2choice = buttonPressed(1);
+		}
 
 		// If the choies are not negative (IE: The players have pressed a button), then run a match.
 		if(p1choice > -1 && p2choice > -1)
@@ -827,6 +800,12 @@ void multiPlayerLoop()
 			// Run the match and store the results in the results variable.
 			int results = runMatch(p1choice, p2choice);
 
+			// Record the match in player 1's statistics.
+			recordMatch(STATS_MULTI, p1choice, p2choice, results);
+
+			// Both players choose again for the next match.
+			p1choice = p2choice = -1;
+
 			// Check the value of the results.
 			switch(results)
 			{
@@ -860,35 +839,20 @@ void multiPlayerLoop()
 				// If so, then set the health bar's frame.
 				setSpriteFrame(1, 5, p2damage);
 			}
-
-			// Clear the console's old text.
-			consoleClear();
-
-			// Display the current results after the match.
-			drawText(1, 10, 2, "P1 Wins: %d", p1wins);
-			drawText(1, 10, 4, "P2 Wins: %d", p2wins);
-			drawText(1, 10, 6, "Ties: %d", ties);
-			drawText(1, 8, 8, "P1				P2");
 		}
 
 		// Check if a player has recieved too much damage.
 		if(p1damage > 3 || p2damage > 3)
 		{
-			// If so, clear the console and display the game over screen.
-			consoleClear();
+			// If so, hide the text and display the game over screen.
+			setTextWidgetsVisible(1, false);
 			gameOverScreen((p1damage > 3) ? MULTI_P1 : MULTI_P2);
 
-			// While the touchscreen is not being touched, wait
-			// and update the graphics.
-			while(1)
-			{
-				scanKeys();
-				if(keysDown() & KEY_START)
-				{
-					break;
-				}
-				updateAll();
-			}
+			// Save the statistics from this game.
+			saveMatchStats();
+
+			// Wait for the start button, updating the graphics.
+			waitForKeysDown(KEY_START);
 
 			// Then, initialize the graphics for single player again.
 			initializeMainGameGraphics(MULTI_NORMAL);
@@ -899,11 +863,8 @@ void multiPlayerLoop()
 			setSpriteFrame(1, 4, p1damage);
 			setSpriteFrame(1, 5, p2damage);
 
-			// Reset the text.
-			drawText(1, 10, 2, "P1 Wins: %d", p1wins);
-			drawText(1, 10, 4, "P2 Wins: %d", p2wins);
-			drawText(1, 10, 6, "Ties: %d", ties);
-			drawText(1, 8, 8, "P1				P2");
+			// Show the text again.
+			setTextWidgetsVisible(1, true);
 		}
 
 		// Update all of the game.
@@ -990,14 +951,81 @@ int main()
 	// Initialize video (IE: Video Ram).
 	initVideo();
 
-	// Initialize the text system.
-	initTextSystem(true, 3, 3);
+	// Initialize the text system.  It is set up before anything else
+	// uses VRAM, so running out of room here means the VRAM layout is wrong.
+	if(!initTextSystem(true, 3, 3))
+	{
+		sassert(false, "No VRAM left for the text consoles.");
+	}
+
+	// Pack the font's glyphs for the variable width text.
+	loadFont(&gameFont, fontTiles, 0, fontTilesLen / 32, 1);
+
+	// Start the game's clock.
+	initTime();
+
+	// Start the frame profiler (only built with PROFILE=YES).
+	PROFILE_INIT();
+	PROFILE_OVERLAY(0, true);
+
+	// Start the file system and find the save folder, so that data
+	// can be saved.
+	bool canSave = initSavePath();
+
+	// Open NitroFS so that the game's graphics can be loaded.
+	if(!initAssets())
+	{
+		drawString(1, 0, 0, "Could not open NitroFS.");
+		while(1)
+		{
+			swiWaitForVBlank();
+		}
+	}
 
 	// Enable sound.
 	soundEnable();
 
+	// Get the seed for the random method.
+	u32 seed = (u32)time(NULL);
+	bool playback = false;
+	char replayFile[MAX_SAVE_PATH_LENGTH];
+	bool hasReplayFile = canSave && getSavePath(REPLAY_FILE, replayFile, sizeof(replayFile));
+
+	// Profiling builds play back the last recorded session, so that
+	// each run does exactly the same thing.
+#ifdef GEM_PROFILE
+	playback = hasReplayFile && startReplayPlayback(replayFile);
+#endif
+	if(playback)
+	{
+		seed = getReplaySeed();
+
+		// The playback starts from nothing saved and saves nothing, so
+		// that every run of the same recording does the same work.
+		setSaveFilesEnabled(false);
+		setAiDifficulty(AI_NORMAL);
+	}
+	// Holding select while the game starts records the session
+	// (until select is pressed again).
+	else if(hasReplayFile && (keysCurrent() & KEY_SELECT))
+	{
+		// The computer starts at the same difficulty as a playback.
+		startReplayRecording(replayFile, seed);
+		setAiDifficulty(AI_NORMAL);
+	}
+
+	// Load the player's data (moving an old save to the current format),
+	// and then their achievements, statistics and the leaderboards, so
+	// that recording a match or a score never has to read the SD card.
+	char userName[11];
+	getCurrentUserName(userName, sizeof(userName));
+	loadUserData(userName);
+	loadAchievements();
+	loadMatchStats();
+	loadLeaderboards();
+
 	// Seed the random method.
-	srand(time(NULL));
+	srand(seed);
 
 	while(1)
 	{
@@ -1011,6 +1039,12 @@ int main()
 			// Multiplayer Loop.
 			multiPlayerLoop();
 		}
+
+		// Save any achievements unlocked and the statistics, and finish
+		// writing the saves before going back to the menu.
+		flushAchievements();
+		saveMatchStats();
+		flushSaveQueue();
 	}
 	// Return 0 when done.
 	return 0;
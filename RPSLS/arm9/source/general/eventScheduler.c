@@ -0,0 +1,395 @@
+/*
+ * Contains a scheduler for calendar events (event_t).  Events are kept in a
+ * min-heap ordered by the next day they happen on, and the heap is only
+ * checked when the date changes, so the cost per frame stays the same no
+ * matter how many events there are.
+ */
+#include "eventScheduler.h"
+
+/*
+ * The amount of seconds in a day.
+ */
+#define SECONDS_PER_DAY 86400
+
+/*
+ * A structure for a scheduled event.
+ * day - The next day the event happens on (see getDayNumber).
+ * event - The event.
+ * callback - The function to call when the event happens.
+ */
+typedef struct scheduledEvent_t
+{
+	s32 day;
+	event_t* event;
+	eventCallback_t callback;
+} scheduledEvent_t;
+
+/*
+ * The scheduled events, as a min-heap on the day.
+ */
+scheduledEvent_t eventHeap[MAX_SCHEDULED_EVENTS];
+
+/*
+ * The amount of events in the heap.
+ */
+int eventHeapSize = 0;
+
+/*
+ * The events that are active today, so that they can be
+ * turned off when the date changes.
+ */
+event_t* activeEvents[MAX_SCHEDULED_EVENTS];
+
+/*
+ * The amount of active events.
+ */
+int activeEventCount = 0;
+
+/*
+ * The day the events were last checked on, or -1 if they haven't been.
+ */
+s32 eventDay = -1;
+
+/*
+ * Whether an event was scheduled for a day that has already been checked.
+ */
+bool eventCheckNeeded = false;
+
+/*
+ * Gets the amount of days between 1970-01-01 and a date.
+ * @param year The year of the date.
+ * @param month The month of the date (1-12).
+ * @param day The day of the date (1-31).
+ * @return Returns the amount of days.
+ */
+s32 getDayNumber(int year, int month, int day)
+{
+	/*
+	 * Works with years starting in March, so that the leap day is
+	 * the last day of the year.
+	 */
+	year -= (month <= 2) ? 1 : 0;
+	s32 era = ((year >= 0) ? year : year - 399) / 400;
+	s32 yearOfEra = year - era * 400;
+	s32 dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+	s32 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return era * 146097 + dayOfEra - 719468;
+}
+
+/*
+ * Gets the year of a day number.
+ * @param dayNumber The amount of days since 1970-01-01.
+ * @return Returns the year.
+ */
+static int getDayNumberYear(s32 dayNumber)
+{
+	dayNumber += 719468;
+	s32 era = ((dayNumber >= 0) ? dayNumber : dayNumber - 146096) / 146097;
+	s32 dayOfEra = dayNumber - era * 146097;
+	s32 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	s32 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	s32 monthIndex = (5 * dayOfYear + 2) / 153;
+
+	/*
+	 * Years start in March here, so January and February belong to the next year.
+	 */
+	return yearOfEra + era * 400 + ((monthIndex >= 10) ? 1 : 0);
+}
+
+/*
+ * Gets today's day number.
+ * @return Returns the amount of days since 1970-01-01.
+ */
+static s32 getToday()
+{
+	return (s32)(getTimeUnix() / SECONDS_PER_DAY);
+}
+
+/*
+ * Gets the next day an event happens on.
+ * @param event The event.
+ * @param today The day to start looking from.
+ * @return Returns the day number, or -1 if the event has already passed.
+ */
+static s32 getNextEventDay(const event_t* event, s32 today)
+{
+	/*
+	 * Events with a year happen once.
+	 */
+	if(event->date.year > 0)
+	{
+		s32 day = getDayNumber(event->date.year, event->date.month, event->date.day);
+		return (day >= today) ? day : -1;
+	}
+
+	/*
+	 * Otherwise they happen every year, so it is either this year or the next.
+	 */
+	int year = getDayNumberYear(today);
+	s32 day = getDayNumber(year, event->date.month, event->date.day);
+	if(day < today)
+	{
+		day = getDayNumber(year + 1, event->date.month, event->date.day);
+	}
+	return day;
+}
+
+/*
+ * Swaps two events in the heap.
+ * @param a The index of the first event.
+ * @param b The index of the second event.
+ */
+static void swapEvents(int a, int b)
+{
+	scheduledEvent_t temp = eventHeap[a];
+	eventHeap[a] = eventHeap[b];
+	eventHeap[b] = temp;
+}
+
+/*
+ * Moves an event up the heap until its parent happens first.
+ * @param index The index of the event.
+ */
+static void siftEventUp(int index)
+{
+	while(index > 0)
+	{
+		int parent = (index - 1) / 2;
+		if(eventHeap[parent].day <= eventHeap[index].day)
+		{
+			break;
+		}
+		swapEvents(parent, index);
+		index = parent;
+	}
+}
+
+/*
+ * Moves an event down the heap until its children happen after it.
+ * @param index The index of the event.
+ */
+static void siftEventDown(int index)
+{
+	while(1)
+	{
+		int smallest = index;
+		int left = index * 2 + 1;
+		int right = left + 1;
+
+		if(left < eventHeapSize && eventHeap[left].day < eventHeap[smallest].day)
+		{
+			smallest = left;
+		}
+		if(right < eventHeapSize && eventHeap[right].day < eventHeap[smallest].day)
+		{
+			smallest = right;
+		}
+		if(smallest == index)
+		{
+			break;
+		}
+		swapEvents(smallest, index);
+		index = smallest;
+	}
+}
+
+/*
+ * Removes an event from the heap.
+ * @param index The index of the event.
+ */
+static void removeEventAt(int index)
+{
+	eventHeapSize -= 1;
+	if(index == eventHeapSize)
+	{
+		return;
+	}
+	eventHeap[index] = eventHeap[eventHeapSize];
+	siftEventDown(index);
+	siftEventUp(index);
+}
+
+/*
+ * Schedules an event.  The event is set to active on its date, and its
+ * callback is called.  Events with a year <= 0 happen every year.
+ * @param event The event to schedule.  It must stay around while scheduled.
+ * @param callback The function to call when the event happens, or NULL.
+ * @return Returns true if the event was scheduled, false if it has already
+ * passed or there is no room left.
+ */
+bool scheduleEvent(event_t* event, eventCallback_t callback)
+{
+	if(eventHeapSize >= MAX_SCHEDULED_EVENTS)
+	{
+		return false;
+	}
+
+	s32 today = getToday();
+	s32 day = getNextEventDay(event, today);
+	if(day < 0)
+	{
+		return false;
+	}
+
+	event->isActive = false;
+	eventHeap[eventHeapSize].day = day;
+	eventHeap[eventHeapSize].event = event;
+	eventHeap[eventHeapSize].callback = callback;
+	eventHeapSize += 1;
+	siftEventUp(eventHeapSize - 1);
+
+	/*
+	 * If today has already been checked, the event won't be seen until
+	 * tomorrow, so another check is asked for.
+	 */
+	if(day <= eventDay)
+	{
+		eventCheckNeeded = true;
+	}
+
+	return true;
+}
+
+/*
+ * Schedules a table of events.
+ * @param events The events to schedule.
+ * @param count The amount of events.
+ * @param callback The function to call when any of the events happen, or NULL.
+ * @return Returns the amount of events that were scheduled.
+ */
+int loadEventTable(event_t* events, int count, eventCallback_t callback)
+{
+	int scheduled = 0;
+	int i = 0;
+
+	for(i = 0;i < count;i += 1)
+	{
+		if(scheduleEvent(&events[i], callback))
+		{
+			scheduled += 1;
+		}
+	}
+	return scheduled;
+}
+
+/*
+ * Stops an event from being scheduled.
+ * @param event The event to unschedule.
+ */
+void unscheduleEvent(event_t* event)
+{
+	int i = 0;
+
+	for(i = 0;i < eventHeapSize;i += 1)
+	{
+		if(eventHeap[i].event == event)
+		{
+			removeEventAt(i);
+			break;
+		}
+	}
+
+	for(i = 0;i < activeEventCount;i += 1)
+	{
+		if(activeEvents[i] == event)
+		{
+			activeEventCount -= 1;
+			activeEvents[i] = activeEvents[activeEventCount];
+			break;
+		}
+	}
+	event->isActive = false;
+}
+
+/*
+ * Unschedules all of the events.
+ */
+void clearEvents()
+{
+	int i = 0;
+
+	for(i = 0;i < eventHeapSize;i += 1)
+	{
+		eventHeap[i].event->isActive = false;
+	}
+	for(i = 0;i < activeEventCount;i += 1)
+	{
+		activeEvents[i]->isActive = false;
+	}
+	eventHeapSize = 0;
+	activeEventCount = 0;
+	eventCheckNeeded = false;
+}
+
+/*
+ * Checks if any events happen today.  Called by updateAll, and only does
+ * any work when the date has changed.
+ */
+void updateEvents()
+{
+	s32 today = getToday();
+	int i = 0;
+
+	if(today == eventDay && !eventCheckNeeded)
+	{
+		return;
+	}
+
+	/*
+	 * When the date changes, yesterday's events are no longer active.
+	 */
+	if(today != eventDay)
+	{
+		for(i = 0;i < activeEventCount;i += 1)
+		{
+			activeEvents[i]->isActive = false;
+		}
+		activeEventCount = 0;
+		eventDay = today;
+	}
+	eventCheckNeeded = false;
+
+	/*
+	 * Only the head of the heap needs to be looked at, since it is
+	 * always the next event to happen.
+	 */
+	while(eventHeapSize > 0 && eventHeap[0].day <= today)
+	{
+		scheduledEvent_t current = eventHeap[0];
+
+		/*
+		 * Events that happen every year go back into the heap for next
+		 * year, the others are removed.
+		 */
+		if(current.event->date.year <= 0)
+		{
+			eventHeap[0].day = getNextEventDay(current.event, today + 1);
+			siftEventDown(0);
+		}
+		else
+		{
+			removeEventAt(0);
+		}
+
+		/*
+		 * Events missed while the game wasn't checking (IE: the clock was
+		 * changed) are skipped rather than all happening at once.
+		 */
+		if(current.day < today)
+		{
+			continue;
+		}
+
+		current.event->isActive = true;
+		if(activeEventCount < MAX_SCHEDULED_EVENTS)
+		{
+			activeEvents[activeEventCount] = current.event;
+			activeEventCount += 1;
+		}
+		if(current.callback != NULL)
+		{
+			current.callback(current.event);
+		}
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * Contains a fixed timestep frame timer.  The time since the last frame is
+ * read from the clock's hardware timers and added to an accumulator, which
+ * is then spent in fixed logic steps.  When a frame runs long, the next one
+ * runs several steps before drawing, so the game keeps the same speed no
+ * matter how often it is drawn.
+ */
+#include "frameTimer.h"
+#include "timeFunctions.h"
+
+/*
+ * The tick count when the timer was last read.
+ */
+u32 frameTimerLastTicks = 0;
+
+/*
+ * The time that hasn't been spent on logic steps yet.  This is kept in
+ * ticks times FRAME_STEP_RATE, so that a step is exactly
+ * TIME_TICKS_PER_SECOND of it and no rounding builds up.
+ */
+u32 frameTimerAccumulator = 0;
+
+/*
+ * Tells whether each frame is one logic step.
+ */
+bool frameTimerLocked = false;
+
+/*
+ * The amount of dropped logic steps.
+ */
+u32 droppedFrameCount = 0;
+
+/*
+ * The amount of frames that ran more than one logic step.
+ */
+u32 lateFrameCount = 0;
+
+/*
+ * Starts (or restarts) the frame timer.  Should be called right before a
+ * timed loop, so that the time spent loading beforehand isn't caught up on.
+ */
+void startFrameTimer()
+{
+	frameTimerLastTicks = getTimeTicks();
+
+	/*
+	 * The first frame gets one step, so that the loop starts
+	 * moving straight away.
+	 */
+	frameTimerAccumulator = TIME_TICKS_PER_SECOND;
+}
+
+/*
+ * Gets the amount of logic steps to run before the next frame is drawn.
+ * Called once per frame.
+ * @return Returns the amount of steps, from 0 to MAX_FRAME_STEPS.
+ */
+int getFrameSteps()
+{
+	u32 now = getTimeTicks();
+	u32 elapsed = now - frameTimerLastTicks;
+	int steps = 0;
+
+	frameTimerLastTicks = now;
+
+	if(frameTimerLocked)
+	{
+		return 1;
+	}
+
+	/*
+	 * A long pause (IE: loading or the lid being closed) would
+	 * overflow the accumulator, so it is cut down first.
+	 */
+	if(elapsed > TIME_TICKS_PER_SECOND)
+	{
+		elapsed = TIME_TICKS_PER_SECOND;
+	}
+	frameTimerAccumulator += elapsed * FRAME_STEP_RATE;
+
+	while(frameTimerAccumulator >= TIME_TICKS_PER_SECOND)
+	{
+		frameTimerAccumulator -= TIME_TICKS_PER_SECOND;
+		steps += 1;
+	}
+
+	if(steps > MAX_FRAME_STEPS)
+	{
+		droppedFrameCount += steps - MAX_FRAME_STEPS;
+		steps = MAX_FRAME_STEPS;
+	}
+	if(steps > 1)
+	{
+		lateFrameCount += 1;
+	}
+
+	return steps;
+}
+
+/*
+ * Locks the frame timer to one logic step per frame, whatever the time.
+ * Used while input is being recorded or played back, so that each frame
+ * does the same thing every time.
+ * @param locked Whether to lock the frame timer.
+ */
+void setFrameTimerLocked(bool locked)
+{
+	frameTimerLocked = locked;
+}
+
+/*
+ * Gets the amount of logic steps that were dropped because there were too
+ * many to catch up on.
+ * @return Returns the amount of dropped steps.
+ */
+u32 getDroppedFrameCount()
+{
+	return droppedFrameCount;
+}
+
+/*
+ * Gets the amount of frames that were drawn late, and so had to run more
+ * than one logic step.
+ * @return Returns the amount of late frames.
+ */
+u32 getLateFrameCount()
+{
+	return lateFrameCount;
+}
@@ -68,10 +68,45 @@ bool withinRectangle(int x, int y, rectangle_t rectangle)
 */
 void updateAll()
 {
+	/*
+	 * Ends the time spent in the game's own code since the last call.
+	 */
+	PROFILE_END();
+
 	/*
 	 * Updates the game time.
 	 */
+	PROFILE_BEGIN("time");
 	updateTime();
+	PROFILE_END();
+
+	/*
+	 * Works out which keys were pressed since the last frame, then
+	 * records it or replaces it with the input being played back.
+	 */
+	updateInput();
+	updateReplay();
+
+	/*
+	 * Checks for any events happening today.
+	 */
+	PROFILE_BEGIN("events");
+	updateEvents();
+	PROFILE_END();
+
+	/*
+	 * Runs each of the tasks until they yield.
+	 */
+	PROFILE_BEGIN("tasks");
+	updateTasks();
+	PROFILE_END();
+
+	/*
+	 * Writes some of the queued saves, within the frame's time budget.
+	 */
+	PROFILE_BEGIN("saves");
+	updateSaveQueue();
+	PROFILE_END();
 
 	/*
 	 * Updates the user's data.
@@ -88,25 +123,47 @@ void updateAll()
 	/*
 	 * Updates all of the backgrounds.
 	 */
+	PROFILE_BEGIN("bgs");
 	updateBackgrounds();
 
+	/*
+	 * Builds the scanline effect tables for the next frame.
+	 */
+	updateScanlineEffects();
+	PROFILE_END();
+
 	/*
 	 * Updates all of the sprites.
 	 */
+	PROFILE_BEGIN("sprites");
 	updateSprites();
+	PROFILE_END();
 
 	/*
-	 * Wait for the next vertical blank interrupt.
+	 * Works out which text widget characters changed.
 	 */
-	swiWaitForVBlank();
+	PROFILE_BEGIN("widgets");
+	updateTextWidgets();
+	PROFILE_END();
 
 	/*
-	 * Updates the top screen's OAM.
+	 * Hands the prepared frame to the vertical blank interrupt, which
+	 * writes the OAM, scroll values, queued VRAM copies and text widget
+	 * changes, then waits for it to be done.  The game's code for the
+	 * next frame then runs while this one is being drawn.  The commit is
+	 * timed on its own in the interrupt ("commit"), so "vblank" is that
+	 * plus the time spent waiting.
 	 */
-	oamUpdate(&oamMain);
+	submitFrame();
+	PROFILE_BEGIN("vblank");
+	waitForFrameCommit();
+	PROFILE_END();
+
 	/*
-	 * Updates the bottom screen's OAM.
+	 * Ends the profiler's frame and starts timing the game's own code
+	 * until the next call.
 	 */
-	oamUpdate(&oamSub);
+	PROFILE_FRAME();
+	PROFILE_BEGIN("game");
 }
 
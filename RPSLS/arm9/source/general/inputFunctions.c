@@ -0,0 +1,300 @@
+/*
+ * Contains the input system.  The keys and touch screen are sampled once
+ * every vertical blank into a ring buffer of timestamped snapshots, and
+ * each frame updateAll turns the snapshots since the last frame into
+ * pressed, released and held keys.
+ */
+#include "inputFunctions.h"
+#include "timeFunctions.h"
+
+/*
+ * The snapshots.  Written by the vertical blank interrupt.
+ */
+inputSnapshot_t inputSnapshots[INPUT_HISTORY];
+
+/*
+ * The amount of snapshots taken.  The next one goes at this
+ * index modulo INPUT_HISTORY.
+ */
+volatile u32 inputWriteCount = 0;
+
+/*
+ * The amount of snapshots read by updateInput.
+ */
+u32 inputReadCount = 0;
+
+/*
+ * The snapshot the current frame's input ended on.
+ */
+inputSnapshot_t currentInput;
+
+/*
+ * The keys pressed, released and held this frame.
+ */
+u32 inputKeysDown = 0;
+u32 inputKeysUp = 0;
+u32 inputKeysHeld = 0;
+
+/*
+ * When each key was last pressed.
+ */
+u32 keyDownTicks[INPUT_KEY_COUNT];
+
+/*
+ * The position of the stylus this frame.
+ */
+touchPosition lastTouch;
+
+/*
+ * The keys belonging to each player.  Everything belongs to
+ * player 1 by default.
+ */
+u32 playerKeys[MAX_INPUT_PLAYERS] = {0xFFFFFFFF, 0};
+
+/*
+ * The amount of snapshots that were lost.
+ */
+u32 lostInputCount = 0;
+
+/*
+ * Takes a snapshot of the input.  Called by the frame pipeline every
+ * vertical blank.
+ */
+void sampleInput()
+{
+	inputSnapshot_t* snapshot = &inputSnapshots[inputWriteCount & (INPUT_HISTORY - 1)];
+	touchPosition touch;
+
+	snapshot->ticks = getTimeTicks();
+	snapshot->keys = keysCurrent();
+	snapshot->touchX = 0;
+	snapshot->touchY = 0;
+
+	if(snapshot->keys & KEY_TOUCH)
+	{
+		touchRead(&touch);
+		snapshot->touchX = touch.px;
+		snapshot->touchY = touch.py;
+	}
+
+	inputWriteCount += 1;
+}
+
+/*
+ * Works out the pressed, released and held keys from the snapshots taken
+ * since the last call.  Called by updateAll.
+ */
+void updateInput()
+{
+	u32 writeCount = inputWriteCount;
+	int i = 0;
+
+	inputKeysDown = 0;
+	inputKeysUp = 0;
+	lastTouch.px = 0;
+	lastTouch.py = 0;
+
+	/*
+	 * If the game went so long between frames that the ring buffer was
+	 * written over, the oldest snapshots are skipped.
+	 */
+	if(writeCount - inputReadCount > INPUT_HISTORY)
+	{
+		lostInputCount += writeCount - inputReadCount - INPUT_HISTORY;
+		inputReadCount = writeCount - INPUT_HISTORY;
+	}
+
+	/*
+	 * Each snapshot is compared with the one before it, so a key that
+	 * was pressed and released between two frames shows up as both.
+	 */
+	while(inputReadCount != writeCount)
+	{
+		inputSnapshot_t* snapshot = &inputSnapshots[inputReadCount & (INPUT_HISTORY - 1)];
+		u32 pressed = snapshot->keys & ~inputKeysHeld;
+
+		inputKeysDown |= pressed;
+		inputKeysUp |= inputKeysHeld & ~snapshot->keys;
+		inputKeysHeld = snapshot->keys;
+
+		for(i = 0;pressed != 0 && i < INPUT_KEY_COUNT;i += 1)
+		{
+			if(pressed & BIT(i))
+			{
+				keyDownTicks[i] = snapshot->ticks;
+				pressed &= ~BIT(i);
+			}
+		}
+
+		/*
+		 * The last place touched is kept, so that a tap between
+		 * two frames still has a position.
+		 */
+		if(snapshot->keys & KEY_TOUCH)
+		{
+			lastTouch.px = snapshot->touchX;
+			lastTouch.py = snapshot->touchY;
+		}
+
+		currentInput = *snapshot;
+		inputReadCount += 1;
+	}
+}
+
+/*
+ * Sets which keys belong to a player.
+ * @param player The player.
+ * @param keys The player's keys.
+ */
+void setPlayerKeys(int player, u32 keys)
+{
+	if(player >= 0 && player < MAX_INPUT_PLAYERS)
+	{
+		playerKeys[player] = keys;
+	}
+}
+
+/*
+ * Gets the keys that were pressed this frame.
+ * @return Returns the pressed keys.
+ */
+u32 getKeysDown()
+{
+	return inputKeysDown;
+}
+
+/*
+ * Gets the keys that were released this frame.
+ * @return Returns the released keys.
+ */
+u32 getKeysUp()
+{
+	return inputKeysUp;
+}
+
+/*
+ * Gets the keys that are held.
+ * @return Returns the held keys.
+ */
+u32 getKeysHeld()
+{
+	return inputKeysHeld;
+}
+
+/*
+ * Gets a player's keys that were pressed this frame.
+ * @param player The player.
+ * @return Returns the pressed keys.
+ */
+u32 getPlayerKeysDown(int player)
+{
+	return (player >= 0 && player < MAX_INPUT_PLAYERS) ? inputKeysDown & playerKeys[player] : 0;
+}
+
+/*
+ * Gets a player's keys that were released this frame.
+ * @param player The player.
+ * @return Returns the released keys.
+ */
+u32 getPlayerKeysUp(int player)
+{
+	return (player >= 0 && player < MAX_INPUT_PLAYERS) ? inputKeysUp & playerKeys[player] : 0;
+}
+
+/*
+ * Gets a player's keys that are held.
+ * @param player The player.
+ * @return Returns the held keys.
+ */
+u32 getPlayerKeysHeld(int player)
+{
+	return (player >= 0 && player < MAX_INPUT_PLAYERS) ? inputKeysHeld & playerKeys[player] : 0;
+}
+
+/*
+ * Takes presses out of this frame's pressed keys, so that no other code
+ * sees them.
+ * @param keys The keys to take.
+ * @return Returns the keys that had been pressed.
+ */
+u32 consumeKeysDown(u32 keys)
+{
+	u32 pressed = inputKeysDown & keys;
+	inputKeysDown &= ~keys;
+	return pressed;
+}
+
+/*
+ * Gets when a key was last pressed.
+ * @param key The key.
+ * @return Returns the tick count of the snapshot the key was pressed in.
+ */
+u32 getKeyDownTicks(u32 key)
+{
+	int i = 0;
+
+	for(i = 0;i < INPUT_KEY_COUNT;i += 1)
+	{
+		if(key & BIT(i))
+		{
+			return keyDownTicks[i];
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Gets the position of the stylus this frame.
+ * @return Returns the last position touched since the last frame, or 0, 0
+ * if the touch screen wasn't touched.
+ */
+touchPosition getTouchPosition()
+{
+	return lastTouch;
+}
+
+/*
+ * Gets the latest snapshot used by updateInput.
+ * @return Returns the snapshot.
+ */
+inputSnapshot_t getInputSnapshot()
+{
+	return currentInput;
+}
+
+/*
+ * Gets this frame's input.
+ * @param frame Set to this frame's input.
+ */
+void getInputFrame(inputFrame_t* frame)
+{
+	frame->keysDown = (u16)inputKeysDown;
+	frame->keysUp = (u16)inputKeysUp;
+	frame->keysHeld = (u16)inputKeysHeld;
+	frame->touchX = (u8)lastTouch.px;
+	frame->touchY = (u8)lastTouch.py;
+}
+
+/*
+ * Replaces this frame's input (IE: with input being played back).
+ * @param frame The input to use for this frame.
+ */
+void setInputFrame(const inputFrame_t* frame)
+{
+	inputKeysDown = frame->keysDown;
+	inputKeysUp = frame->keysUp;
+	inputKeysHeld = frame->keysHeld;
+	lastTouch.px = frame->touchX;
+	lastTouch.py = frame->touchY;
+}
+
+/*
+ * Gets the amount of snapshots that were lost because the game went too
+ * long between frames.
+ * @return Returns the amount of lost snapshots.
+ */
+u32 getLostInputCount()
+{
+	return lostInputCount;
+}
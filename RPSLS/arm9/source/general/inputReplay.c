@@ -0,0 +1,255 @@
+/*
+ * Contains an input recorder.  A session's random seed and the input of
+ * every frame are recorded to a file, and can be played back through the
+ * input system later so that the game does exactly the same thing again.
+ */
+#include "GEM_functions.h"
+
+#include <stdio.h>
+
+/*
+ * What the recorder is doing.
+ */
+typedef enum
+{
+	REPLAY_OFF = 0,
+	REPLAY_RECORDING = 1,
+	REPLAY_PLAYING = 2
+} replayMode_t;
+
+/*
+ * What the recorder is doing.
+ */
+replayMode_t replayMode = REPLAY_OFF;
+
+/*
+ * The recorded frames.  A recording that is played back is read in
+ * whole before the playback starts, so that no file reads happen during
+ * the frames being profiled.
+ */
+inputFrame_t* replayFrames = NULL;
+
+/*
+ * The amount of recorded frames.
+ */
+u32 replayFrameCount = 0;
+
+/*
+ * The next frame to play back.
+ */
+u32 replayFrameIndex = 0;
+
+/*
+ * The random seed of the recording.
+ */
+u32 replaySeed = 0;
+
+/*
+ * The file the recording is saved to.
+ */
+char replayFileName[MAX_SAVE_PATH_LENGTH];
+
+/*
+ * Frees the recorded frames and turns the recorder off.
+ */
+static void resetReplay()
+{
+	if(replayFrames != NULL)
+	{
+		free(replayFrames);
+		replayFrames = NULL;
+	}
+	replayFrameCount = 0;
+	replayFrameIndex = 0;
+	replayMode = REPLAY_OFF;
+	setFrameTimerLocked(false);
+}
+
+/*
+ * Saves the recorded frames.
+ * @return Returns true if they were saved, false otherwise.
+ */
+static bool saveReplay()
+{
+	replayHeader_t header;
+	bool saved = false;
+
+	FILE* file = fopen(replayFileName, "wb");
+	if(file == NULL)
+	{
+		return false;
+	}
+
+	header.magic = REPLAY_MAGIC;
+	header.version = REPLAY_VERSION;
+	header.frameSize = sizeof(inputFrame_t);
+	header.seed = replaySeed;
+	header.frameCount = replayFrameCount;
+
+	saved = fwrite(&header, sizeof(header), 1, file) == 1
+			&& fwrite(replayFrames, sizeof(inputFrame_t), replayFrameCount, file) == replayFrameCount;
+
+	fclose(file);
+	return saved;
+}
+
+/*
+ * Starts recording the input.  The recording is saved when stopReplay is
+ * called, when SELECT is pressed, or when MAX_REPLAY_FRAMES is reached.
+ * @param fileName The file to save the recording to.
+ * @param seed The random seed of the session.
+ * @return Returns true if the recording started, false if there wasn't
+ * enough memory.
+ */
+bool startReplayRecording(const char* fileName, u32 seed)
+{
+	resetReplay();
+
+	replayFrames = (inputFrame_t*)malloc(MAX_REPLAY_FRAMES * sizeof(inputFrame_t));
+	if(replayFrames == NULL)
+	{
+		return false;
+	}
+
+	strncpy(replayFileName, fileName, sizeof(replayFileName) - 1);
+	replayFileName[sizeof(replayFileName) - 1] = '\0';
+	replaySeed = seed;
+	replayMode = REPLAY_RECORDING;
+
+	/*
+	 * The session is recorded as if every frame was on time, so that
+	 * it plays back the same way.
+	 */
+	setFrameTimerLocked(true);
+	return true;
+}
+
+/*
+ * Starts playing back a recording.  The frame timer is locked to one
+ * step per frame, and in profiling builds every frame is logged.
+ * @param fileName The file to play back.
+ * @return Returns true if the recording is being played back, false if it
+ * couldn't be loaded.
+ */
+bool startReplayPlayback(const char* fileName)
+{
+	replayHeader_t header;
+	fileBuffer_t file;
+
+	resetReplay();
+
+	if(openFileBuffer(fileName, &file, 0) < sizeof(header))
+	{
+		closeBuffer(&file);
+		return false;
+	}
+
+	if(readFileBufferNext(&file, &header, sizeof(header)) != sizeof(header) || header.magic != REPLAY_MAGIC
+			|| header.version != REPLAY_VERSION || header.frameSize != sizeof(inputFrame_t)
+			|| header.frameCount == 0 || header.frameCount > MAX_REPLAY_FRAMES)
+	{
+		closeBuffer(&file);
+		return false;
+	}
+
+	/*
+	 * All of the frames are read now, so that reading the SD card doesn't
+	 * show up in the profiler's numbers for the frames being played back.
+	 */
+	u32 framesSize = header.frameCount * sizeof(inputFrame_t);
+	replayFrames = (inputFrame_t*)malloc(framesSize);
+	if(replayFrames == NULL || readFileBufferNext(&file, replayFrames, framesSize) != framesSize)
+	{
+		closeBuffer(&file);
+		resetReplay();
+		return false;
+	}
+	closeBuffer(&file);
+
+	replaySeed = header.seed;
+	replayFrameCount = header.frameCount;
+	replayMode = REPLAY_PLAYING;
+
+	setFrameTimerLocked(true);
+	PROFILE_LOG(true);
+	return true;
+}
+
+/*
+ * Stops recording (saving the recording) or playing back.
+ */
+void stopReplay()
+{
+	char message[64];
+
+	if(replayMode == REPLAY_RECORDING)
+	{
+		snprintf(message, sizeof(message), "replay: recorded %lu frames%s", (unsigned long)replayFrameCount,
+				saveReplay() ? "" : " (not saved)");
+		nocashMessage(message);
+	}
+	else if(replayMode == REPLAY_PLAYING)
+	{
+		PROFILE_LOG(false);
+		snprintf(message, sizeof(message), "replay: played %lu frames", (unsigned long)replayFrameIndex);
+		nocashMessage(message);
+	}
+
+	resetReplay();
+}
+
+/*
+ * Gets the random seed of the recording being played back or recorded.
+ * @return Returns the seed.
+ */
+u32 getReplaySeed()
+{
+	return replaySeed;
+}
+
+/*
+ * Checks if input is being recorded.
+ * @return Returns true if recording, false otherwise.
+ */
+bool isReplayRecording()
+{
+	return replayMode == REPLAY_RECORDING;
+}
+
+/*
+ * Checks if a recording is being played back.
+ * @return Returns true if playing back, false otherwise.
+ */
+bool isReplayPlaying()
+{
+	return replayMode == REPLAY_PLAYING;
+}
+
+/*
+ * Records or plays back this frame's input.  Called by updateAll right
+ * after updateInput.
+ */
+void updateReplay()
+{
+	if(replayMode == REPLAY_RECORDING)
+	{
+		getInputFrame(&replayFrames[replayFrameCount]);
+		replayFrameCount += 1;
+
+		if(replayFrameCount >= MAX_REPLAY_FRAMES || (getKeysDown() & KEY_SELECT))
+		{
+			stopReplay();
+		}
+	}
+	else if(replayMode == REPLAY_PLAYING)
+	{
+		if(replayFrameIndex >= replayFrameCount)
+		{
+			stopReplay();
+			return;
+		}
+
+		setInputFrame(&replayFrames[replayFrameIndex]);
+		replayFrameIndex += 1;
+	}
+}
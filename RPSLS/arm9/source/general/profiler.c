@@ -0,0 +1,364 @@
+/*
+ * Contains a frame profiler based on the DS's hardware timers.  Named scopes
+ * can be nested, the time spent in each one is kept for the last
+ * PROFILE_HISTORY frames, and an overlay can show the results on a text
+ * layer.  Everything is used through the PROFILE_ macros, which compile to
+ * nothing unless GEM_PROFILE is defined (make PROFILE=YES).
+ */
+#include "profiler.h"
+
+#ifdef GEM_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+#include "textFunctions.h"
+
+/*
+ * A structure for a profiling scope.
+ * name - The name of the scope.
+ * frameTicks - The ticks spent in the scope this frame.
+ * history - The ticks spent in the scope in each of the last frames.
+ */
+typedef struct profileScope_t
+{
+	const char* name;
+	u32 frameTicks;
+	u32 history[PROFILE_HISTORY];
+} profileScope_t;
+
+/*
+ * The scopes.  Scope 0 is the whole frame.
+ */
+profileScope_t profileScopes[MAX_PROFILE_SCOPES];
+
+/*
+ * The amount of scopes.
+ */
+int profileScopeCount = 0;
+
+/*
+ * Tells whether the profiler has been started.  Scopes used before then
+ * are not added, so they don't keep IDs that initProfiler clears.
+ */
+bool profilerStarted = false;
+
+/*
+ * The scopes that are being timed, and when they were started.
+ */
+int profileStack[PROFILE_MAX_DEPTH];
+u32 profileStackStarts[PROFILE_MAX_DEPTH];
+int profileDepth = 0;
+
+/*
+ * The position in the history of the current frame.
+ */
+int profileFrameIndex = 0;
+
+/*
+ * The amount of frames in the history.
+ */
+int profileFrameCount = 0;
+
+/*
+ * When the current frame started.
+ */
+u32 profileFrameStart = 0;
+
+/*
+ * The screen the overlay is shown on, or -1 if it is hidden.
+ */
+int profileOverlayScreen = -1;
+
+/*
+ * The amount of frames until the overlay is redrawn.
+ */
+int profileOverlayCountdown = 0;
+
+/*
+ * Tells whether each frame is logged.
+ */
+bool profileLogging = false;
+
+/*
+ * The amount of frames logged.
+ */
+u32 profileLoggedFrames = 0;
+
+/*
+ * Converts timer ticks to microseconds.
+ * @param ticks The ticks to convert.
+ * @return Returns the microseconds.
+ */
+static u32 profileTicksToMicroseconds(u32 ticks)
+{
+	return (u32)(((u64)ticks * 1000000) / BUS_CLOCK);
+}
+
+/*
+ * Draws the overlay.
+ */
+static void drawProfilerOverlay()
+{
+	int i = 0;
+	u32 min = 0;
+	u32 avg = 0;
+	u32 max = 0;
+
+	clearTextArea(profileOverlayScreen, 0, 0, 32, profileScopeCount + 1);
+	drawString(profileOverlayScreen, 0, 0, "scope     avg    min    max us");
+
+	for(i = 0;i < profileScopeCount;i += 1)
+	{
+		getProfileStats(i, &min, &avg, &max);
+		drawString(profileOverlayScreen, 0, i + 1, profileScopes[i].name);
+		drawInt(profileOverlayScreen, 9, i + 1, avg);
+		drawInt(profileOverlayScreen, 16, i + 1, min);
+		drawInt(profileOverlayScreen, 23, i + 1, max);
+	}
+}
+
+/*
+ * Starts the profiler.  Uses timers 0 and 1.
+ */
+void initProfiler()
+{
+	memset(profileScopes, 0, sizeof(profileScopes));
+	profileScopeCount = 0;
+	profileDepth = 0;
+	profileFrameIndex = 0;
+	profileFrameCount = 0;
+
+	/*
+	 * Scope 0 is always the whole frame.
+	 */
+	getProfileScope("frame");
+
+	cpuStartTiming(0);
+	profileFrameStart = cpuGetTiming();
+	profilerStarted = true;
+}
+
+/*
+ * Gets the ID of a scope, adding it if it doesn't exist yet.
+ * @param name The name of the scope.
+ * @return Returns the ID of the scope, or -1 if there is no room left or
+ * the profiler hasn't been started.
+ */
+int getProfileScope(const char* name)
+{
+	int i = 0;
+	int id = -1;
+	int oldIME = 0;
+
+	if(!profilerStarted)
+	{
+		return -1;
+	}
+
+	/*
+	 * Interrupts are held off while looking, since scopes can also be
+	 * added from the vertical blank interrupt.
+	 */
+	oldIME = enterCriticalSection();
+	for(i = 0;i < profileScopeCount;i += 1)
+	{
+		if(strcmp(profileScopes[i].name, name) == 0)
+		{
+			id = i;
+			break;
+		}
+	}
+
+	if(id < 0 && profileScopeCount < MAX_PROFILE_SCOPES)
+	{
+		profileScopes[profileScopeCount].name = name;
+		profileScopeCount += 1;
+		id = profileScopeCount - 1;
+	}
+	leaveCriticalSection(oldIME);
+
+	return id;
+}
+
+/*
+ * Starts timing a scope.
+ * @param id The ID of the scope.
+ */
+void beginProfileScope(int id)
+{
+	/*
+	 * Scopes that are too deep are still counted, but not timed,
+	 * so that their end still matches up.
+	 */
+	if(profileDepth < PROFILE_MAX_DEPTH)
+	{
+		profileStack[profileDepth] = id;
+		profileStackStarts[profileDepth] = cpuGetTiming();
+	}
+	profileDepth += 1;
+}
+
+/*
+ * Stops timing the scope that was started last.
+ */
+void endProfileScope()
+{
+	if(profileDepth <= 0)
+	{
+		return;
+	}
+
+	profileDepth -= 1;
+	if(profileDepth >= PROFILE_MAX_DEPTH)
+	{
+		return;
+	}
+
+	int id = profileStack[profileDepth];
+	if(id >= 0)
+	{
+		profileScopes[id].frameTicks += cpuGetTiming() - profileStackStarts[profileDepth];
+	}
+}
+
+/*
+ * Adds time that was measured outside of the scopes to a scope.  Used for
+ * the time spent in interrupts, which can't use the scope stack since they
+ * can happen in the middle of any scope.
+ * @param id The ID of the scope.
+ * @param ticks The time to add in timer ticks.
+ */
+void addProfileTicks(int id, u32 ticks)
+{
+	if(id >= 0 && id < profileScopeCount)
+	{
+		profileScopes[id].frameTicks += ticks;
+	}
+}
+
+/*
+ * Ends the current frame, saving the time spent in each scope.
+ * Called once per frame by updateAll.
+ */
+void endProfileFrame()
+{
+	int i = 0;
+	int oldIME = 0;
+	u32 now = cpuGetTiming();
+
+	profileScopes[0].frameTicks = now - profileFrameStart;
+	profileFrameStart = now;
+
+	/*
+	 * Each logged frame is written as scope=microseconds pairs after the
+	 * frame number, so that runs can be compared by a script.  The debug
+	 * output only takes short messages, so long frames are split up.
+	 */
+	if(profileLogging)
+	{
+		char line[PROFILE_LOG_LINE_LENGTH + 32];
+		int length = snprintf(line, sizeof(line), "frame %lu", (unsigned long)profileLoggedFrames);
+
+		for(i = 0;i < profileScopeCount;i += 1)
+		{
+			if(length > PROFILE_LOG_LINE_LENGTH)
+			{
+				nocashMessage(line);
+				length = snprintf(line, sizeof(line), "frame %lu", (unsigned long)profileLoggedFrames);
+			}
+			length += snprintf(line + length, sizeof(line) - length, " %.12s=%lu", profileScopes[i].name,
+					(unsigned long)profileTicksToMicroseconds(profileScopes[i].frameTicks));
+		}
+		nocashMessage(line);
+		profileLoggedFrames += 1;
+	}
+
+	oldIME = enterCriticalSection();
+	for(i = 0;i < profileScopeCount;i += 1)
+	{
+		profileScopes[i].history[profileFrameIndex] = profileScopes[i].frameTicks;
+		profileScopes[i].frameTicks = 0;
+	}
+	leaveCriticalSection(oldIME);
+
+	profileFrameIndex = (profileFrameIndex + 1) % PROFILE_HISTORY;
+	if(profileFrameCount < PROFILE_HISTORY)
+	{
+		profileFrameCount += 1;
+	}
+
+	/*
+	 * The overlay is only redrawn every so often, so that it
+	 * doesn't take up much of the frame itself.
+	 */
+	if(profileOverlayScreen >= 0)
+	{
+		profileOverlayCountdown -= 1;
+		if(profileOverlayCountdown <= 0)
+		{
+			drawProfilerOverlay();
+			profileOverlayCountdown = PROFILE_OVERLAY_RATE;
+		}
+	}
+}
+
+/*
+ * Gets the min, average and max time spent in a scope over the last frames.
+ * @param id The ID of the scope.
+ * @param min Set to the min time in microseconds.
+ * @param avg Set to the average time in microseconds.
+ * @param max Set to the max time in microseconds.
+ */
+void getProfileStats(int id, u32* min, u32* avg, u32* max)
+{
+	int i = 0;
+	u32 low = 0xFFFFFFFF;
+	u32 high = 0;
+	u64 total = 0;
+
+	if(id < 0 || id >= profileScopeCount || profileFrameCount == 0)
+	{
+		*min = *avg = *max = 0;
+		return;
+	}
+
+	for(i = 0;i < profileFrameCount;i += 1)
+	{
+		u32 ticks = profileScopes[id].history[i];
+		low = (ticks < low) ? ticks : low;
+		high = (ticks > high) ? ticks : high;
+		total += ticks;
+	}
+
+	*min = profileTicksToMicroseconds(low);
+	*avg = profileTicksToMicroseconds(total / profileFrameCount);
+	*max = profileTicksToMicroseconds(high);
+}
+
+/*
+ * Sets whether each frame's times are written to the emulator's debug
+ * output (no$gba style), one line per frame.
+ * @param log Whether to log the frames.
+ */
+void setProfilerLogging(bool log)
+{
+	profileLogging = log;
+	profileLoggedFrames = 0;
+}
+
+/*
+ * Shows or hides the profiler's overlay.
+ * @param screen The screen to show the overlay on (its text layer).
+ * @param show Whether to show the overlay.
+ */
+void showProfilerOverlay(int screen, bool show)
+{
+	if(profileOverlayScreen >= 0)
+	{
+		clearTextArea(profileOverlayScreen, 0, 0, 32, profileScopeCount + 1);
+	}
+	profileOverlayScreen = show ? ((screen <= 0) ? 0 : 1) : -1;
+	profileOverlayCountdown = 0;
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Contains a cooperative task scheduler.  Tasks are small state machines
+ * that are run once per frame by updateAll, and give up the CPU by
+ * yielding until the next frame.
+ */
+#include "taskScheduler.h"
+#include "generic.h"
+#include "inputFunctions.h"
+
+/*
+ * The tasks.
+ */
+task_t tasks[MAX_TASKS];
+
+/*
+ * The function of each task, or NULL if the slot is free.
+ */
+taskFunction_t taskFunctions[MAX_TASKS];
+
+/*
+ * Starts a task.  It is first run in the next updateAll.
+ * @param function The task function.
+ * @param data The data for the task (can be NULL).
+ * @return Returns the ID of the task, or -1 if too many are running.
+ */
+int startTask(taskFunction_t function, void* data)
+{
+	int i = 0;
+
+	if(function == NULL)
+	{
+		return -1;
+	}
+
+	for(i = 0;i < MAX_TASKS;i += 1)
+	{
+		if(taskFunctions[i] == NULL)
+		{
+			memset(&tasks[i], 0, sizeof(task_t));
+			tasks[i].data = data;
+			taskFunctions[i] = function;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Gets a running task, so that its vars can be set before it first runs.
+ * @param id The ID of the task.
+ * @return Returns the task, or NULL if it isn't running.
+ */
+task_t* getTask(int id)
+{
+	if(!isTaskRunning(id))
+	{
+		return NULL;
+	}
+
+	return &tasks[id];
+}
+
+/*
+ * Stops a task.
+ * @param id The ID of the task.
+ */
+void stopTask(int id)
+{
+	if(id >= 0 && id < MAX_TASKS)
+	{
+		taskFunctions[id] = NULL;
+	}
+}
+
+/*
+ * Checks if a task is still running.
+ * @param id The ID of the task.
+ * @return Returns true if the task is running, false otherwise.
+ */
+bool isTaskRunning(int id)
+{
+	return id >= 0 && id < MAX_TASKS && taskFunctions[id] != NULL;
+}
+
+/*
+ * Runs each task once.  Called by updateAll.
+ */
+void updateTasks()
+{
+	int i = 0;
+
+	for(i = 0;i < MAX_TASKS;i += 1)
+	{
+		/*
+		 * The function is kept before running, in case the task
+		 * stops itself and its slot is reused.
+		 */
+		taskFunction_t function = taskFunctions[i];
+		if(function != NULL && !function(&tasks[i]) && taskFunctions[i] == function)
+		{
+			taskFunctions[i] = NULL;
+		}
+	}
+}
+
+/*
+ * Keeps updating the game until a task is done.
+ * @param id The ID of the task.
+ */
+void waitForTask(int id)
+{
+	while(isTaskRunning(id))
+	{
+		updateAll();
+	}
+}
+
+/*
+ * Keeps updating the game until one of the keys is pressed.
+ * @param keys The keys to wait for.
+ * @return Returns the keys that were pressed.
+ */
+u32 waitForKeysDown(u32 keys)
+{
+	u32 pressed = 0;
+
+	/*
+	 * Each check comes after a whole frame, so the CPU is halted
+	 * until the vertical blank instead of spinning on the keys.
+	 */
+	while(!pressed)
+	{
+		updateAll();
+		pressed = consumeKeysDown(keys);
+	}
+
+	return pressed;
+}
+
+/*
+ * Keeps updating the game until none of the keys are held.
+ * @param keys The keys to wait for.
+ */
+void waitForKeysReleased(u32 keys)
+{
+	while(getKeysHeld() & keys)
+	{
+		updateAll();
+	}
+}
@@ -6,18 +6,156 @@
 #include "timeFunctions.h"
 
 /*
- *  Holds the time of according to the DS.
+ *  Holds the time of according to the DS.  This is only worked out
+ *  from unixTime when one of the getters needs it.
  */
-struct tm* DSTime;
+struct tm timeCache;
+struct tm* DSTime = &timeCache;
 time_t unixTime;
 
+/*
+ * Whether timeCache needs to be worked out again.
+ */
+bool timeDirty = true;
+
+/*
+ * Whether the clock has been started.
+ */
+bool timeStarted = false;
+
+/*
+ * Whether the start of the current second is known yet.
+ */
+bool timeSynced = false;
+
+/*
+ * The tick count when the current second started.
+ */
+u32 secondStartTicks = 0;
+
+/*
+ * Gets the broken down time, working it out first if the time changed.
+ * @return Returns the broken down time.
+ */
+static struct tm* getBrokenDownTime()
+{
+	if(timeDirty)
+	{
+		gmtime_r(&unixTime, &timeCache);
+		timeDirty = false;
+	}
+	return &timeCache;
+}
+
+/*
+ * Reads the RTC.
+ * @return Returns true if the time changed since it was last read.
+ */
+static bool readClock()
+{
+	time_t now = time(NULL);
+
+	if(now == unixTime)
+	{
+		return false;
+	}
+	unixTime = now;
+	timeDirty = true;
+	return true;
+}
+
+/*
+ * Starts the clock.  Timers 2 and 3 are cascaded into a 32 bit tick
+ * counter, and the RTC is read for the first time.  Called by updateTime
+ * if it hasn't been called already.
+ */
+void initTime()
+{
+	/*
+	 * Timer 2 counts at the bus clock / 1024, and timer 3 counts each time
+	 * timer 2 overflows.
+	 */
+	TIMER_CR(3) = 0;
+	TIMER_CR(2) = 0;
+	TIMER_DATA(2) = 0;
+	TIMER_DATA(3) = 0;
+	TIMER_CR(3) = TIMER_ENABLE | TIMER_CASCADE;
+	TIMER_CR(2) = TIMER_ENABLE | TIMER_DIV_1024;
+
+	readClock();
+	timeDirty = true;
+	timeSynced = false;
+	secondStartTicks = 0;
+	timeStarted = true;
+}
+
+/*
+ * Gets the amount of ticks since the clock was started.
+ * There are TIME_TICKS_PER_SECOND ticks in a second.
+ * @return Returns the tick count.
+ */
+u32 getTimeTicks()
+{
+	u16 high = 0;
+	u16 low = 0;
+
+	/*
+	 * Makes sure that timer 2 didn't overflow between reading
+	 * the two halves.
+	 */
+	do
+	{
+		high = TIMER_DATA(3);
+		low = TIMER_DATA(2);
+	} while(high != TIMER_DATA(3));
+
+	return ((u32)high << 16) | low;
+}
+
+/*
+ * Gets the current time according to the DS in seconds since 1970.
+ * @return Returns the time.
+ */
+time_t getTimeUnix()
+{
+	return unixTime;
+}
+
+/*
+ * Gets the amount of milliseconds into the current second.
+ * @return Returns the milliseconds (0-999).
+ */
+int getTimeMilliseconds()
+{
+	if(!timeSynced)
+	{
+		return 0;
+	}
+
+	u32 ms = ((u64)(getTimeTicks() - secondStartTicks) * 1000) / TIME_TICKS_PER_SECOND;
+	return (ms > 999) ? 999 : ms;
+}
+
+/*
+ * Reads the RTC right away, rather than waiting for the next second.
+ */
+void refreshTime()
+{
+	if(!timeStarted)
+	{
+		initTime();
+		return;
+	}
+	readClock();
+}
+
 /*
  * Gets the current year according to the DS.
  * @return Returns the year as an integer.
  */
 int getTimeYear()
 {
-	return DSTime->tm_year + 1900;
+	return getBrokenDownTime()->tm_year + 1900;
 }
 
 /*
@@ -26,7 +164,7 @@ int getTimeYear()
  */
 int getTimeMonth()
 {
-	return DSTime->tm_mon + 1;
+	return getBrokenDownTime()->tm_mon + 1;
 }
 
 /*
@@ -35,7 +173,7 @@ int getTimeMonth()
  */
 int getTimeDayOfMonth()
 {
-	return DSTime->tm_mday + 1;
+	return getBrokenDownTime()->tm_mday + 1;
 }
 
 /*
@@ -44,7 +182,7 @@ int getTimeDayOfMonth()
  */
 int getTimeDayOfWeek()
 {
-	return DSTime->tm_wday + 1;
+	return getBrokenDownTime()->tm_wday + 1;
 }
 
 /*
@@ -53,7 +191,7 @@ int getTimeDayOfWeek()
  */
 int getTimeDayOfYear()
 {
-	return DSTime->tm_yday;
+	return getBrokenDownTime()->tm_yday;
 }
 
 /*
@@ -68,32 +206,32 @@ int getTimeHours(bool military)
 	if (military)
 	{
 		// If so, just return the time's hour.
-		return DSTime->tm_hour;
+		return getBrokenDownTime()->tm_hour;
 	}
 	else
 	{
 		// If not, check if the time is greater than 12.
-		if (DSTime->tm_hour > 12)
+		if (getBrokenDownTime()->tm_hour > 12)
 		{
 			// If it is, then check if it is exactly 12 hours.
-			if(DSTime->tm_hour - 12 == 0)
+			if(getBrokenDownTime()->tm_hour - 12 == 0)
 			{
 				// If so, return 12 (12pm).
 				return 12;
 			}
 			// Otherwise, return the time minus 12 (1pm-11pm).
-			return DSTime->tm_hour - 12;
+			return getBrokenDownTime()->tm_hour - 12;
 		}
 		else
 		{
 			// Check if the time is 0 (Midnight or 12am).
-			if(DSTime->tm_hour == 0)
+			if(getBrokenDownTime()->tm_hour == 0)
 			{
 				// Return 12 if this is the case (12am).
 				return 12;
 			}
 			// Otherwise, return the time (1am-11am).
-			return DSTime->tm_hour;
+			return getBrokenDownTime()->tm_hour;
 		}
 	}
 }
@@ -104,7 +242,7 @@ int getTimeHours(bool military)
  */
 int getTimeMinutes()
 {
-	return DSTime->tm_min;
+	return getBrokenDownTime()->tm_min;
 }
 
 /*
@@ -114,10 +252,10 @@ int getTimeMinutes()
 int getTimeSeconds()
 {
 	// Check if the time is less than 60.
-	if (DSTime->tm_sec < 60)
+	if (getBrokenDownTime()->tm_sec < 60)
 	{
 		// Return the time's seconds if it is.
-		return DSTime->tm_sec;
+		return getBrokenDownTime()->tm_sec;
 	}
 	// Return 0 otherwise.
 	return 0;
@@ -129,14 +267,48 @@ int getTimeSeconds()
  */
 char* getTimeText()
 {
-	return asctime(DSTime);
+	return asctime(getBrokenDownTime());
 }
 
 /*
- *  Updates the current time according to the DS.
+ *  Updates the current time according to the DS.  The RTC is only read
+ *  when the next second is due, and the broken down time is only worked
+ *  out again when a getter needs it.
  */
 void updateTime()
 {
-	unixTime = time(NULL);
-	DSTime = gmtime((const time_t *) &unixTime);
+	if(!timeStarted)
+	{
+		initTime();
+		return;
+	}
+
+	u32 ticks = getTimeTicks();
+
+	/*
+	 * Until the start of a second has been seen, the RTC is read every
+	 * update.  Once it has, it is only read again once a second has passed.
+	 */
+	if(timeSynced && ticks - secondStartTicks < TIME_TICKS_PER_SECOND)
+	{
+		return;
+	}
+
+	if(readClock())
+	{
+		/*
+		 * The second changed, so the current second starts now.  If the
+		 * change was seen on time, the expected start is kept instead so
+		 * that the polling doesn't drift later and later.
+		 */
+		if(timeSynced && ticks - secondStartTicks < TIME_TICKS_PER_SECOND + TIME_TICKS_PER_SECOND / 30)
+		{
+			secondStartTicks += TIME_TICKS_PER_SECOND;
+		}
+		else
+		{
+			secondStartTicks = ticks;
+		}
+		timeSynced = true;
+	}
 }
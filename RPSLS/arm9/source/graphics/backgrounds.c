@@ -10,6 +10,8 @@
  * The basic includes for backgrounds.c.
 */
 #include "backgrounds.h"
+#include "vramPlanner.h"
+#include "framePipeline.h"
 
 /*
  * Keeps track of which layers each background index is on.
@@ -21,6 +23,13 @@ int indexLayers[2][4];
 */
 int bgTracker[2][4] = {{-1, -1, -1, -1}, {-1, -1, -1, -1}};
 
+/*
+ * Keeps track of the map and tile bases handed out to each background
+ * by the VRAM planner, so that they can be given back.
+*/
+int bgMapBases[2][4];
+int bgTileBases[2][4];
+
 /*
  * Keeps track of the X blocks for each background.
  * This is used when scrolling a background.
@@ -37,6 +46,13 @@ u32 yBlocks[2][4];
 */
 coordinates_t bgPositions[2][4];
 
+/*
+ * Keeps track of the hardware scroll values of each background.
+ * These are the values actually written to the scroll registers,
+ * after the map block has been taken into account.
+*/
+coordinates_t bgScrolls[2][4];
+
 /*
  * Keeps track of the sizes of each background.
 */
@@ -95,7 +111,8 @@ paletteData_t colPaletteData[2][4];
  * @param index The index (layer) to create the background on.
  * @param width The width of the background.
  * @param height The height of the background.
- * @return An integer that points to the background.
+ * @return An integer that points to the background, or -1 if there
+ * was not enough VRAM for it.
 */
 int createBg(int screen, int index, u32 width, u32 height)
 {
@@ -111,6 +128,12 @@ int createBg(int screen, int index, u32 width, u32 height)
 	*/
 	bgPositions[screen][index].y = 0;
 
+	/*
+	 * Resets the background's hardware scroll values.
+	*/
+	bgScrolls[screen][index].x = 0;
+	bgScrolls[screen][index].y = 0;
+
 	/*
 	 * Set the width of the background.
 	*/
@@ -142,22 +165,44 @@ int createBg(int screen, int index, u32 width, u32 height)
 		BgSize_T_256x256;
 
 	/*
-	 * Checks to see if the screen variable is <= 0, if it is then...
+	 * Checks to see if the background still needs to be initialized.
 	 */
-	if (screen <= 0 && bgTracker[screen][index] == -1)
+	if (bgTracker[screen][index] == -1)
 	{
+		int mapBase = 0;
+		int tileBase = 0;
+
 		/*
-		 * the background on the sub screen is initialized with the default settings of a text bg.
-		 * If it is > 0, then...
+		 * Gets room for the background's map and tiles from the VRAM
+		 * planner, so that it doesn't overlap with other backgrounds.
+		 * The map blocks are always streamed in two 4KB halves, so that
+		 * much is set aside whatever the size of the background.
 		 */
-		bgTracker[screen][index] = bgInitSub(index, BgType_Text8bpp, size, index * 4, (index < 3) ? index * 2 + 2 : index * 2 + 1);
-	}
-	else if(bgTracker[screen][index] == -1)
-	{
+		if(!allocBgVram(screen, BG_MAP_VRAM_SIZE, BG_TILE_VRAM_SIZE, &mapBase, &tileBase))
+		{
+			return -1;
+		}
+		bgMapBases[screen][index] = mapBase;
+		bgTileBases[screen][index] = tileBase;
+
 		/*
-		 * The background on the main screen is initialized with the default settings of a text bg.
+		 * Checks to see if the screen variable is <= 0, if it is then...
 		 */
-		bgTracker[screen][index] = bgInit(index, BgType_Text8bpp, size, index * 4, (index < 3) ? index * 2 + 2 : index * 2 + 1);
+		if (screen <= 0)
+		{
+			/*
+			 * the background on the sub screen is initialized with the default settings of a text bg.
+			 * If it is > 0, then...
+			 */
+			bgTracker[screen][index] = bgInitSub(index, BgType_Text8bpp, size, mapBase, tileBase);
+		}
+		else
+		{
+			/*
+			 * The background on the main screen is initialized with the default settings of a text bg.
+			 */
+			bgTracker[screen][index] = bgInit(index, BgType_Text8bpp, size, mapBase, tileBase);
+		}
 	}
 
 	/*
@@ -188,6 +233,11 @@ void deleteBg(int screen, int index)
 		return;
 	}
 
+	/*
+	 * Makes sure no queued map copies still use the map data.
+	*/
+	cancelVramUploads(bgGetMapPtr(bgTracker[screen][index]), BG_MAP_VRAM_SIZE);
+
 	if(mapData[screen][index] != NULL)
 	{
 		free(mapData[screen][index]);
@@ -210,10 +260,14 @@ void deleteBg(int screen, int index)
 	}
 	deleteBgCollisionMap(screen, index);
 
-	if(bgTracker[screen][index] != -1)
-	{
-		bgHide(bgTracker[screen][index]);
-	}
+	/*
+	 * Hides the background and gives its memory back to the VRAM planner,
+	 * so that the next background can use it.
+	*/
+	bgHide(bgTracker[screen][index]);
+	freeBgVram(screen, bgMapBases[screen][index], BG_MAP_VRAM_SIZE,
+			bgTileBases[screen][index], BG_TILE_VRAM_SIZE);
+	bgTracker[screen][index] = -1;
 }
 
 /*
@@ -249,6 +303,23 @@ void setBgTiles(int screen, int index, const unsigned int* tiles, u32 tileSize)
 	memcpy(bgGetGfxPtr(bgTracker[screen][index]), tileData[screen][index], tileSize);
 }
 
+/*
+ * Gets the amount of map data that the background reads when it streams
+ * its map blocks into VRAM.  This is the end of the second half of the
+ * last block it can scroll to.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @return Returns the size in bytes.
+ */
+static u32 getBgMapStreamSize(int screen, int index)
+{
+	u32 widthBlocks = bgSizes[screen][index].width >> 8;
+	u32 lastBlockX = (bgSizes[screen][index].width > 256) ? (bgSizes[screen][index].width - 256) >> 8 : 0;
+	u32 lastBlockY = (bgSizes[screen][index].height > 192) ? (bgSizes[screen][index].height - 192) >> 8 : 0;
+
+	return ((((lastBlockX + (lastBlockY * widthBlocks)) << 10) + (widthBlocks << 10)) << 1) + 4096;
+}
+
 /*
  * Sets the desired background's map.  This data draws the tiles at chosen positions.
  * @param screen The screen to create the background on.
@@ -258,6 +329,39 @@ void setBgTiles(int screen, int index, const unsigned int* tiles, u32 tileSize)
  */
 void setBgMap(int screen, int index, const unsigned short* map, u32 mapSize)
 {
+	/*
+	 * The background keeps its own copy of the map.
+	 */
+	unsigned short* copy = (unsigned short*)malloc(mapSize);
+	if(copy == NULL)
+	{
+		return;
+	}
+
+	// Copy the map to the map data pointer.
+	memcpy(copy, map, mapSize);
+
+	adoptBgMap(screen, index, copy, mapSize);
+}
+
+/*
+ * Gives the desired background a map that was allocated with malloc.  The
+ * background keeps the map, instead of copying it, and frees it when it is
+ * replaced or the background is deleted.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param map The map's data, which must not be used or freed afterwards.
+ * @param mapSize The size of the map's data.
+ */
+void adoptBgMap(int screen, int index, unsigned short* map, u32 mapSize)
+{
+	u32 streamSize = getBgMapStreamSize(screen, index);
+
+	/*
+	 * Makes sure no queued map copies still use the old map data.
+	*/
+	cancelVramUploads(bgGetMapPtr(bgTracker[screen][index]), BG_MAP_VRAM_SIZE);
+
 	if(mapData[screen][index] != NULL)
 	{
 		free(mapData[screen][index]);
@@ -265,12 +369,22 @@ void setBgMap(int screen, int index, const unsigned short* map, u32 mapSize)
 	}
 
 	/*
-	 * Allocate the appropriate amount of memory for the map.
+	 * The map blocks are copied to VRAM in whole halves, so a map that is
+	 * smaller than that is padded with empty tiles.
 	 */
-	mapData[screen][index] = calloc(mapSize, sizeof(unsigned short));
+	if(mapSize < streamSize)
+	{
+		unsigned short* padded = (unsigned short*)realloc(map, streamSize);
+		if(padded == NULL)
+		{
+			free(map);
+			return;
+		}
+		memset((u8*)padded + mapSize, 0, streamSize - mapSize);
+		map = padded;
+	}
 
-	// Copy the map to the map data pointer.
-	memcpy(mapData[screen][index], map, mapSize);
+	mapData[screen][index] = map;
 
 	/*
 	 * If one of the block values has changed, then the data for the background is copied over again, starting with the top half due to how the data is layed out.
@@ -283,6 +397,35 @@ void setBgMap(int screen, int index, const unsigned short* map, u32 mapSize)
 	memcpy(((unsigned short*)bgGetMapPtr(bgTracker[screen][index])) + 2048, mapData[screen][index] + ((0 + (0 * (bgSizes[screen][index].width >> 8))) << 10) + ((bgSizes[screen][index].width >> 8) << 10), 4096);
 }
 
+/*
+ * Gets the desired background's tile memory, so that tiles can be streamed
+ * straight into it.  The background's copy of its previous tiles is freed,
+ * since it no longer matches VRAM.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param size Set to the amount of tile memory reserved for the background.
+ * @return Returns a pointer to the tile memory, or NULL if the background
+ * has not been created.
+ */
+void* beginBgTileStream(int screen, int index, u32* size)
+{
+	*size = 0;
+
+	if(bgTracker[screen][index] == -1)
+	{
+		return NULL;
+	}
+
+	if(tileData[screen][index] != NULL)
+	{
+		free(tileData[screen][index]);
+		tileData[screen][index] = NULL;
+	}
+
+	*size = BG_TILE_VRAM_SIZE;
+	return bgGetGfxPtr(bgTracker[screen][index]);
+}
+
 /*
  * Sets the desired background's map with the desired
  * scroll amount.
@@ -316,6 +459,22 @@ void setBgPosition(int screen, int index, s32 x, s32 y)
 		y = y << (abs(bgParallaxYSpeeds[screen][index]));
 	}
 
+	/*
+	 * Moves the background to the adjusted position.
+	*/
+	setBgAbsolutePosition(screen, index, x, y);
+}
+
+/*
+ * Sets the desired background's map with the desired scroll
+ * amount, without applying the background's parallax speeds.
+ * @param screen The screen to create the background on.
+ * @param index The index (layer) to create the background on.
+ * @param x The x position to scroll to.
+ * @param y The y position to scroll to.
+ */
+void setBgAbsolutePosition(int screen, int index, s32 x, s32 y)
+{
 	/*
 	 * Sets the background's X coordinate.
 	*/
@@ -436,14 +595,16 @@ void setBgPosition(int screen, int index, s32 x, s32 y)
 	if(xBlocks[screen][index] != blockX || yBlocks[screen][index] != blockY)
 	{
 		/*
-		 * If one of the block values has changed, then the data for the background is copied over again, starting with the top half due to how the data is layed out.
+		 * If one of the block values has changed, then the data for the background is queued to be copied over again
+		 * when the frame is committed, so that it changes along with the scroll values.  The top half is first due to
+		 * how the data is layed out.
 		*/
-		memcpy(((unsigned short*)bgGetMapPtr(bgTracker[screen][index])), mapData[screen][index] + ((blockX + (blockY * (bgSizes[screen][index].width >> 8))) << 10), 4096);
+		queueVramUpload(((unsigned short*)bgGetMapPtr(bgTracker[screen][index])), mapData[screen][index] + ((blockX + (blockY * (bgSizes[screen][index].width >> 8))) << 10), 4096);
 
 		/*
-		 * Then copy the second half.
+		 * Then queue the second half.
 		*/
-		memcpy(((unsigned short*)bgGetMapPtr(bgTracker[screen][index])) + 2048, mapData[screen][index] + ((blockX + (blockY * (bgSizes[screen][index].width >> 8))) << 10) + ((bgSizes[screen][index].width >> 8) << 10), 4096);
+		queueVramUpload(((unsigned short*)bgGetMapPtr(bgTracker[screen][index])) + 2048, mapData[screen][index] + ((blockX + (blockY * (bgSizes[screen][index].width >> 8))) << 10) + ((bgSizes[screen][index].width >> 8) << 10), 4096);
 
 		/*
 		 * Sets the X block for the background to the new X block value.
@@ -455,9 +616,11 @@ void setBgPosition(int screen, int index, s32 x, s32 y)
 		yBlocks[screen][index] = blockY;
 	}
 	/*
-	 * Scrolls the background.
+	 * Stores the hardware scroll values for the background.  They are
+	 * given to the hardware by updateBackgrounds.
 	*/
-	bgSetScroll(bgTracker[screen][index], sx, sy);
+	bgScrolls[screen][index].x = sx;
+	bgScrolls[screen][index].y = sy;
 }
 
 /*
@@ -479,60 +642,31 @@ void setBgPalette(int screen, int index, const unsigned short* pal)
 	setBgUseGrayscale(screen, index, useGrayscale[screen][index]);
 
 	/*
-	 * Checks to see if the screen variable is <= 0.  If it is...
+	 * The screen's extended palette bank is set to map the LCD
+	 * while the palette is written to it.
 	 */
-	if (screen <= 0)
+	beginBgExtPaletteWrite(screen);
+	/*
+	 * Then, the palette is copied to the bank's
+	 * extended palette at the indicated slot.
+	 */
+	u16* extPalette = getBgExtPalette(screen, index);
+	if(extPalette != NULL)
 	{
-		/*
-		 * Then VRAM Bank H is used for the palette.
-		 * The first thing done is that the bank is
-		 * set to map the LCD.
-		 */
-		vramSetBankH(VRAM_H_LCD);
-		/*
-		 * Then, the palette is copied to the bank's
-		 * extended palette at the indicated slot.
-		 */
 		if(useGrayscale[screen][index])
 		{
-			memcpy((void*)(0x6898000 + (index << 13)), grayscalePaletteData[screen][index], 512);
+			memcpy(extPalette, grayscalePaletteData[screen][index], 512);
 		}
 		else
 		{
-			memcpy((void*)(0x6898000 + (index << 13)), paletteData[screen][index], 512);
+			memcpy(extPalette, paletteData[screen][index], 512);
 		}
-		/*
-		 * Finally, the bank is set to map its extended
-		 * palette slot.
-		 */
-		vramSetBankH(VRAM_H_SUB_BG_EXT_PALETTE);
-	}
-	else
-	{
-		/*
-		 * If it is > 0, then VRAM Bank E is sued for the palette.
-		 * The first thing done is that the bank is
-		 * set to map the LCD.
-		 */
-		vramSetBankE(VRAM_E_LCD);
-		/*
-		 * Then, the palette is copied to the bank's
-		 * extended palette at the indicated slot.
-		 */
-		if(useGrayscale[screen][index])
-		{
-			memcpy((void*)(0x6880000 + (index << 13)), grayscalePaletteData[screen][index], 512);
-		}
-		else
-		{
-			memcpy((void*)(0x6880000 + (index << 13)), paletteData[screen][index], 512);
-		}
-		/*
-		 * Finally, the bank is set to map its extended
-		 * palette slot.
-		 */
-		vramSetBankE(VRAM_E_BG_EXT_PALETTE);
 	}
+	/*
+	 * Finally, the bank is set to map its extended
+	 * palette slot.
+	 */
+	endBgExtPaletteWrite(screen);
 }
 
 /*
@@ -568,60 +702,31 @@ void setBgUseGrayscale(int screen, int index, bool use)
 	useGrayscale[screen][index] = use;
 
 	/*
-	 * Checks to see if the screen variable is <= 0.  If it is...
+	 * The screen's extended palette bank is set to map the LCD
+	 * while the palette is written to it.
 	 */
-	if (screen <= 0)
-	{
-		/*
-		 * Then VRAM Bank H is used for the palette.
-		 * The first thing done is that the bank is
-		 * set to map the LCD.
-		 */
-		vramSetBankH(VRAM_H_LCD);
-		/*
-		 * Then, the palette is copied to the bank's
-		 * extended palette at the indicated slot.
-		 */
-		if(useGrayscale[screen][index])
-		{
-			memcpy((void*)(0x6898000 + (index << 13)), grayscalePaletteData[screen][index], 512);
-		}
-		else
-		{
-			memcpy((void*)(0x6898000 + (index << 13)), paletteData[screen][index], 512);
-		}
-		/*
-		 * Finally, the bank is set to map its extended
-		 * palette slot.
-		 */
-		vramSetBankH(VRAM_H_SUB_BG_EXT_PALETTE);
-	}
-	else
+	beginBgExtPaletteWrite(screen);
+	/*
+	 * Then, the palette is copied to the bank's
+	 * extended palette at the indicated slot.
+	 */
+	u16* extPalette = getBgExtPalette(screen, index);
+	if(extPalette != NULL)
 	{
-		/*
-		 * If it is > 0, then VRAM Bank E is sued for the palette.
-		 * The first thing done is that the bank is
-		 * set to map the LCD.
-		 */
-		vramSetBankE(VRAM_E_LCD);
-		/*
-		 * Then, the palette is copied to the bank's
-		 * extended palette at the indicated slot.
-		 */
 		if(useGrayscale[screen][index])
 		{
-			memcpy((void*)(0x6880000 + (index << 13)), grayscalePaletteData[screen][index], 512);
+			memcpy(extPalette, grayscalePaletteData[screen][index], 512);
 		}
 		else
 		{
-			memcpy((void*)(0x6880000 + (index << 13)), paletteData[screen][index], 512);
+			memcpy(extPalette, paletteData[screen][index], 512);
 		}
-		/*
-		 * Finally, the bank is set to map its extended
-		 * palette slot.
-		 */
-		vramSetBankE(VRAM_E_BG_EXT_PALETTE);
 	}
+	/*
+	 * Finally, the bank is set to map its extended
+	 * palette slot.
+	 */
+	endBgExtPaletteWrite(screen);
 }
 
 /*
@@ -697,9 +802,70 @@ boundarySize_t getBgSize(int screen, int index)
 }
 
 /*
- * Updates the background system.
+ * Get's the libnds id of the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @return Returns the background's id, or -1 if it has not been created.
+ */
+int getBgId(int screen, int index)
+{
+	return bgTracker[(screen <= 0) ? 0 : 1][index];
+}
+
+/*
+ * Get's the desired background's hardware scroll values.
+ * @param screen The screen to get the scroll values from.
+ * @param index The index (layer) to get the scroll values from.
+ * @return Returns the scroll values written to the background's registers.
+ */
+coordinates_t getBgScroll(int screen, int index)
+{
+	return bgScrolls[screen][index];
+}
+
+/*
+ * Get's the desired background's absolute scroll position, which is the
+ * position of its map block plus its hardware scroll values.
+ * @param screen The screen to get the position from.
+ * @param index The index (layer) to get the position from.
+ * @return Returns the position of the background's top left corner on its map.
+ */
+coordinates_t getBgAbsoluteScroll(int screen, int index)
+{
+	coordinates_t position;
+
+	position.x = (xBlocks[screen][index] << 8) + bgScrolls[screen][index].x;
+	position.y = (yBlocks[screen][index] << 8) + bgScrolls[screen][index].y;
+
+	return position;
+}
+
+/*
+ * Updates the background system.  Sets the shadow scroll values of each
+ * background, which are written to the registers when the frame is committed.
 */
 void updateBackgrounds()
+{
+	int s = 0;
+	int i = 0;
+
+	for(s = 0;s < 2;s += 1)
+	{
+		for(i = 0;i < 4;i += 1)
+		{
+			if(bgTracker[s][i] != -1)
+			{
+				bgSetScroll(bgTracker[s][i], bgScrolls[s][i].x, bgScrolls[s][i].y);
+			}
+		}
+	}
+}
+
+/*
+ * Writes the shadow scroll values to the background registers.  Called
+ * during the vertical blank when the frame is committed.
+*/
+void commitBackgrounds()
 {
 	/*
 	 * Updates the background so that the scrolling is updated.
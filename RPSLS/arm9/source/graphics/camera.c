@@ -0,0 +1,218 @@
+/*
+ * Contains a camera for scrolling several backgrounds (and sprites) at
+ * once.  The camera's position is kept in 20.12 fixed point, and each
+ * background bound to it has its own fixed point speed, which allows any
+ * parallax ratio instead of only powers of two.
+ */
+#include "camera.h"
+#include "backgrounds.h"
+#include "sprites.h"
+
+/*
+ * Scales a camera position by a speed, both in fixed point.
+ * @param position The camera's position (20.12 fixed point).
+ * @param speed The speed to scale by (fixed point).
+ * @return Returns the scaled position as an integer.
+ */
+static s32 scaleCameraPosition(s32 position, s32 speed)
+{
+	return (s32)(((s64)position * speed) >> (CAMERA_FIXED_SHIFT * 2));
+}
+
+/*
+ * Initializes a camera at position (0, 0) with nothing bound to it.
+ * @param camera The camera to initialize.
+ */
+void initCamera(camera_t* camera)
+{
+	memset(camera, 0, sizeof(camera_t));
+}
+
+/*
+ * Sets the camera's position.
+ * @param camera The camera to move.
+ * @param x The x position (20.12 fixed point).
+ * @param y The y position (20.12 fixed point).
+ */
+void setCameraPosition(camera_t* camera, s32 x, s32 y)
+{
+	camera->x = x;
+	camera->y = y;
+}
+
+/*
+ * Moves the camera by the desired amount.
+ * @param camera The camera to move.
+ * @param dx The amount to move on the x axis (20.12 fixed point).
+ * @param dy The amount to move on the y axis (20.12 fixed point).
+ */
+void moveCamera(camera_t* camera, s32 dx, s32 dy)
+{
+	camera->x += dx;
+	camera->y += dy;
+}
+
+/*
+ * Binds a background to the camera.  The background's parallax speeds
+ * set with setBgParallaxSpeeds are not used while it is bound.
+ * @param camera The camera to bind to.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param speedX The x speed of the background (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ * @param speedY The y speed of the background (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ */
+void bindCameraLayer(camera_t* camera, int screen, int index, s32 speedX, s32 speedY)
+{
+	screen = (screen <= 0) ? 0 : 1;
+
+	camera->boundLayers[screen][index] = true;
+	camera->layerSpeedsX[screen][index] = speedX;
+	camera->layerSpeedsY[screen][index] = speedY;
+	/*
+	 * Makes sure the background is scrolled on the next update.
+	 */
+	camera->layerUpdated[screen][index] = false;
+}
+
+/*
+ * Unbinds a background from the camera.
+ * @param camera The camera to unbind from.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+void unbindCameraLayer(camera_t* camera, int screen, int index)
+{
+	screen = (screen <= 0) ? 0 : 1;
+
+	camera->boundLayers[screen][index] = false;
+}
+
+/*
+ * Binds a sprite to the camera.
+ * @param camera The camera to bind to.
+ * @param screen The screen the sprite is on.
+ * @param index The index of the sprite.
+ * @param x The sprite's x position in the world.
+ * @param y The sprite's y position in the world.
+ * @param speed The sprite's speed (fixed point, CAMERA_SPEED_NORMAL is 1.0).
+ * @return Returns the slot the sprite was bound to, or -1 if there are no free slots.
+ */
+int bindCameraSprite(camera_t* camera, int screen, int index, int x, int y, s32 speed)
+{
+	int i = 0;
+
+	for(i = 0;i < MAX_CAMERA_SPRITES;i += 1)
+	{
+		if(!camera->sprites[i].active)
+		{
+			camera->sprites[i].active = true;
+			camera->sprites[i].screen = (screen <= 0) ? 0 : 1;
+			camera->sprites[i].index = index;
+			camera->sprites[i].world.x = x;
+			camera->sprites[i].world.y = y;
+			camera->sprites[i].speed = speed;
+			/*
+			 * An impossible position is used so that the sprite
+			 * is always moved on the next update.
+			 */
+			camera->sprites[i].position.x = 0x7FFFFFFF;
+			camera->sprites[i].position.y = 0x7FFFFFFF;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Sets the world position of a sprite bound to the camera.
+ * @param camera The camera the sprite is bound to.
+ * @param slot The slot returned by bindCameraSprite.
+ * @param x The sprite's x position in the world.
+ * @param y The sprite's y position in the world.
+ */
+void setCameraSpritePosition(camera_t* camera, int slot, int x, int y)
+{
+	if(slot < 0 || slot >= MAX_CAMERA_SPRITES)
+	{
+		return;
+	}
+	camera->sprites[slot].world.x = x;
+	camera->sprites[slot].world.y = y;
+}
+
+/*
+ * Unbinds a sprite from the camera.
+ * @param camera The camera the sprite is bound to.
+ * @param slot The slot returned by bindCameraSprite.
+ */
+void unbindCameraSprite(camera_t* camera, int slot)
+{
+	if(slot < 0 || slot >= MAX_CAMERA_SPRITES)
+	{
+		return;
+	}
+	camera->sprites[slot].active = false;
+}
+
+/*
+ * Moves all of the backgrounds and sprites bound to the camera.  Should be
+ * called once per frame.  Backgrounds whose position did not change are
+ * left alone, so their maps are only streamed when they actually move.
+ * @param camera The camera to update.
+ */
+void updateCamera(camera_t* camera)
+{
+	int s = 0;
+	int i = 0;
+
+	/*
+	 * Goes through the backgrounds on both screens.
+	 */
+	for(s = 0;s < 2;s += 1)
+	{
+		for(i = 0;i < 4;i += 1)
+		{
+			if(!camera->boundLayers[s][i])
+			{
+				continue;
+			}
+
+			s32 x = scaleCameraPosition(camera->x, camera->layerSpeedsX[s][i]);
+			s32 y = scaleCameraPosition(camera->y, camera->layerSpeedsY[s][i]);
+
+			/*
+			 * Only moves the background if its visible window moved.
+			 */
+			if(!camera->layerUpdated[s][i] || x != camera->layerPositions[s][i].x
+					|| y != camera->layerPositions[s][i].y)
+			{
+				setBgAbsolutePosition(s, i, x, y);
+				camera->layerPositions[s][i].x = x;
+				camera->layerPositions[s][i].y = y;
+				camera->layerUpdated[s][i] = true;
+			}
+		}
+	}
+
+	/*
+	 * Then goes through the sprites.
+	 */
+	for(i = 0;i < MAX_CAMERA_SPRITES;i += 1)
+	{
+		cameraSprite_t* sprite = &camera->sprites[i];
+		if(!sprite->active)
+		{
+			continue;
+		}
+
+		s32 x = sprite->world.x - scaleCameraPosition(camera->x, sprite->speed);
+		s32 y = sprite->world.y - scaleCameraPosition(camera->y, sprite->speed);
+
+		if(x != sprite->position.x || y != sprite->position.y)
+		{
+			setSpriteXY(sprite->screen, sprite->index, x, y);
+			sprite->position.x = x;
+			sprite->position.y = y;
+		}
+	}
+}
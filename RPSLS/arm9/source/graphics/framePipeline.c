@@ -0,0 +1,239 @@
+/*
+ * Contains the frame pipeline.  Each frame is split in two: updateAll
+ * prepares the frame while the screens are being drawn (shadow OAM, shadow
+ * scroll values, text widget changes and queued VRAM uploads), and the
+ * vertical blank interrupt then commits all of it at once, at the very
+ * start of the vertical blank.
+ */
+#include "framePipeline.h"
+#include "backgrounds.h"
+#include "scanlineEffects.h"
+#include "textWidgets.h"
+#include "inputFunctions.h"
+#include "profiler.h"
+
+/*
+ * A structure for a queued VRAM upload.
+ * dest - Where to copy to.
+ * src - The data to copy.
+ * size - The amount of bytes to copy.
+ */
+typedef struct vramUpload_t
+{
+	void* dest;
+	const void* src;
+	u32 size;
+} vramUpload_t;
+
+/*
+ * The queued uploads.
+ */
+vramUpload_t vramUploads[MAX_VRAM_UPLOADS];
+
+/*
+ * The amount of queued uploads.
+ */
+int vramUploadCount = 0;
+
+/*
+ * Tells whether a frame has been prepared and is waiting to be committed.
+ */
+volatile bool frameReady = false;
+
+/*
+ * The amount of committed frames.
+ */
+volatile u32 frameCommitCount = 0;
+
+/*
+ * The amount of vertical blanks with no frame to commit.
+ */
+volatile u32 idleVBlankCount = 0;
+
+/*
+ * Commits the prepared frame.  Runs in the vertical blank interrupt.
+ */
+static void commitFrame()
+{
+	int i = 0;
+
+	/*
+	 * The input is sampled at the same point of every frame, whether or
+	 * not the game is keeping up.
+	 */
+	sampleInput();
+
+	/*
+	 * The sprites and scroll values are written first, since they
+	 * are small and must land before the screens start drawing.
+	 */
+	if(frameReady)
+	{
+		oamUpdate(&oamMain);
+		oamUpdate(&oamSub);
+		commitBackgrounds();
+	}
+
+	/*
+	 * The scanline tables are double buffered, so the HBlank DMAs are
+	 * restarted every vertical blank, even if no new frame is ready.
+	 * This comes after the backgrounds, since it writes line 0 of each
+	 * effect layer to the same scroll registers.
+	 */
+	commitScanlineEffects();
+
+	if(!frameReady)
+	{
+		idleVBlankCount += 1;
+		return;
+	}
+
+	for(i = 0;i < vramUploadCount;i += 1)
+	{
+		dmaCopyHalfWords(VRAM_UPLOAD_DMA_CHANNEL, vramUploads[i].src, vramUploads[i].dest,
+				vramUploads[i].size);
+	}
+	vramUploadCount = 0;
+
+	commitTextWidgets();
+
+	frameCommitCount += 1;
+	frameReady = false;
+}
+
+/*
+ * The vertical blank interrupt.  Commits the frame, and in profiling
+ * builds records the time it took as the "commit" scope.
+ */
+static void frameVBlankInterrupt()
+{
+#ifdef GEM_PROFILE
+	u32 start = cpuGetTiming();
+#endif
+
+	commitFrame();
+
+	PROFILE_ADD("commit", cpuGetTiming() - start);
+}
+
+/*
+ * Sets up the vertical blank interrupt that commits each frame.
+ * Called by initVideo.
+ */
+void initFramePipeline()
+{
+	vramUploadCount = 0;
+	frameReady = false;
+
+	irqSet(IRQ_VBLANK, frameVBlankInterrupt);
+	irqEnable(IRQ_VBLANK);
+}
+
+/*
+ * Queues a copy to VRAM that is done when the frame is committed.  Copies
+ * to the same place are merged, so only the latest one is done.  The data
+ * must stay valid until the frame is committed.
+ * @param dest Where to copy to in VRAM.
+ * @param src The data to copy.
+ * @param size The amount of bytes to copy (a multiple of 2).
+ * @return Returns true if the copy was queued, false if the queue was full
+ * and the copy was done right away instead.
+ */
+bool queueVramUpload(void* dest, const void* src, u32 size)
+{
+	int i = 0;
+
+	/*
+	 * The data is read by DMA, so it must be written out of the cache.
+	 */
+	DC_FlushRange(src, size);
+
+	for(i = 0;i < vramUploadCount;i += 1)
+	{
+		if(vramUploads[i].dest == dest)
+		{
+			vramUploads[i].src = src;
+			vramUploads[i].size = size;
+			return true;
+		}
+	}
+
+	if(vramUploadCount >= MAX_VRAM_UPLOADS)
+	{
+		memcpy(dest, src, size);
+		return false;
+	}
+
+	vramUploads[vramUploadCount].dest = dest;
+	vramUploads[vramUploadCount].src = src;
+	vramUploads[vramUploadCount].size = size;
+	vramUploadCount += 1;
+	return true;
+}
+
+/*
+ * Removes any queued copies to a range of VRAM.  Used when the memory is
+ * given back before the frame is committed.
+ * @param dest The start of the range.
+ * @param size The size of the range in bytes.
+ */
+void cancelVramUploads(void* dest, u32 size)
+{
+	int i = 0;
+	u8* start = (u8*)dest;
+	u8* end = start + size;
+
+	for(i = 0;i < vramUploadCount;)
+	{
+		u8* uploadDest = (u8*)vramUploads[i].dest;
+		if(uploadDest >= start && uploadDest < end)
+		{
+			vramUploadCount -= 1;
+			vramUploads[i] = vramUploads[vramUploadCount];
+		}
+		else
+		{
+			i += 1;
+		}
+	}
+}
+
+/*
+ * Marks the frame as prepared, so that it is committed in the next
+ * vertical blank.
+ */
+void submitFrame()
+{
+	frameReady = true;
+}
+
+/*
+ * Waits until the submitted frame has been committed.
+ */
+void waitForFrameCommit()
+{
+	while(frameReady)
+	{
+		swiWaitForVBlank();
+	}
+}
+
+/*
+ * Gets the amount of frames that have been committed.
+ * @return Returns the amount of committed frames.
+ */
+u32 getFrameCommitCount()
+{
+	return frameCommitCount;
+}
+
+/*
+ * Gets the amount of vertical blanks that happened with no frame ready to
+ * commit (IE: the frame took too long to prepare, or the game was waiting
+ * on its own).
+ * @return Returns the amount of idle vertical blanks.
+ */
+u32 getIdleVBlankCount()
+{
+	return idleVBlankCount;
+}
@@ -0,0 +1,469 @@
+/*
+ * Contains a set of functions for per scanline background effects.  Each
+ * screen keeps a table with the scroll values of its four backgrounds for
+ * every scanline, which is fed to the scroll registers by an HBlank DMA.
+ * This allows parallax, wave and split screen effects without using the
+ * CPU while the screen is being drawn.
+ */
+#include "scanlineEffects.h"
+
+/*
+ * This is a structure for holding the effects
+ * of a single background.
+ */
+typedef struct _scanlineLayer_t_
+{
+	/*
+	 * The x offset of each scanline.
+	 */
+	s16 x[SCANLINE_COUNT];
+	/*
+	 * The y offset of each scanline.
+	 */
+	s16 y[SCANLINE_COUNT];
+	/*
+	 * The parallax speed of each scanline
+	 * (8 bit fixed point, may be negative).
+	 */
+	s32 speed[SCANLINE_COUNT];
+	/*
+	 * The amplitude of the wave in pixels.
+	 */
+	int waveAmplitude;
+	/*
+	 * How far the wave's angle moves on each scanline.
+	 */
+	int waveStep;
+	/*
+	 * How far the wave's angle moves on each frame.
+	 */
+	int waveSpeed;
+	/*
+	 * The current angle of the wave on the first scanline.
+	 */
+	int wavePhase;
+} scanlineLayer_t;
+
+/*
+ * The effects for each background.  NULL when the background
+ * does not use scanline effects.
+ */
+scanlineLayer_t* scanlineLayers[2][4];
+
+/*
+ * The scroll tables for each screen.  Each table has one more entry than
+ * there are scanlines, since the DMA writes the values for the next line
+ * during each HBlank.  The tables are double buffered so that the next one
+ * can be built while the current one is being read.
+ */
+u32 scanlineTables[2][2][SCANLINE_COUNT + 1][4] ALIGN(32);
+
+/*
+ * The table that is currently being read by each screen's DMA.
+ */
+int scanlineFrontTable[2];
+
+/*
+ * Tells whether a newly built table is waiting to be swapped in.
+ */
+bool scanlineTablePending[2];
+
+/*
+ * Tells whether each screen has a built table at all.
+ */
+bool scanlineTableReady[2];
+
+/*
+ * Tells whether each screen's table needs to be rebuilt.
+ */
+bool scanlineTableDirty[2];
+
+/*
+ * Tells whether each screen's DMA is running.
+ */
+bool scanlineDmaRunning[2];
+
+/*
+ * The background scroll values the tables were last built with.
+ */
+coordinates_t scanlineBaseScrolls[2][4];
+
+/*
+ * The absolute background positions the tables were last built with.
+ */
+coordinates_t scanlineAbsoluteScrolls[2][4];
+
+/*
+ * Gets the scroll registers for the desired screen.
+ * @param screen The screen to get the registers for.
+ * @return Returns a pointer to the first background's scroll registers.
+ */
+static vu32* getScanlineRegisters(int screen)
+{
+	return (screen <= 0) ? (vu32*)&REG_BG0HOFS_SUB : (vu32*)&REG_BG0HOFS;
+}
+
+/*
+ * Packs a scroll value into the layout of the scroll registers.
+ * @param x The x scroll value.
+ * @param y The y scroll value.
+ * @return Returns the value for a background's HOFS/VOFS register pair.
+ */
+static u32 packScanlineScroll(s32 x, s32 y)
+{
+	return (x & 0x1FF) | ((y & 0x1FF) << 16);
+}
+
+/*
+ * Enables the scanline effects for the desired background.  All of its
+ * scanlines start at the background's normal scroll value.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+void enableBgScanlineEffects(int screen, int index)
+{
+	int i = 0;
+
+	/*
+	 * Checks to see if the screen variable is <= 0.
+	 */
+	screen = (screen <= 0) ? 0 : 1;
+
+	/*
+	 * Nothing needs to be done if the effects are already on.
+	 */
+	if(scanlineLayers[screen][index] != NULL)
+	{
+		return;
+	}
+
+	scanlineLayers[screen][index] = (scanlineLayer_t*)calloc(1, sizeof(scanlineLayer_t));
+
+	/*
+	 * Every scanline starts with the normal parallax speed.
+	 */
+	for(i = 0;i < SCANLINE_COUNT;i += 1)
+	{
+		scanlineLayers[screen][index]->speed[i] = SCANLINE_SPEED_NORMAL;
+	}
+
+	scanlineTableDirty[screen] = true;
+}
+
+/*
+ * Disables the scanline effects for the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ */
+void disableBgScanlineEffects(int screen, int index)
+{
+	screen = (screen <= 0) ? 0 : 1;
+
+	if(scanlineLayers[screen][index] != NULL)
+	{
+		free(scanlineLayers[screen][index]);
+		scanlineLayers[screen][index] = NULL;
+	}
+
+	scanlineTableDirty[screen] = true;
+}
+
+/*
+ * Sets the scroll offset of a single scanline on the desired background.
+ * The offset is added to the background's normal scroll value.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param line The scanline to set (0-191).
+ * @param x The x offset for the scanline.
+ * @param y The y offset for the scanline.
+ */
+void setBgScanlineOffset(int screen, int index, int line, s32 x, s32 y)
+{
+	setBgScanlineBand(screen, index, line, line, x, y);
+}
+
+/*
+ * Sets the scroll offset of a band of scanlines on the desired background.
+ * Can be used for split screen effects.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param firstLine The first scanline of the band.
+ * @param lastLine The last scanline of the band.
+ * @param x The x offset for the band.
+ * @param y The y offset for the band.
+ */
+void setBgScanlineBand(int screen, int index, int firstLine, int lastLine, s32 x, s32 y)
+{
+	int i = 0;
+
+	screen = (screen <= 0) ? 0 : 1;
+
+	/*
+	 * Makes sure that the band stays within the screen.
+	 */
+	if(firstLine < 0)
+	{
+		firstLine = 0;
+	}
+	if(lastLine >= SCANLINE_COUNT)
+	{
+		lastLine = SCANLINE_COUNT - 1;
+	}
+
+	enableBgScanlineEffects(screen, index);
+
+	for(i = firstLine;i <= lastLine;i += 1)
+	{
+		scanlineLayers[screen][index]->x[i] = x;
+		scanlineLayers[screen][index]->y[i] = y;
+	}
+
+	scanlineTableDirty[screen] = true;
+}
+
+/*
+ * Sets the parallax speeds for a band of scanlines on the desired background.
+ * The speed is interpolated from the first line to the last line, and the
+ * background's absolute x position is multiplied by it on each scanline.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param firstLine The first scanline of the band.
+ * @param lastLine The last scanline of the band.
+ * @param startSpeed The speed at the first line (8 bit fixed point, 256 is normal).
+ * @param endSpeed The speed at the last line (8 bit fixed point, 256 is normal).
+ */
+void setBgScanlineParallax(int screen, int index, int firstLine, int lastLine,
+		int startSpeed, int endSpeed)
+{
+	int i = 0;
+
+	screen = (screen <= 0) ? 0 : 1;
+
+	if(firstLine < 0)
+	{
+		firstLine = 0;
+	}
+	if(lastLine >= SCANLINE_COUNT)
+	{
+		lastLine = SCANLINE_COUNT - 1;
+	}
+	if(lastLine < firstLine)
+	{
+		return;
+	}
+
+	enableBgScanlineEffects(screen, index);
+
+	/*
+	 * Interpolates the speed across the band.
+	 */
+	for(i = firstLine;i <= lastLine;i += 1)
+	{
+		if(lastLine == firstLine)
+		{
+			scanlineLayers[screen][index]->speed[i] = startSpeed;
+		}
+		else
+		{
+			scanlineLayers[screen][index]->speed[i] = startSpeed
+					+ ((endSpeed - startSpeed) * (i - firstLine)) / (lastLine - firstLine);
+		}
+	}
+
+	scanlineTableDirty[screen] = true;
+}
+
+/*
+ * Sets a horizontal wave on the desired background.
+ * @param screen The screen the background is on.
+ * @param index The index (layer) of the background.
+ * @param amplitude The amplitude of the wave in pixels (0 to turn it off).
+ * @param wavelength The length of one wave in scanlines.
+ * @param speed How far the wave moves each frame (32768 is a full wave).
+ */
+void setBgScanlineWave(int screen, int index, int amplitude, int wavelength, int speed)
+{
+	screen = (screen <= 0) ? 0 : 1;
+
+	enableBgScanlineEffects(screen, index);
+
+	scanlineLayers[screen][index]->waveAmplitude = amplitude;
+	scanlineLayers[screen][index]->waveStep = (wavelength > 0) ? 32768 / wavelength : 0;
+	scanlineLayers[screen][index]->waveSpeed = speed;
+
+	scanlineTableDirty[screen] = true;
+}
+
+/*
+ * Builds the scanline tables for the next frame.  Should be called once
+ * per frame before waiting for the vertical blank.
+ */
+void updateScanlineEffects()
+{
+	int s = 0;
+	int i = 0;
+	int line = 0;
+
+	for(s = 0;s < 2;s += 1)
+	{
+		bool active = false;
+
+		/*
+		 * Checks which backgrounds use effects, and moves any waves along.
+		 */
+		for(i = 0;i < 4;i += 1)
+		{
+			scanlineLayer_t* layer = scanlineLayers[s][i];
+			if(layer != NULL)
+			{
+				active = true;
+				if(layer->waveAmplitude != 0 && layer->waveSpeed != 0)
+				{
+					layer->wavePhase = (layer->wavePhase + layer->waveSpeed) & 0x7FFF;
+					scanlineTableDirty[s] = true;
+				}
+			}
+		}
+
+		/*
+		 * The scroll values of every background go in the table, so it needs
+		 * to be rebuilt whenever one of them scrolls.
+		 */
+		for(i = 0;i < 4;i += 1)
+		{
+			coordinates_t scroll = getBgScroll(s, i);
+			coordinates_t absolute = getBgAbsoluteScroll(s, i);
+			if(scroll.x != scanlineBaseScrolls[s][i].x || scroll.y != scanlineBaseScrolls[s][i].y
+					|| absolute.x != scanlineAbsoluteScrolls[s][i].x || absolute.y != scanlineAbsoluteScrolls[s][i].y)
+			{
+				scanlineBaseScrolls[s][i] = scroll;
+				scanlineAbsoluteScrolls[s][i] = absolute;
+				scanlineTableDirty[s] = true;
+			}
+		}
+
+		if(!active || !scanlineTableDirty[s])
+		{
+			continue;
+		}
+
+		/*
+		 * Builds the table that is not being read by the DMA.
+		 */
+		u32 (*table)[4] = scanlineTables[s][scanlineFrontTable[s] ^ 1];
+
+		for(line = 0;line < SCANLINE_COUNT;line += 1)
+		{
+			for(i = 0;i < 4;i += 1)
+			{
+				scanlineLayer_t* layer = scanlineLayers[s][i];
+				s32 x = scanlineBaseScrolls[s][i].x;
+				s32 y = scanlineBaseScrolls[s][i].y;
+
+				if(layer != NULL)
+				{
+					/*
+					 * The speed scales the background's absolute position, since
+					 * the scroll value restarts at every map block.  The result is
+					 * made relative to the block that is currently in VRAM.
+					 */
+					s32 absoluteX = scanlineAbsoluteScrolls[s][i].x;
+					x += ((absoluteX * layer->speed[line]) >> 8) - absoluteX + layer->x[line];
+					y += layer->y[line];
+
+					if(layer->waveAmplitude != 0)
+					{
+						x += (layer->waveAmplitude * sinLerp(layer->wavePhase + line * layer->waveStep)) >> 12;
+					}
+				}
+
+				table[line][i] = packScanlineScroll(x, y);
+			}
+		}
+
+		/*
+		 * The DMA also fires on the last visible line, so the extra entry
+		 * repeats the first line.
+		 */
+		memcpy(table[SCANLINE_COUNT], table[0], sizeof(table[0]));
+
+		/*
+		 * The DMA reads from main memory, so the table has to
+		 * be flushed out of the data cache.
+		 */
+		DC_FlushRange(table, sizeof(scanlineTables[s][0]));
+
+		scanlineTablePending[s] = true;
+		scanlineTableReady[s] = true;
+		scanlineTableDirty[s] = false;
+	}
+}
+
+/*
+ * Swaps in the scanline tables and restarts the HBlank DMAs.  Must be
+ * called during the vertical blank.
+ */
+void commitScanlineEffects()
+{
+	int s = 0;
+	int i = 0;
+
+	for(s = 0;s < 2;s += 1)
+	{
+		int channel = (s == 0) ? SCANLINE_DMA_CHANNEL_SUB : SCANLINE_DMA_CHANNEL_MAIN;
+		vu32* registers = getScanlineRegisters(s);
+		bool active = false;
+
+		for(i = 0;i < 4;i += 1)
+		{
+			active = active || (scanlineLayers[s][i] != NULL);
+		}
+
+		if(!active || !scanlineTableReady[s])
+		{
+			/*
+			 * If the effects were just turned off, the DMA is stopped and the
+			 * backgrounds are put back to their normal scroll values.
+			 */
+			if(scanlineDmaRunning[s])
+			{
+				DMA_CR(channel) = 0;
+				for(i = 0;i < 4;i += 1)
+				{
+					coordinates_t scroll = getBgScroll(s, i);
+					registers[i] = packScanlineScroll(scroll.x, scroll.y);
+				}
+				scanlineDmaRunning[s] = false;
+				scanlineTableReady[s] = false;
+			}
+			continue;
+		}
+
+		/*
+		 * Swaps in the newly built table.
+		 */
+		if(scanlineTablePending[s])
+		{
+			scanlineFrontTable[s] ^= 1;
+			scanlineTablePending[s] = false;
+		}
+
+		u32 (*table)[4] = scanlineTables[s][scanlineFrontTable[s]];
+
+		/*
+		 * The first line is written straight to the registers, and the DMA
+		 * is restarted to write the rest, one line per HBlank.
+		 */
+		DMA_CR(channel) = 0;
+		for(i = 0;i < 4;i += 1)
+		{
+			registers[i] = table[0][i];
+		}
+		DMA_SRC(channel) = (u32)table[1];
+		DMA_DEST(channel) = (u32)registers;
+		DMA_CR(channel) = DMA_ENABLE | DMA_REPEAT | DMA_START_HBL | DMA_32_BIT
+				| DMA_SRC_INC | DMA_DST_RESET | 4;
+
+		scanlineDmaRunning[s] = true;
+	}
+}
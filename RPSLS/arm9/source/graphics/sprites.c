@@ -4,6 +4,9 @@
  * Created by: Gerald McAlister
  */
 #include "sprites.h"
+#include "vramPlanner.h"
+#include "framePipeline.h"
+#include "assetCache.h"
 
 /*
  *Gets the size of the sprite if the sizes are equal.  Used for the GET_SIZE define.
@@ -92,17 +95,33 @@ typedef struct _sprite_t_
 	 * or not.
 	 */
 	bool isCopy;
+	/*
+	 * Tells whether the sprite's graphics and palette data
+	 * belong to the asset cache, and so are released to it
+	 * instead of being freed.
+	 */
+	bool sharedData;
 
 	/*
 	 * The graphics memory for where the
 	 * sprite's graphics data is located.
 	 */
 	u16* gfxMemory;
+	/*
+	 * The size of the graphics memory that was
+	 * allocated for the sprite.
+	 */
+	u32 gfxMemorySize;
 	/*
 	 * The current frame's data.  Holds the
 	 * graphical data for the current frame.
 	 */
 	u16* frameData;
+	/*
+	 * The frame whose graphics are in the sprite's
+	 * graphics memory, or -1 if none are yet.
+	 */
+	int uploadedFrame;
 	/*
 	 * The graphic's data.  Holds the
 	 * graphical data for the sprite.
@@ -152,6 +171,20 @@ sprite_t spriteList[2][MAX_SPRITES];
  */
 void loadData(int screen, int index, bool gfx, bool pal)
 {
+	/*
+	 * If the graphics memory is being allocated again, then the current
+	 * frame will need to be copied into it again too.
+	 */
+	if (gfx)
+	{
+		if(spriteList[screen][index].frameData != NULL)
+		{
+			free(spriteList[screen][index].frameData);
+			spriteList[screen][index].frameData = NULL;
+		}
+		spriteList[screen][index].uploadedFrame = -1;
+	}
+
 	/*
 	 * Checks to see if the screen is equal to 0.
 	 */
@@ -165,28 +198,32 @@ void loadData(int screen, int index, bool gfx, bool pal)
 		{
 			/*
 			 * If it should, then since this is the bottom screen, and since
-			 * extended palettes are being used, then VRAM Bank I is set to
-			 * map the LCD while the data is written to it.
+			 * extended palettes are being used, then its extended sprite palette
+			 * bank is set to map the LCD while the data is written to it.
 			 */
-			vramSetBankI(VRAM_I_LCD);
+			beginSpriteExtPaletteWrite(screen);
 			/*
 			 * This is where the data is copied to the screen. Palettes
-			 * have a length of 512, and the data is written to VRAM Bank
-			 * I's extended palette area, at the sprite's palette index.
+			 * have a length of 512, and the data is written to the bank's
+			 * extended palette area, at the sprite's palette index.
 			 */
-			if(spriteList[screen][index].useGrayscale)
-			{
-				memcpy(VRAM_I_EXT_SPR_PALETTE[spriteList[screen][index].paletteSlot], spriteList[screen][index].grayscalePaletteData, 512);
-			}
-			else
+			u16* extPalette = getSpriteExtPalette(screen, spriteList[screen][index].paletteSlot);
+			if(extPalette != NULL)
 			{
-				memcpy(VRAM_I_EXT_SPR_PALETTE[spriteList[screen][index].paletteSlot], spriteList[screen][index].paletteData, 512);
+				if(spriteList[screen][index].useGrayscale)
+				{
+					memcpy(extPalette, spriteList[screen][index].grayscalePaletteData, 512);
+				}
+				else
+				{
+					memcpy(extPalette, spriteList[screen][index].paletteData, 512);
+				}
 			}
 			/*
-			 * Finally, VRAM Bank I is set to map the extended palette
+			 * Finally, the bank is set to map the extended palette
 			 * slot instead, so that it will be ready to use.
 			 */
-			vramSetBankI(VRAM_I_SUB_SPRITE_EXT_PALETTE);
+			endSpriteExtPaletteWrite(screen);
 		}
 		/*
 		 * Then, it checks to see if it should allocate memory for the
@@ -201,6 +238,8 @@ void loadData(int screen, int index, bool gfx, bool pal)
 			{
 				oamFreeGfx(&oamSub, spriteList[screen][index].gfxMemory);
 				spriteList[screen][index].gfxMemory = NULL;
+				trackSpriteVram(screen, -(s32)spriteList[screen][index].gfxMemorySize);
+				spriteList[screen][index].gfxMemorySize = 0;
 			}
 		
 			/*
@@ -213,6 +252,16 @@ void loadData(int screen, int index, bool gfx, bool pal)
 							&oamSub,
 							(SpriteSize) SPRITE_PIXELS_SIZE(spriteList[screen][index].bRect.size.width, spriteList[screen][index].bRect.size.height),
 							SpriteColorFormat_256Color);
+
+			/*
+			 * Keeps track of how much sprite memory is being used.
+			 */
+			if(spriteList[screen][index].gfxMemory)
+			{
+				spriteList[screen][index].gfxMemorySize = spriteList[screen][index].bRect.size.width
+						* spriteList[screen][index].bRect.size.height;
+				trackSpriteVram(screen, spriteList[screen][index].gfxMemorySize);
+			}
 		}
 		/*
 		 * Then, we return out so that it doesn't check for the other screen since
@@ -233,26 +282,31 @@ void loadData(int screen, int index, bool gfx, bool pal)
 		if (pal)
 		{
 			/*
-			 * If so, then VRAM Bank G is set to map the LCD for the top screen.
+			 * If so, then the top screen's extended sprite palette bank
+			 * is set to map the LCD.
 			 */
-			vramSetBankG(VRAM_G_LCD);
+			beginSpriteExtPaletteWrite(screen);
 			/*
-			 * Then, the data is copied with a length of 512 to VRAM Bank F's
+			 * Then, the data is copied with a length of 512 to the bank's
 			 * extended palette slot at the sprite's palette index.
 			 */
-			if(spriteList[screen][index].useGrayscale)
+			u16* extPalette = getSpriteExtPalette(screen, spriteList[screen][index].paletteSlot);
+			if(extPalette != NULL)
 			{
-				memcpy(VRAM_G_EXT_SPR_PALETTE[spriteList[screen][index].paletteSlot], spriteList[screen][index].grayscalePaletteData, 512);
-			}
-			else
-			{
-				memcpy(VRAM_G_EXT_SPR_PALETTE[spriteList[screen][index].paletteSlot], spriteList[screen][index].paletteData, 512);
+				if(spriteList[screen][index].useGrayscale)
+				{
+					memcpy(extPalette, spriteList[screen][index].grayscalePaletteData, 512);
+				}
+				else
+				{
+					memcpy(extPalette, spriteList[screen][index].paletteData, 512);
+				}
 			}
 			/*
-			 * Finally, VRAM Bank G is set to map the extended palette
+			 * Finally, the bank is set to map the extended palette
 			 * slot instead.
 			 */
-			vramSetBankG(VRAM_G_SPRITE_EXT_PALETTE);
+			endSpriteExtPaletteWrite(screen);
 		}
 		/*
 		 * Then, it checks to see if it should allocate for the
@@ -267,6 +321,8 @@ void loadData(int screen, int index, bool gfx, bool pal)
 			{
 				oamFreeGfx(&oamMain, spriteList[screen][index].gfxMemory);
 				spriteList[screen][index].gfxMemory = NULL;
+				trackSpriteVram(screen, -(s32)spriteList[screen][index].gfxMemorySize);
+				spriteList[screen][index].gfxMemorySize = 0;
 			}
 
 			/*
@@ -278,12 +334,64 @@ void loadData(int screen, int index, bool gfx, bool pal)
 							&oamMain,
 							(SpriteSize) SPRITE_PIXELS_SIZE(spriteList[screen][index].bRect.size.width, spriteList[screen][index].bRect.size.height),
 							SpriteColorFormat_256Color);
+
+			/*
+			 * Keeps track of how much sprite memory is being used.
+			 */
+			if(spriteList[screen][index].gfxMemory)
+			{
+				spriteList[screen][index].gfxMemorySize = spriteList[screen][index].bRect.size.width
+						* spriteList[screen][index].bRect.size.height;
+				trackSpriteVram(screen, spriteList[screen][index].gfxMemorySize);
+			}
 		}
 	}
 }
 
 /*
- * Creates a sprite on the chosen screen.
+ * Frees (or releases to the asset cache) a sprite's graphics data.
+ * @param screen The screen the sprite is on.
+ * @param index The index of the sprite.
+ */
+static void freeSpriteGfxData(int screen, int index)
+{
+	if(spriteList[screen][index].gfxData != NULL)
+	{
+		if(spriteList[screen][index].sharedData)
+		{
+			releaseCachedAsset(spriteList[screen][index].gfxData);
+		}
+		else
+		{
+			free(spriteList[screen][index].gfxData);
+		}
+		spriteList[screen][index].gfxData = NULL;
+	}
+}
+
+/*
+ * Frees (or releases to the asset cache) a sprite's palette data.
+ * @param screen The screen the sprite is on.
+ * @param index The index of the sprite.
+ */
+static void freeSpritePaletteData(int screen, int index)
+{
+	if(spriteList[screen][index].paletteData != NULL)
+	{
+		if(spriteList[screen][index].sharedData)
+		{
+			releaseCachedAsset(spriteList[screen][index].paletteData);
+		}
+		else
+		{
+			free(spriteList[screen][index].paletteData);
+		}
+		spriteList[screen][index].paletteData = NULL;
+	}
+}
+
+/*
+ * Sets up a sprite on the chosen screen.
  * @param screen The screen to create the sprite on.
  * @param index The index of the sprite.
  * @param palSlot The slot for the palette data.
@@ -292,9 +400,12 @@ void loadData(int screen, int index, bool gfx, bool pal)
  * @param palData The palette data.
  * @param width The width of the sprite.
  * @param height The height of the sprite.
+ * @param shared Whether to use the data as it is (it belongs to the asset
+ * cache) instead of copying it.
+ * @return Returns true if the sprite was created, false if it already exists.
  */
-void createSprite(int screen, int index, int palSlot, const unsigned int* gfxData, u32 gfxDataSize, const unsigned short* palData,
-		int width, int height)
+static bool initSprite(int screen, int index, int palSlot, const unsigned int* gfxData, u32 gfxDataSize, const unsigned short* palData,
+		int width, int height, bool shared)
 {
 	/*
 	 * Checks to see if the index is too small.
@@ -336,7 +447,7 @@ void createSprite(int screen, int index, int palSlot, const unsigned int* gfxDat
 
 	if(spriteList[screen][index].active)
 	{
-		return;
+		return false;
 	}
 
 	/*
@@ -401,26 +512,41 @@ void createSprite(int screen, int index, int palSlot, const unsigned int* gfxDat
 	spriteList[screen][index].cRect.size.height = height;
 
 	/*
-	 * Sets the sprite's graphics memory.
+	 * Gets rid of any data left over from the sprite's last use.  A copy's
+	 * data belongs to the sprite it copied, so it is left alone.
 	 */
-	if(spriteList[screen][index].gfxData != NULL)
+	if(spriteList[screen][index].isCopy)
 	{
-		free(spriteList[screen][index].gfxData);
 		spriteList[screen][index].gfxData = NULL;
+		spriteList[screen][index].paletteData = NULL;
 	}
-	spriteList[screen][index].gfxData = (u16*)calloc(gfxDataSize, sizeof(u16));
-	memcpy(spriteList[screen][index].gfxData, gfxData, gfxDataSize);
+	freeSpriteGfxData(screen, index);
+	freeSpritePaletteData(screen, index);
+	spriteList[screen][index].sharedData = shared;
 
-	/*
-	 * Sets the sprite's palette memory.
-	 */
-	if(spriteList[screen][index].paletteData != NULL)
+	if(shared)
 	{
-		free(spriteList[screen][index].paletteData);
-		spriteList[screen][index].paletteData = NULL;
+		/*
+		 * Shared data is used as it is, since the asset cache
+		 * keeps it until the sprite releases it.
+		 */
+		spriteList[screen][index].gfxData = (u16*)gfxData;
+		spriteList[screen][index].paletteData = (u16*)palData;
+	}
+	else
+	{
+		/*
+		 * Sets the sprite's graphics memory.
+		 */
+		spriteList[screen][index].gfxData = (u16*)calloc(gfxDataSize, sizeof(u16));
+		memcpy(spriteList[screen][index].gfxData, gfxData, gfxDataSize);
+
+		/*
+		 * Sets the sprite's palette memory.
+		 */
+		spriteList[screen][index].paletteData = (u16*)calloc(512, sizeof(u16));
+		memcpy(spriteList[screen][index].paletteData, palData, 512);
 	}
-	spriteList[screen][index].paletteData = (u16*)calloc(512, sizeof(u16));
-	memcpy(spriteList[screen][index].paletteData, palData, 512);
 
 	/*
 	 * Sets the sprite to active.
@@ -441,6 +567,45 @@ void createSprite(int screen, int index, int palSlot, const unsigned int* gfxDat
 	 * Load the grayscale usage info.
 	 */
 	setSpriteUseGrayscale(screen, index, spriteList[screen][index].useGrayscale);
+
+	return true;
+}
+
+/*
+ * Creates a sprite on the chosen screen.
+ * @param screen The screen to create the sprite on.
+ * @param index The index of the sprite.
+ * @param palSlot The slot for the palette data.
+ * @param gfxData The graphical data.
+ * @param gfxDataSize The size of the graphical data.
+ * @param palData The palette data.
+ * @param width The width of the sprite.
+ * @param height The height of the sprite.
+ */
+void createSprite(int screen, int index, int palSlot, const unsigned int* gfxData, u32 gfxDataSize, const unsigned short* palData,
+		int width, int height)
+{
+	initSprite(screen, index, palSlot, gfxData, gfxDataSize, palData, width, height, false);
+}
+
+/*
+ * Creates a sprite that uses data from the asset cache instead of its own
+ * copy.  The sprite releases the data back to the cache when it is deleted.
+ * @param screen The screen to create the sprite on.
+ * @param index The index of the sprite.
+ * @param palSlot The slot for the palette data.
+ * @param gfxData The graphical data, from acquireCachedAsset.
+ * @param gfxDataSize The size of the graphical data.
+ * @param palData The palette data (256 colors), from acquireCachedAsset.
+ * @param width The width of the sprite.
+ * @param height The height of the sprite.
+ * @return Returns true if the sprite was created and now owns the data,
+ * false if the sprite already exists.
+ */
+bool createSharedSprite(int screen, int index, int palSlot, const unsigned int* gfxData, u32 gfxDataSize, const unsigned short* palData,
+		int width, int height)
+{
+	return initSprite(screen, index, palSlot, gfxData, gfxDataSize, palData, width, height, true);
 }
 
 /*
@@ -636,11 +801,7 @@ void deleteSpritePalette(int screen, int index)
 		/*
 		 * Otherwise, frees the sprite's palette data.
 		 */
-		if(spriteList[screen][index].paletteData)
-		{
-			free(spriteList[screen][index].paletteData);
-			spriteList[screen][index].paletteData = NULL;
-		}
+		freeSpritePaletteData(screen, index);
 	}
 }
 
@@ -704,6 +865,15 @@ void deleteSprite(int screen, int index)
 	 */
 	oamClearSprite((screen == 0) ? &oamSub : &oamMain, index);
 
+	/*
+	 * Frees the sprite's current frame data.
+	 */
+	if(spriteList[screen][index].frameData != NULL)
+	{
+		free(spriteList[screen][index].frameData);
+		spriteList[screen][index].frameData = NULL;
+	}
+
 	/*
 	 * Check if the sprite is a copy of another sprite.
 	 */
@@ -720,11 +890,7 @@ void deleteSprite(int screen, int index)
 		/*
 		 * Otherwise, frees the sprite's graphical data.
 		 */
-		if(spriteList[screen][index].gfxData)
-		{
-			free(spriteList[screen][index].gfxData);
-			spriteList[screen][index].gfxData = NULL;
-		}
+		freeSpriteGfxData(screen, index);
 
 		/*
 		 * Also frees the sprite's graphical data in the memory.
@@ -733,6 +899,8 @@ void deleteSprite(int screen, int index)
 		{
 			oamFreeGfx((screen <= 0) ? &oamSub : &oamMain, spriteList[screen][index].gfxMemory);
 			spriteList[screen][index].gfxMemory = NULL;
+			trackSpriteVram(screen, -(s32)spriteList[screen][index].gfxMemorySize);
+			spriteList[screen][index].gfxMemorySize = 0;
 		}
 	}
 }
@@ -1648,6 +1816,17 @@ void setSpriteUseGrayscale(int screen, int index, bool use)
 		free(spriteList[screen][index].grayscalePaletteData);
 		spriteList[screen][index].grayscalePaletteData = NULL;
 	}
+
+	/*
+	 * The grayscale palette is only made when it is used, so that
+	 * creating a sprite doesn't need to allocate it.
+	 */
+	if(!use)
+	{
+		spriteList[screen][index].useGrayscale = false;
+		loadData(screen, index, false, true);
+		return;
+	}
 	spriteList[screen][index].grayscalePaletteData = calloc(512, sizeof(unsigned short));
 
 	uint32_t i = 0;
@@ -1900,26 +2079,34 @@ void drawSprite(int screen, int index)
 	if (spriteList[screen][index].active)
 	{
 		/*
-		 * Sets the sprite's frame data.
+		 * The frame's graphics are only copied when the frame
+		 * has changed since they were last copied.
 		 */
-		if(spriteList[screen][index].frameData != NULL)
+		if (spriteList[screen][index].currentFrame != spriteList[screen][index].uploadedFrame
+				&& spriteList[screen][index].gfxMemory != NULL)
 		{
-			free(spriteList[screen][index].frameData);
-			spriteList[screen][index].frameData = NULL;
-		}
-		spriteList[screen][index].frameData = (u16*)calloc(spriteList[screen][index].bRect.size.width * spriteList[screen][index].bRect.size.height, sizeof(u16));
+			/*
+			 * Sets the sprite's frame data.
+			 */
+			if(spriteList[screen][index].frameData == NULL)
+			{
+				spriteList[screen][index].frameData = (u16*)calloc(spriteList[screen][index].bRect.size.width * spriteList[screen][index].bRect.size.height, sizeof(u16));
+			}
 
-		memcpy(spriteList[screen][index].frameData,
-			spriteList[screen][index].gfxData + (spriteList[screen][index].currentFrame *
-			(spriteList[screen][index].sRect.size.width * spriteList[screen][index].sRect.size.height / 2)),
-			spriteList[screen][index].sRect.size.width * spriteList[screen][index].sRect.size.height);
+			memcpy(spriteList[screen][index].frameData,
+				spriteList[screen][index].gfxData + (spriteList[screen][index].currentFrame *
+				(spriteList[screen][index].sRect.size.width * spriteList[screen][index].sRect.size.height / 2)),
+				spriteList[screen][index].sRect.size.width * spriteList[screen][index].sRect.size.height);
 
-		/*
-		 * Copies the sprite's frame graphics to the
-		 * graphical memory.
-		 */
-		memcpy(spriteList[screen][index].gfxMemory, spriteList[screen][index].frameData, 
-			spriteList[screen][index].bRect.size.width * spriteList[screen][index].bRect.size.height);
+			/*
+			 * Queues the sprite's frame graphics to be copied to the
+			 * graphical memory when the frame is committed.
+			 */
+			queueVramUpload(spriteList[screen][index].gfxMemory, spriteList[screen][index].frameData,
+				spriteList[screen][index].bRect.size.width * spriteList[screen][index].bRect.size.height);
+
+			spriteList[screen][index].uploadedFrame = spriteList[screen][index].currentFrame;
+		}
 
 		/*
 		 * Checks if the rotation is not -1.
@@ -5,6 +5,7 @@
  */
 #include "textFunctions.h"
 #include "generic.h"
+#include "vramPlanner.h"
 
 /*
  * The print console for the top screen.
@@ -28,23 +29,36 @@ int bottomId = 0;
  * top screen. (Use -1 to not load the top screen's text system)
  * @param bottomScreenLayer The background layer to display the text on on the
  * bottom screen. (Use -1 to not load the bottom screen's text system)
+ * @return Returns true if every console that was asked for was set up,
+ * false if there was not enough VRAM for one of them.
  */
-void initTextSystem(bool loadDefaultFonts, int topScreenLayer,
+bool initTextSystem(bool loadDefaultFonts, int topScreenLayer,
 		int bottomScreenLayer)
 {
+	bool ready = true;
+
 	/*
 	 * Checks to make sure the top screen layer is > -1 and is < 4.
 	 */
 	if (topScreenLayer > -1 && topScreenLayer < 4)
 	{
+		int mapBase = 0;
+		int tileBase = 0;
+
 		/*
-		 * If it does meet the requirements above, then its console
-		 * is initialized.
+		 * If it does meet the requirements above, then room is made for
+		 * it in VRAM, and its console is initialized.
 		 */
-		PrintConsole* c = consoleInit(&topScreen, topScreenLayer, BgType_ExRotation,
-				BgSize_ER_256x256, topScreenLayer * 4, (topScreenLayer < 3) ? topScreenLayer * 2 + 2 : topScreenLayer * 2 + 1, true,
-				loadDefaultFonts);
-		topId = c->bgId;
+		if(allocBgVram(1, TEXT_MAP_VRAM_SIZE, TEXT_TILE_VRAM_SIZE, &mapBase, &tileBase))
+		{
+			PrintConsole* c = consoleInit(&topScreen, topScreenLayer, BgType_ExRotation,
+					BgSize_ER_256x256, mapBase, tileBase, true, loadDefaultFonts);
+			topId = c->bgId;
+		}
+		else
+		{
+			ready = false;
+		}
 	}
 
 	/*
@@ -52,15 +66,26 @@ void initTextSystem(bool loadDefaultFonts, int topScreenLayer,
 	 */
 	if (bottomScreenLayer > -1 && bottomScreenLayer < 4)
 	{
+		int mapBase = 0;
+		int tileBase = 0;
+
 		/*
-		 * If it does meet the requirements above, then its console
-		 * is initialized.
+		 * If it does meet the requirements above, then room is made for
+		 * it in VRAM, and its console is initialized.
 		 */
-		PrintConsole* c = consoleInit(&bottomScreen, bottomScreenLayer, BgType_ExRotation,
-				BgSize_ER_256x256, bottomScreenLayer * 4, (bottomScreenLayer < 3) ? bottomScreenLayer * 2 + 2 : bottomScreenLayer * 2 + 1,
-				false, loadDefaultFonts);
-		bottomId = c->bgId;
+		if(allocBgVram(0, TEXT_MAP_VRAM_SIZE, TEXT_TILE_VRAM_SIZE, &mapBase, &tileBase))
+		{
+			PrintConsole* c = consoleInit(&bottomScreen, bottomScreenLayer, BgType_ExRotation,
+					BgSize_ER_256x256, mapBase, tileBase, false, loadDefaultFonts);
+			bottomId = c->bgId;
+		}
+		else
+		{
+			ready = false;
+		}
 	}
+
+	return ready;
 }
 
 /*
@@ -338,3 +363,236 @@ void drawText(int screen, int x, int y, const char* text, ...)
 	va_end(variableList);
 }
 
+
+/*
+ * Gets the console of the desired screen.
+ * @param screen The screen to get the console of.
+ * @return Returns the console, or NULL if it hasn't been initialized.
+ */
+static PrintConsole* getTextConsole(int screen)
+{
+	PrintConsole* console = (screen <= 0) ? &bottomScreen : &topScreen;
+
+	return (console->consoleInitialised && console->fontBgMap != NULL) ? console : NULL;
+}
+
+/*
+ * Writes a single character straight into a console's map.
+ * @param console The console to write to.
+ * @param x The x position of the character (in tiles).
+ * @param y The y position of the character (in tiles).
+ * @param c The character to write.
+ */
+static inline void putTextChar(PrintConsole* console, int x, int y, char c)
+{
+	/*
+	 * Anything outside of the console's window is left out.
+	 */
+	if(x < 0 || y < 0 || x >= console->windowWidth || y >= console->windowHeight)
+	{
+		return;
+	}
+
+	console->fontBgMap[(x + console->windowX) + (y + console->windowY) * console->consoleWidth] =
+			console->fontCurPal | (u16)(c + console->fontCharOffset - console->font.asciiOffset);
+}
+
+/*
+ * Draws a single character on the screen by writing it straight into the
+ * console's map.
+ * @param screen The screen to draw the character on.
+ * @param x The x position to put the character at.
+ * @param y The y position to put the character at.
+ * @param c The character to draw.
+ */
+void drawTextChar(int screen, int x, int y, char c)
+{
+	PrintConsole* console = getTextConsole(screen);
+
+	if(console != NULL)
+	{
+		putTextChar(console, x, y, c);
+	}
+}
+
+/*
+ * Gets the tab size of the desired screen's console.
+ * @param screen The screen to get the tab size of.
+ * @return Returns the amount of characters between tab stops.
+ */
+int getTextTabSize(int screen)
+{
+	PrintConsole* console = getTextConsole(screen);
+
+	return (console != NULL && console->tabSize > 0) ? console->tabSize : 1;
+}
+
+/*
+ * Draws a string on the screen by writing its characters straight into the
+ * console's map.  No formatting is done, so each character costs the same.
+ * @param screen The screen to draw the text on.
+ * @param x The x position to put the text at.
+ * @param y The y position to put the text at.
+ * @param text The text to draw.  Supports new lines and tabs.
+ * @return Returns the x position after the last character drawn.
+ */
+int drawString(int screen, int x, int y, const char* text)
+{
+	PrintConsole* console = getTextConsole(screen);
+	int startX = x;
+	int i = 0;
+
+	if(console == NULL)
+	{
+		return x;
+	}
+
+	for(i = 0;text[i];i += 1)
+	{
+		switch(text[i])
+		{
+			case '\n':
+				/*
+				 * New lines go back to the starting x position.
+				 */
+				x = startX;
+				y += 1;
+				break;
+			case '\t':
+				/*
+				 * Tabs move to the next tab stop, like the console does.
+				 */
+				do
+				{
+					putTextChar(console, x, y, ' ');
+					x += 1;
+				} while(x % console->tabSize);
+				break;
+			default:
+				putTextChar(console, x, y, text[i]);
+				x += 1;
+				break;
+		}
+	}
+
+	return x;
+}
+
+/*
+ * Draws an integer on the screen without going through printf.
+ * @param screen The screen to draw the number on.
+ * @param x The x position to put the number at.
+ * @param y The y position to put the number at.
+ * @param value The number to draw.
+ * @return Returns the x position after the last digit drawn.
+ */
+int drawInt(int screen, int x, int y, int value)
+{
+	PrintConsole* console = getTextConsole(screen);
+	char digits[11];
+	int count = 0;
+	/*
+	 * The number is made positive as an unsigned value, so that
+	 * the smallest int doesn't overflow.
+	 */
+	u32 number = (value < 0) ? -(u32)value : (u32)value;
+
+	if(console == NULL)
+	{
+		return x;
+	}
+
+	/*
+	 * Gets the digits from the lowest to the highest.
+	 */
+	do
+	{
+		digits[count] = '0' + (number % 10);
+		number /= 10;
+		count += 1;
+	} while(number > 0);
+
+	if(value < 0)
+	{
+		putTextChar(console, x, y, '-');
+		x += 1;
+	}
+
+	/*
+	 * Then draws them from the highest to the lowest.
+	 */
+	while(count > 0)
+	{
+		count -= 1;
+		putTextChar(console, x, y, digits[count]);
+		x += 1;
+	}
+
+	return x;
+}
+
+/*
+ * Draws a number in hexadecimal on the screen without going through printf.
+ * @param screen The screen to draw the number on.
+ * @param x The x position to put the number at.
+ * @param y The y position to put the number at.
+ * @param value The number to draw.
+ * @param digits The amount of digits to draw (1-8), padded with zeros.
+ * @return Returns the x position after the last digit drawn.
+ */
+int drawHex(int screen, int x, int y, u32 value, int digits)
+{
+	PrintConsole* console = getTextConsole(screen);
+	static const char hexDigits[] = "0123456789ABCDEF";
+
+	if(console == NULL)
+	{
+		return x;
+	}
+
+	if(digits < 1)
+	{
+		digits = 1;
+	}
+	else if(digits > 8)
+	{
+		digits = 8;
+	}
+
+	while(digits > 0)
+	{
+		digits -= 1;
+		putTextChar(console, x, y, hexDigits[(value >> (digits * 4)) & 0xF]);
+		x += 1;
+	}
+
+	return x;
+}
+
+/*
+ * Clears an area of text on the screen.
+ * @param screen The screen to clear the text on.
+ * @param x The x position of the area.
+ * @param y The y position of the area.
+ * @param width The width of the area (in characters).
+ * @param height The height of the area (in characters).
+ */
+void clearTextArea(int screen, int x, int y, int width, int height)
+{
+	PrintConsole* console = getTextConsole(screen);
+	int i = 0;
+	int j = 0;
+
+	if(console == NULL)
+	{
+		return;
+	}
+
+	for(j = y;j < y + height;j += 1)
+	{
+		for(i = x;i < x + width;i += 1)
+		{
+			putTextChar(console, i, j, ' ');
+		}
+	}
+}
@@ -0,0 +1,392 @@
+/*
+ * Contains retained text widgets.  A widget is a label with an optional
+ * integer bound to it, and it remembers what it last put on the screen.  When
+ * the label or the integer changes, only the characters that are different
+ * are written to the console's map, and only during the vertical blank.
+ */
+#include "textWidgets.h"
+#include "textFunctions.h"
+#include "generic.h"
+
+/*
+ * The max amount of characters that can be waiting to be written
+ * on each screen.
+ */
+#define MAX_TEXT_CELL_CHANGES (MAX_TEXT_WIDGETS * TEXT_WIDGET_LENGTH)
+
+/*
+ * A structure for a text widget.
+ * active - Whether the widget is being used.
+ * visible - Whether the widget is shown.
+ * dirty - Whether the widget needs to be drawn again.
+ * position - The position of the widget (in characters).
+ * label - The widget's label.
+ * value - The integer bound to the widget, or NULL.
+ * lastValue - The value of the integer when the widget was last drawn.
+ * cells - The characters the widget has put on the screen.
+ * cellCount - The amount of characters the widget has put on the screen.
+ */
+typedef struct textWidget_t
+{
+	bool active;
+	bool visible;
+	bool dirty;
+	coordinates_t position;
+	char label[TEXT_WIDGET_LENGTH + 1];
+	const int* value;
+	int lastValue;
+	char cells[TEXT_WIDGET_LENGTH];
+	int cellCount;
+} textWidget_t;
+
+/*
+ * A structure for a character waiting to be written to the screen.
+ * x - The x position of the character.
+ * y - The y position of the character.
+ * c - The character.
+ */
+typedef struct textCellChange_t
+{
+	u8 x;
+	u8 y;
+	char c;
+} textCellChange_t;
+
+/*
+ * The widgets on each screen.
+ */
+textWidget_t textWidgets[2][MAX_TEXT_WIDGETS];
+
+/*
+ * The characters waiting to be written on each screen.
+ */
+textCellChange_t textCellChanges[2][MAX_TEXT_CELL_CHANGES];
+
+/*
+ * The amount of characters waiting to be written on each screen.
+ */
+int textCellChangeCounts[2];
+
+/*
+ * Queues a character to be written to the screen.
+ * @param screen The screen to write the character on (0 or 1).
+ * @param x The x position of the character.
+ * @param y The y position of the character.
+ * @param c The character.
+ */
+static void queueTextCell(int screen, int x, int y, char c)
+{
+	/*
+	 * If the queue is somehow full, the character is written right away
+	 * rather than being lost.
+	 */
+	if(textCellChangeCounts[screen] >= MAX_TEXT_CELL_CHANGES)
+	{
+		drawTextChar(screen, x, y, c);
+		return;
+	}
+
+	textCellChange_t* change = &textCellChanges[screen][textCellChangeCounts[screen]];
+	change->x = x;
+	change->y = y;
+	change->c = c;
+	textCellChangeCounts[screen] += 1;
+}
+
+/*
+ * Renders a widget's text into a buffer.
+ * @param screen The screen the widget is on.
+ * @param widget The widget to render.
+ * @param text The buffer to render into (TEXT_WIDGET_LENGTH characters).
+ * @return Returns the amount of characters rendered.
+ */
+static int renderTextWidget(int screen, textWidget_t* widget, char* text)
+{
+	int tabSize = getTextTabSize(screen);
+	int count = 0;
+	int i = 0;
+
+	if(!widget->visible)
+	{
+		return 0;
+	}
+
+	/*
+	 * Copies the label over, turning tabs into spaces like the console would.
+	 */
+	for(i = 0;widget->label[i] && count < TEXT_WIDGET_LENGTH;i += 1)
+	{
+		if(widget->label[i] == '\t')
+		{
+			do
+			{
+				text[count] = ' ';
+				count += 1;
+			} while(count < TEXT_WIDGET_LENGTH && (widget->position.x + count) % tabSize);
+		}
+		else
+		{
+			text[count] = widget->label[i];
+			count += 1;
+		}
+	}
+
+	/*
+	 * Then adds the value, if there is one.
+	 */
+	if(widget->value != NULL)
+	{
+		char digits[11];
+		int digitCount = 0;
+		int value = widget->lastValue;
+		u32 number = (value < 0) ? -(u32)value : (u32)value;
+
+		do
+		{
+			digits[digitCount] = '0' + (number % 10);
+			number /= 10;
+			digitCount += 1;
+		} while(number > 0);
+
+		if(value < 0 && count < TEXT_WIDGET_LENGTH)
+		{
+			text[count] = '-';
+			count += 1;
+		}
+		while(digitCount > 0 && count < TEXT_WIDGET_LENGTH)
+		{
+			digitCount -= 1;
+			text[count] = digits[digitCount];
+			count += 1;
+		}
+	}
+
+	return count;
+}
+
+/*
+ * Creates a text widget on the chosen screen.
+ * @param screen The screen to create the widget on.
+ * @param index The index of the widget.
+ * @param x The x position of the widget (in characters).
+ * @param y The y position of the widget (in characters).
+ * @param label The label of the widget.  Supports tabs.
+ * @param value An integer to show after the label, or NULL for just the label.
+ * The integer must stay around for as long as the widget does.
+ */
+void createTextWidget(int screen, int index, int x, int y, const char* label,
+		const int* value)
+{
+	if(index < 0 || index >= MAX_TEXT_WIDGETS)
+	{
+		return;
+	}
+
+	screen = (screen <= 0) ? 0 : 1;
+
+	/*
+	 * Makes sure an old widget at the same index is cleared off first.
+	 */
+	deleteTextWidget(screen, index);
+
+	textWidget_t* widget = &textWidgets[screen][index];
+	widget->active = true;
+	widget->visible = true;
+	widget->dirty = true;
+	widget->position.x = x;
+	widget->position.y = y;
+	widget->value = value;
+	widget->lastValue = (value != NULL) ? *value : 0;
+	widget->cellCount = 0;
+	strncpy(widget->label, label, TEXT_WIDGET_LENGTH);
+	widget->label[TEXT_WIDGET_LENGTH] = '\0';
+}
+
+/*
+ * Deletes the desired text widget, clearing it off of the screen.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ */
+void deleteTextWidget(int screen, int index)
+{
+	int i = 0;
+
+	if(index < 0 || index >= MAX_TEXT_WIDGETS)
+	{
+		return;
+	}
+
+	screen = (screen <= 0) ? 0 : 1;
+	textWidget_t* widget = &textWidgets[screen][index];
+
+	if(!widget->active)
+	{
+		return;
+	}
+
+	/*
+	 * Clears what the widget had put on the screen.
+	 */
+	for(i = 0;i < widget->cellCount;i += 1)
+	{
+		if(widget->cells[i] != ' ')
+		{
+			queueTextCell(screen, widget->position.x + i, widget->position.y, ' ');
+		}
+	}
+
+	widget->active = false;
+	widget->cellCount = 0;
+}
+
+/*
+ * Deletes all of the text widgets on a screen.
+ * @param screen The screen to delete the widgets on.
+ */
+void deleteTextWidgets(int screen)
+{
+	int i = 0;
+
+	for(i = 0;i < MAX_TEXT_WIDGETS;i += 1)
+	{
+		deleteTextWidget(screen, i);
+	}
+}
+
+/*
+ * Sets the label of the desired text widget.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ * @param label The new label.
+ */
+void setTextWidgetLabel(int screen, int index, const char* label)
+{
+	if(index < 0 || index >= MAX_TEXT_WIDGETS)
+	{
+		return;
+	}
+
+	textWidget_t* widget = &textWidgets[(screen <= 0) ? 0 : 1][index];
+
+	if(strncmp(widget->label, label, TEXT_WIDGET_LENGTH) != 0)
+	{
+		strncpy(widget->label, label, TEXT_WIDGET_LENGTH);
+		widget->label[TEXT_WIDGET_LENGTH] = '\0';
+		widget->dirty = true;
+	}
+}
+
+/*
+ * Shows or hides the desired text widget.
+ * @param screen The screen the widget is on.
+ * @param index The index of the widget.
+ * @param visible Whether the widget should be shown.
+ */
+void setTextWidgetVisible(int screen, int index, bool visible)
+{
+	if(index < 0 || index >= MAX_TEXT_WIDGETS)
+	{
+		return;
+	}
+
+	textWidget_t* widget = &textWidgets[(screen <= 0) ? 0 : 1][index];
+
+	if(widget->visible != visible)
+	{
+		widget->visible = visible;
+		widget->dirty = true;
+	}
+}
+
+/*
+ * Shows or hides all of the text widgets on a screen.
+ * @param screen The screen the widgets are on.
+ * @param visible Whether the widgets should be shown.
+ */
+void setTextWidgetsVisible(int screen, bool visible)
+{
+	int i = 0;
+
+	for(i = 0;i < MAX_TEXT_WIDGETS;i += 1)
+	{
+		setTextWidgetVisible(screen, i, visible);
+	}
+}
+
+/*
+ * Works out which characters of the widgets changed since they were last
+ * drawn.  Called by updateAll before the vertical blank.
+ */
+void updateTextWidgets()
+{
+	char text[TEXT_WIDGET_LENGTH];
+	int s = 0;
+	int i = 0;
+	int c = 0;
+
+	for(s = 0;s < 2;s += 1)
+	{
+		for(i = 0;i < MAX_TEXT_WIDGETS;i += 1)
+		{
+			textWidget_t* widget = &textWidgets[s][i];
+
+			if(!widget->active)
+			{
+				continue;
+			}
+
+			/*
+			 * Widgets are only drawn again when something about them changed.
+			 */
+			if(widget->value != NULL && *widget->value != widget->lastValue)
+			{
+				widget->lastValue = *widget->value;
+				widget->dirty = true;
+			}
+			if(!widget->dirty)
+			{
+				continue;
+			}
+			widget->dirty = false;
+
+			int count = renderTextWidget(s, widget, text);
+
+			/*
+			 * Queues the characters that are different from what is on
+			 * the screen, and clears the ones the text no longer covers.
+			 */
+			for(c = 0;c < count || c < widget->cellCount;c += 1)
+			{
+				char old = (c < widget->cellCount) ? widget->cells[c] : ' ';
+				char next = (c < count) ? text[c] : ' ';
+
+				if(old != next)
+				{
+					queueTextCell(s, widget->position.x + c, widget->position.y, next);
+				}
+			}
+
+			memcpy(widget->cells, text, count);
+			widget->cellCount = count;
+		}
+	}
+}
+
+/*
+ * Writes the characters that changed to the screens.  Called by the frame
+ * pipeline during the vertical blank.
+ */
+void commitTextWidgets()
+{
+	int s = 0;
+	int i = 0;
+
+	for(s = 0;s < 2;s += 1)
+	{
+		for(i = 0;i < textCellChangeCounts[s];i += 1)
+		{
+			drawTextChar(s, textCellChanges[s][i].x, textCellChanges[s][i].y, textCellChanges[s][i].c);
+		}
+		textCellChangeCounts[s] = 0;
+	}
+}
@@ -0,0 +1,693 @@
+/*
+ * Contains a variable width font renderer.  Fonts are packed into a one bit
+ * per pixel glyph atlas with the width of each glyph when they are loaded,
+ * and strings are drawn into a text area: a background layer whose tiles are
+ * used as a small canvas.  Rendered strings are cached by hash, so drawing
+ * the same label again only costs one lookup and a copy.
+ */
+#include "variableFont.h"
+#include "vramPlanner.h"
+
+/*
+ * The amount of bytes in each row of a rendered string.
+ */
+#define FONT_ROW_BYTES (FONT_MAX_STRING_WIDTH / 8)
+
+/*
+ * The value written to the tiles for the text's pixels (color 1 of
+ * the palette bank, repeated for all 8 pixels of a row).
+ */
+#define FONT_TEXT_PIXELS 0x11111111
+
+/*
+ * A structure for a text area.
+ * active - Whether the area has been created.
+ * id - The background ID of the area's layer.
+ * x - The x position of the area (in tiles).
+ * y - The y position of the area (in tiles).
+ * width - The width of the area (in tiles).
+ * height - The height of the area (in tiles).
+ * mapBase - The map base handed out for the layer.
+ * tileBase - The tile base handed out for the layer.
+ * tileSize - The size of the area's tiles in bytes.
+ * tiles - The area's tiles.  Tile 0 is blank, and the rest are the area's
+ * cells from left to right, top to bottom.
+ */
+typedef struct fontArea_t
+{
+	bool active;
+	int id;
+	int x;
+	int y;
+	int width;
+	int height;
+	int mapBase;
+	int tileBase;
+	u32 tileSize;
+	u32* tiles;
+} fontArea_t;
+
+/*
+ * A structure for a cached rendered string.
+ * used - Whether the entry holds a string.
+ * hash - The hash of the string and font.
+ * fontId - The ID of the font the string was rendered with.
+ * text - The string.
+ * width - The width of the string in pixels.
+ * rows - The rendered string, one bit per pixel.
+ */
+typedef struct fontCacheEntry_t
+{
+	bool used;
+	u32 hash;
+	u32 fontId;
+	char text[FONT_CACHE_TEXT_LENGTH];
+	int width;
+	u8 rows[FONT_GLYPH_HEIGHT][FONT_ROW_BYTES];
+} fontCacheEntry_t;
+
+/*
+ * The text area on each screen.
+ */
+fontArea_t fontAreas[2];
+
+/*
+ * The cache of rendered strings.
+ */
+fontCacheEntry_t fontCache[FONT_CACHE_SIZE];
+
+/*
+ * Where strings too long to be cached are rendered.
+ */
+fontCacheEntry_t fontScratch;
+
+/*
+ * The ID given to the next font that is loaded.
+ */
+u32 fontNextId = 1;
+
+/*
+ * Turns 8 one bit pixels into a mask of 8 four bit pixels.
+ */
+u32 fontPixelMasks[256];
+
+/*
+ * Whether fontPixelMasks has been filled in.
+ */
+bool fontPixelMasksReady = false;
+
+/*
+ * Fills in the pixel mask table.
+ */
+static void initFontPixelMasks()
+{
+	int i = 0;
+	int p = 0;
+
+	if(fontPixelMasksReady)
+	{
+		return;
+	}
+
+	for(i = 0;i < 256;i += 1)
+	{
+		fontPixelMasks[i] = 0;
+		for(p = 0;p < 8;p += 1)
+		{
+			if(i & BIT(p))
+			{
+				fontPixelMasks[i] |= 0xF << (p * 4);
+			}
+		}
+	}
+	fontPixelMasksReady = true;
+}
+
+/*
+ * Hashes a string and the font it is drawn with (FNV-1a).
+ * @param font The font.
+ * @param text The string.
+ * @return Returns the hash.
+ */
+static u32 hashFontString(const font_t* font, const char* text)
+{
+	u32 hash = 2166136261u ^ font->id;
+
+	while(*text)
+	{
+		hash ^= (u8)*text;
+		hash *= 16777619u;
+		text += 1;
+	}
+	return hash;
+}
+
+/*
+ * Gets the glyph of a character.
+ * @param font The font to check.
+ * @param c The character.
+ * @return Returns the glyph, or -1 if the font doesn't have it.
+ */
+static inline int getFontGlyph(const font_t* font, char c)
+{
+	int glyph = (int)(u8)c - font->firstChar;
+
+	return (glyph >= 0 && glyph < font->glyphCount) ? glyph : -1;
+}
+
+/*
+ * Writes part of a row of pixels into a text area's tile.
+ * @param area The text area.
+ * @param tx The x position of the tile in the area.
+ * @param ty The y position of the tile in the area.
+ * @param row The row in the tile.
+ * @param mask The pixels to write.
+ * @param value The value of the pixels.
+ */
+static inline void writeFontTileRow(fontArea_t* area, int tx, int ty, int row, u32 mask, u32 value)
+{
+	if(tx < 0 || tx >= area->width || mask == 0)
+	{
+		return;
+	}
+
+	u32* tileRow = &area->tiles[(1 + ty * area->width + tx) * 8 + row];
+	*tileRow = (*tileRow & ~mask) | (value & mask);
+}
+
+/*
+ * Writes a row of one bit pixels into a text area.
+ * @param area The text area.
+ * @param x The x position of the row (in pixels).
+ * @param y The y position of the row (in pixels).
+ * @param bits The pixels, with the leftmost pixel in the lowest bit.
+ * @param byteCount The amount of bytes of pixels.
+ * @param value The value written for pixels that are set.
+ */
+static void blitFontRow(fontArea_t* area, int x, int y, const u8* bits, int byteCount, u32 value)
+{
+	int b = 0;
+
+	if(y < 0 || y >= area->height * 8)
+	{
+		return;
+	}
+
+	for(b = 0;b < byteCount;b += 1)
+	{
+		if(bits[b] == 0)
+		{
+			continue;
+		}
+
+		/*
+		 * Each byte covers 8 pixels, which can be split between two tiles.
+		 */
+		u32 mask = fontPixelMasks[bits[b]];
+		int px = x + b * 8;
+		int tx = px >> 3;
+		int shift = (px & 7) * 4;
+
+		writeFontTileRow(area, tx, y >> 3, y & 7, mask << shift, value);
+		if(shift != 0)
+		{
+			writeFontTileRow(area, tx + 1, y >> 3, y & 7, mask >> (32 - shift), value);
+		}
+	}
+}
+
+/*
+ * Renders a string into a cache entry.
+ * @param font The font to render with.
+ * @param text The string to render.
+ * @param entry The entry to render into.
+ */
+static void renderFontString(const font_t* font, const char* text, fontCacheEntry_t* entry)
+{
+	int pen = 0;
+	int i = 0;
+	int r = 0;
+
+	memset(entry->rows, 0, sizeof(entry->rows));
+
+	for(i = 0;text[i] && pen < FONT_MAX_STRING_WIDTH;i += 1)
+	{
+		int glyph = getFontGlyph(font, text[i]);
+
+		if(i > 0)
+		{
+			pen += getFontKerning(font, text[i - 1], text[i]);
+			if(pen < 0)
+			{
+				pen = 0;
+			}
+		}
+		if(glyph < 0)
+		{
+			continue;
+		}
+
+		/*
+		 * Glyphs are at most 8 pixels wide, so each row covers at most two bytes.
+		 */
+		int byte = pen >> 3;
+		for(r = 0;r < FONT_GLYPH_HEIGHT;r += 1)
+		{
+			u16 bits = font->glyphRows[glyph][r] << (pen & 7);
+			if(byte < FONT_ROW_BYTES)
+			{
+				entry->rows[r][byte] |= bits & 0xFF;
+			}
+			if(byte + 1 < FONT_ROW_BYTES)
+			{
+				entry->rows[r][byte + 1] |= bits >> 8;
+			}
+		}
+		pen += font->widths[glyph] + font->spacing;
+	}
+
+	entry->width = getFontStringWidth(font, text);
+	if(entry->width > FONT_MAX_STRING_WIDTH)
+	{
+		entry->width = FONT_MAX_STRING_WIDTH;
+	}
+}
+
+/*
+ * Gets a rendered string, from the cache if it is there.
+ * @param font The font to render with.
+ * @param text The string to render.
+ * @return Returns the rendered string.
+ */
+static fontCacheEntry_t* getRenderedString(const font_t* font, const char* text)
+{
+	/*
+	 * Strings too long to be cached are rendered every time.
+	 */
+	if(strlen(text) >= FONT_CACHE_TEXT_LENGTH)
+	{
+		renderFontString(font, text, &fontScratch);
+		return &fontScratch;
+	}
+
+	u32 hash = hashFontString(font, text);
+	fontCacheEntry_t* entry = &fontCache[hash % FONT_CACHE_SIZE];
+
+	if(entry->used && entry->hash == hash && entry->fontId == font->id && strcmp(entry->text, text) == 0)
+	{
+		return entry;
+	}
+
+	/*
+	 * Otherwise the string replaces whatever was in its slot.
+	 */
+	renderFontString(font, text, entry);
+	entry->used = true;
+	entry->hash = hash;
+	entry->fontId = font->id;
+	strcpy(entry->text, text);
+
+	return entry;
+}
+
+/*
+ * Loads a font from 8x8 4bpp tiles (the same format used by setFont).
+ * Each glyph is packed into the font's atlas and has its width measured.
+ * @param font The font to load into.
+ * @param tiles The tiles of the font.
+ * @param firstChar The character of the first tile.
+ * @param glyphCount The amount of tiles.
+ * @param spacing The amount of pixels between glyphs.
+ */
+void loadFont(font_t* font, const unsigned int* tiles, int firstChar, int glyphCount,
+		int spacing)
+{
+	int g = 0;
+	int r = 0;
+	int p = 0;
+
+	memset(font, 0, sizeof(font_t));
+	font->id = fontNextId;
+	fontNextId += 1;
+	font->firstChar = firstChar;
+	font->glyphCount = (glyphCount > MAX_FONT_GLYPHS) ? MAX_FONT_GLYPHS : glyphCount;
+	font->spacing = spacing;
+
+	for(g = 0;g < font->glyphCount;g += 1)
+	{
+		const unsigned int* tile = &tiles[g * 8];
+		u8 columns = 0;
+
+		/*
+		 * Packs each row of 4 bit pixels down to one bit per pixel.
+		 */
+		for(r = 0;r < FONT_GLYPH_HEIGHT;r += 1)
+		{
+			u8 bits = 0;
+			for(p = 0;p < 8;p += 1)
+			{
+				if((tile[r] >> (p * 4)) & 0xF)
+				{
+					bits |= BIT(p);
+				}
+			}
+			font->glyphRows[g][r] = bits;
+			columns |= bits;
+		}
+
+		/*
+		 * Glyphs with no pixels are given the width of a space.
+		 */
+		if(columns == 0)
+		{
+			font->widths[g] = FONT_SPACE_WIDTH;
+			continue;
+		}
+
+		/*
+		 * Otherwise the empty columns on the left are removed, and the
+		 * glyph is as wide as what is left.
+		 */
+		int left = 0;
+		int right = 7;
+		while(!(columns & BIT(left)))
+		{
+			left += 1;
+		}
+		while(!(columns & BIT(right)))
+		{
+			right -= 1;
+		}
+		for(r = 0;r < FONT_GLYPH_HEIGHT;r += 1)
+		{
+			font->glyphRows[g][r] >>= left;
+		}
+		font->widths[g] = right - left + 1;
+	}
+
+	clearFontCache();
+}
+
+/*
+ * Adds a kerning pair to a font.
+ * @param font The font to add the pair to.
+ * @param left The character on the left.
+ * @param right The character on the right.
+ * @param offset The amount of pixels to move the right character by.
+ * @return Returns true if the pair was added, false if there is no room left.
+ */
+bool addFontKerning(font_t* font, char left, char right, int offset)
+{
+	u16 pair = ((u8)left << 8) | (u8)right;
+	int i = font->kerningCount;
+
+	if(font->kerningCount >= MAX_FONT_KERNING_PAIRS)
+	{
+		return false;
+	}
+
+	/*
+	 * The pairs are kept sorted so that they can be binary searched.
+	 */
+	while(i > 0 && font->kerningPairs[i - 1] > pair)
+	{
+		font->kerningPairs[i] = font->kerningPairs[i - 1];
+		font->kerningOffsets[i] = font->kerningOffsets[i - 1];
+		i -= 1;
+	}
+	font->kerningPairs[i] = pair;
+	font->kerningOffsets[i] = offset;
+	font->kerningCount += 1;
+
+	clearFontCache();
+
+	return true;
+}
+
+/*
+ * Gets the kerning between two characters.
+ * @param font The font to check.
+ * @param left The character on the left.
+ * @param right The character on the right.
+ * @return Returns the amount of pixels to move the right character by.
+ */
+int getFontKerning(const font_t* font, char left, char right)
+{
+	u16 pair = ((u8)left << 8) | (u8)right;
+	int low = 0;
+	int high = font->kerningCount - 1;
+
+	while(low <= high)
+	{
+		int middle = (low + high) / 2;
+		if(font->kerningPairs[middle] == pair)
+		{
+			return font->kerningOffsets[middle];
+		}
+		else if(font->kerningPairs[middle] < pair)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Gets the width of a string in pixels.
+ * @param font The font to measure with.
+ * @param text The string to measure.
+ * @return Returns the width of the string.
+ */
+int getFontStringWidth(const font_t* font, const char* text)
+{
+	int pen = 0;
+	int width = 0;
+	int i = 0;
+
+	for(i = 0;text[i];i += 1)
+	{
+		int glyph = getFontGlyph(font, text[i]);
+
+		if(i > 0)
+		{
+			pen += getFontKerning(font, text[i - 1], text[i]);
+			if(pen < 0)
+			{
+				pen = 0;
+			}
+		}
+		if(glyph < 0)
+		{
+			continue;
+		}
+		width = pen + font->widths[glyph];
+		pen = width + font->spacing;
+	}
+	return width;
+}
+
+/*
+ * Creates a text area on the chosen screen.  The area takes up a whole
+ * background layer, and gets its own tiles so that it can be drawn to
+ * pixel by pixel.
+ * @param screen The screen to create the area on.
+ * @param layer The background layer to use.
+ * @param x The x position of the area (in tiles).
+ * @param y The y position of the area (in tiles).
+ * @param width The width of the area (in tiles).
+ * @param height The height of the area (in tiles).
+ * @return Returns true if the area was created, false if there was no room.
+ */
+bool createFontArea(int screen, int layer, int x, int y, int width, int height)
+{
+	int mapBase = 0;
+	int tileBase = 0;
+	int i = 0;
+	int j = 0;
+
+	screen = (screen <= 0) ? 0 : 1;
+
+	if(width <= 0 || height <= 0 || x < 0 || y < 0 || x + width > 32 || y + height > 32)
+	{
+		return false;
+	}
+
+	deleteFontArea(screen);
+	initFontPixelMasks();
+
+	/*
+	 * Every cell of the area gets its own tile, plus one blank tile
+	 * for the rest of the layer.
+	 */
+	u32 tileSize = (width * height + 1) * 32;
+	if(!allocBgVram(screen, 0x800, tileSize, &mapBase, &tileBase))
+	{
+		return false;
+	}
+
+	fontArea_t* area = &fontAreas[screen];
+	area->id = (screen <= 0) ? bgInitSub(layer, BgType_Text4bpp, BgSize_T_256x256, mapBase, tileBase)
+			: bgInit(layer, BgType_Text4bpp, BgSize_T_256x256, mapBase, tileBase);
+	area->x = x;
+	area->y = y;
+	area->width = width;
+	area->height = height;
+	area->mapBase = mapBase;
+	area->tileBase = tileBase;
+	area->tileSize = tileSize;
+	area->tiles = (u32*)bgGetGfxPtr(area->id);
+
+	dmaFillWords(0, area->tiles, tileSize);
+
+	u16* map = bgGetMapPtr(area->id);
+	for(i = 0;i < 32 * 32;i += 1)
+	{
+		map[i] = FONT_PALETTE_BANK << 12;
+	}
+	for(j = 0;j < height;j += 1)
+	{
+		for(i = 0;i < width;i += 1)
+		{
+			map[(y + j) * 32 + x + i] = (1 + j * width + i) | (FONT_PALETTE_BANK << 12);
+		}
+	}
+
+	area->active = true;
+	setFontAreaColor(screen, RGB15(31, 31, 31));
+	bgSetPriority(area->id, layer);
+	bgShow(area->id);
+
+	return true;
+}
+
+/*
+ * Deletes the text area on the chosen screen.
+ * @param screen The screen to delete the area on.
+ */
+void deleteFontArea(int screen)
+{
+	screen = (screen <= 0) ? 0 : 1;
+	fontArea_t* area = &fontAreas[screen];
+
+	if(!area->active)
+	{
+		return;
+	}
+
+	bgHide(area->id);
+	freeBgVram(screen, area->mapBase, 0x800, area->tileBase, area->tileSize);
+	area->active = false;
+}
+
+/*
+ * Sets the color of the text in the text area.
+ * @param screen The screen of the area.
+ * @param color The color of the text.
+ */
+void setFontAreaColor(int screen, u16 color)
+{
+	u16* palette = (screen <= 0) ? BG_PALETTE_SUB : BG_PALETTE;
+
+	palette[FONT_PALETTE_BANK * 16 + 1] = color;
+}
+
+/*
+ * Clears part of the text area.
+ * @param screen The screen of the area.
+ * @param x The x position to clear (in pixels).
+ * @param y The y position to clear (in pixels).
+ * @param width The width to clear (in pixels).
+ * @param height The height to clear (in pixels).
+ */
+void clearFontRect(int screen, int x, int y, int width, int height)
+{
+	fontArea_t* area = &fontAreas[(screen <= 0) ? 0 : 1];
+	u8 bits[FONT_ROW_BYTES];
+	int r = 0;
+
+	if(!area->active || width <= 0 || height <= 0)
+	{
+		return;
+	}
+	if(width > FONT_MAX_STRING_WIDTH)
+	{
+		width = FONT_MAX_STRING_WIDTH;
+	}
+
+	/*
+	 * Builds a row with the desired width of pixels set, which is then
+	 * written with the background's color.
+	 */
+	int byteCount = (width + 7) / 8;
+	memset(bits, 0xFF, byteCount);
+	if(width & 7)
+	{
+		bits[byteCount - 1] = BIT(width & 7) - 1;
+	}
+
+	for(r = 0;r < height;r += 1)
+	{
+		blitFontRow(area, x, y + r, bits, byteCount, 0);
+	}
+}
+
+/*
+ * Clears the whole text area.
+ * @param screen The screen of the area.
+ */
+void clearFontArea(int screen)
+{
+	fontArea_t* area = &fontAreas[(screen <= 0) ? 0 : 1];
+
+	if(area->active)
+	{
+		dmaFillWords(0, area->tiles, area->tileSize);
+	}
+}
+
+/*
+ * Draws a string into the text area.
+ * @param screen The screen of the area.
+ * @param font The font to draw with.
+ * @param x The x position of the string in the area (in pixels).
+ * @param y The y position of the string in the area (in pixels).
+ * @param text The string to draw.
+ * @return Returns the width of the string in pixels.
+ */
+int drawFontString(int screen, const font_t* font, int x, int y, const char* text)
+{
+	fontArea_t* area = &fontAreas[(screen <= 0) ? 0 : 1];
+	int r = 0;
+
+	if(!area->active)
+	{
+		return 0;
+	}
+
+	fontCacheEntry_t* entry = getRenderedString(font, text);
+	int byteCount = (entry->width + 7) / 8;
+
+	for(r = 0;r < FONT_GLYPH_HEIGHT;r += 1)
+	{
+		blitFontRow(area, x, y + r, entry->rows[r], byteCount, FONT_TEXT_PIXELS);
+	}
+
+	return entry->width;
+}
+
+/*
+ * Empties the rendered string cache.  Called when a font changes.
+ */
+void clearFontCache()
+{
+	int i = 0;
+
+	for(i = 0;i < FONT_CACHE_SIZE;i += 1)
+	{
+		fontCache[i].used = false;
+	}
+}
@@ -4,6 +4,8 @@
  * Created by: Gerald McAlister
  */
 #include "videoFunctions.h"
+#include "framePipeline.h"
+#include "taskScheduler.h"
 
 /*
 *  A boolean value that represents whether the screens
@@ -14,35 +16,42 @@ bool screensFlipped = false;
 /*
 *  Initializes the video for the Nintendo DS.
 *  Sets up the screens to use backgrounds and sprites with the
-*  2D engine.
+*  2D engine, using the default VRAM layout.
 */
 void initVideo()
 {
+	initVideoLayout(&defaultVramLayout);
+}
+
+/*
+*  Initializes the video for the Nintendo DS with the desired VRAM layout.
+*  Sets up the screens to use backgrounds and sprites with the
+*  2D engine.
+*  @param layout The layout of the VRAM banks.
+*  @return Returns true if the layout was used, false if it was not valid
+*  and the default layout was used instead.
+*/
+bool initVideoLayout(const vramLayout_t* layout)
+{
+	bool valid = true;
+
 	/*
-	*  Sets the video mode for the main screen to 2D mode, and sets up the vram for bgs and sprites
+	*  Sets the video mode for both screens to 2D mode.
 	*/
 	videoSetMode(MODE_0_2D);
-	//VRAM Bank A is setup for use by the main screen's background system.
-	vramSetBankA(VRAM_A_MAIN_BG);
-	//VRAM Bank B is setup for use by the main screen's sprite system.
-	vramSetBankB(VRAM_B_MAIN_SPRITE);
-	//VRAM Bank E is setup for use by the main screen's extended background palette system.
-	vramSetBankE(VRAM_E_BG_EXT_PALETTE);
-	//VRAM Bank G is setup for use by the main screen's extended sprite palette system.
-	vramSetBankG(VRAM_G_SPRITE_EXT_PALETTE);
+	videoSetModeSub(MODE_0_2D);
 
 	/*
-	*  Sets the video mode for the sub screen to 2D mode, and sets up the vram for bgs and sprites
+	*  Sets up the vram for bgs, sprites and extended palettes.  By default:
+	*  A - Main BG, B - Main sprites, C - Sub BG, D - Sub sprites,
+	*  E - Main BG extended palettes, G - Main sprite extended palettes,
+	*  H - Sub BG extended palettes, I - Sub sprite extended palettes.
 	*/
-	videoSetModeSub(MODE_0_2D);
-	//VRAM Bank C is setup for use by the sub screen's background system.
-	vramSetBankC(VRAM_C_SUB_BG);
-	//VRAM Bank D is setup for use by the sub screen's sprite system.
-	vramSetBankD(VRAM_D_SUB_SPRITE);
-	//VRAM Bank H is setup for use by the sub screen's extended background palette system.
-	vramSetBankH(VRAM_H_SUB_BG_EXT_PALETTE);
-	//VRAM Bank I is setup for use by the sub screen's extended sprite palette system.
-	vramSetBankI(VRAM_I_SUB_SPRITE_EXT_PALETTE);
+	if(!applyVramLayout(layout))
+	{
+		applyVramLayout(&defaultVramLayout);
+		valid = false;
+	}
 
 	/*
 	*  Initializes the register controls to use extended palettes for bgs
@@ -57,6 +66,13 @@ void initVideo()
 	*/
 	oamInit(&oamMain, SpriteMapping_1D_256, true);
 	oamInit(&oamSub, SpriteMapping_1D_256, true);
+
+	/*
+	*  Sets up the vertical blank interrupt that commits each frame.
+	*/
+	initFramePipeline();
+
+	return valid;
 }
 
 /*
@@ -69,3 +85,63 @@ void switchScreens()
 	screensFlipped = !screensFlipped;
 }
 
+
+/*
+*  The task for a brightness fade.  Its vars are the screens, the current
+*  brightness, the end brightness and the speed.
+*  @param task The fade's task.
+*  @return Returns true while the fade is running.
+*/
+static bool brightnessFadeTask(task_t* task)
+{
+	TASK_BEGIN(task);
+
+	while(task->vars[1] != task->vars[2])
+	{
+		setBrightness(task->vars[0], task->vars[1]);
+		TASK_YIELD(task);
+
+		/*
+		*  Moves towards the end brightness without going past it.
+		*/
+		if(task->vars[1] < task->vars[2])
+		{
+			task->vars[1] = (task->vars[1] + task->vars[3] > task->vars[2]) ? task->vars[2] : task->vars[1] + task->vars[3];
+		}
+		else
+		{
+			task->vars[1] = (task->vars[1] - task->vars[3] < task->vars[2]) ? task->vars[2] : task->vars[1] - task->vars[3];
+		}
+	}
+	setBrightness(task->vars[0], task->vars[2]);
+
+	TASK_END(task);
+}
+
+/*
+*  Starts a task that fades the screens' brightness, one step per frame.
+*  @param screen The screens to fade (1 - main, 2 - sub, 3 - both).
+*  @param from The brightness to start at (-16 is black, 16 is white).
+*  @param to The brightness to end at.
+*  @param speed The amount the brightness changes each frame.
+*  @return Returns the ID of the fade's task, or -1 if it couldn't be
+*  started (in which case the brightness is set to the end value).
+*/
+int startBrightnessFade(int screen, int from, int to, int speed)
+{
+	int id = startTask(brightnessFadeTask, NULL);
+	task_t* task = getTask(id);
+
+	if(task == NULL)
+	{
+		setBrightness(screen, to);
+		return -1;
+	}
+
+	task->vars[0] = screen;
+	task->vars[1] = from;
+	task->vars[2] = to;
+	task->vars[3] = (speed < 0) ? -speed : (speed == 0) ? 1 : speed;
+
+	return id;
+}
@@ -0,0 +1,627 @@
+/*
+ * Contains a planner for the Nintendo DS's VRAM banks.  The banks are set up
+ * from a layout that says what each bank is used for, and background map and
+ * tile memory is then handed out from the banks without overlapping.  The
+ * amount of memory used in each bank can be checked at any time.
+ */
+#include "vramPlanner.h"
+
+/*
+ * The number of blocks in one tile base (16KB).
+ */
+#define VRAM_TILE_BASE_BLOCKS 8
+
+/*
+ * The number of map bases (maps must be within the first 64KB).
+ */
+#define VRAM_MAP_BASES 32
+
+/*
+ * The number of tile bases.
+ */
+#define VRAM_TILE_BASES 16
+
+/*
+ * The layout used by initVideo.
+ */
+const vramLayout_t defaultVramLayout =
+{
+	{
+		VRAM_USE_MAIN_BG,					// A
+		VRAM_USE_MAIN_SPRITE,				// B
+		VRAM_USE_SUB_BG,					// C
+		VRAM_USE_SUB_SPRITE,				// D
+		VRAM_USE_MAIN_BG_EXT_PALETTE,		// E
+		VRAM_USE_NONE,						// F
+		VRAM_USE_MAIN_SPRITE_EXT_PALETTE,	// G
+		VRAM_USE_SUB_BG_EXT_PALETTE,		// H
+		VRAM_USE_SUB_SPRITE_EXT_PALETTE		// I
+	}
+};
+
+/*
+ * The size of each bank.
+ */
+const u32 vramBankSizes[VRAM_BANK_COUNT] = {0x20000, 0x20000, 0x20000, 0x20000,
+		0x10000, 0x4000, 0x4000, 0x8000, 0x4000};
+
+/*
+ * Where each bank is when it is mapped to the LCD.
+ */
+const u32 vramBankLcdAddresses[VRAM_BANK_COUNT] = {0x06800000, 0x06820000,
+		0x06840000, 0x06860000, 0x06880000, 0x06890000, 0x06894000, 0x06898000,
+		0x068A0000};
+
+/*
+ * The control register of each bank.
+ */
+vu8* const vramBankControls[VRAM_BANK_COUNT] = {&VRAM_A_CR, &VRAM_B_CR,
+		&VRAM_C_CR, &VRAM_D_CR, &VRAM_E_CR, &VRAM_F_CR, &VRAM_G_CR, &VRAM_H_CR,
+		&VRAM_I_CR};
+
+/*
+ * The layout currently in use.
+ */
+vramLayout_t vramLayout;
+
+/*
+ * The mode written to each bank's control register for its use.
+ */
+u8 vramBankModes[VRAM_BANK_COUNT];
+
+/*
+ * The amount of bytes used in each bank.
+ */
+u32 vramBankUsed[VRAM_BANK_COUNT];
+
+/*
+ * The bank that backs each background block on each screen, or -1 if the
+ * block is not mapped to any bank.
+ */
+s8 bgVramBlockBanks[2][VRAM_BG_BLOCKS];
+
+/*
+ * Whether each background block on each screen has been handed out.
+ */
+bool bgVramBlocksUsed[2][VRAM_BG_BLOCKS];
+
+/*
+ * The amount of background memory on each screen.
+ */
+u32 bgVramSizes[2];
+
+/*
+ * The amount of background memory used on each screen.
+ */
+u32 bgVramUsed[2];
+
+/*
+ * The first sprite bank of each screen, or -1 if there is none.
+ */
+int spriteVramBanks[2];
+
+/*
+ * The extended background palette bank of each screen, or -1 if there is none.
+ */
+int bgExtPaletteBanks[2];
+
+/*
+ * The extended sprite palette bank of each screen, or -1 if there is none.
+ */
+int spriteExtPaletteBanks[2];
+
+/*
+ * The extended palette slots that have been written on each screen.
+ */
+u32 bgExtPaletteSlots[2];
+u32 spriteExtPaletteSlots[2];
+
+/*
+ * Gets the mode for a bank to be used for something.
+ * @param bank The bank to get the mode for.
+ * @param use What the bank is used for.
+ * @param mainBgSlot The number of banks already used for the main BG.
+ * @param mainSpriteSlot The number of banks already used for main sprites.
+ * @return Returns the mode for the bank, or -1 if the bank can't be used for it.
+ */
+static int getVramBankMode(vramBank_t bank, vramUse_t use, int mainBgSlot, int mainSpriteSlot)
+{
+	switch(use)
+	{
+		case VRAM_USE_NONE:
+		case VRAM_USE_LCD:
+			return 0;
+		case VRAM_USE_MAIN_BG:
+			/*
+			 * Banks A-D are placed one after another in the main BG memory.
+			 */
+			return (bank <= VRAM_BANK_D && mainBgSlot < 4) ? 1 | (mainBgSlot << 3) : -1;
+		case VRAM_USE_MAIN_SPRITE:
+			if(bank <= VRAM_BANK_B && mainSpriteSlot < 2)
+			{
+				return 2 | (mainSpriteSlot << 3);
+			}
+			return (bank == VRAM_BANK_E) ? 2 : -1;
+		case VRAM_USE_MAIN_BG_EXT_PALETTE:
+			return (bank == VRAM_BANK_E) ? 4 : -1;
+		case VRAM_USE_MAIN_SPRITE_EXT_PALETTE:
+			return (bank == VRAM_BANK_F || bank == VRAM_BANK_G) ? 5 : -1;
+		case VRAM_USE_SUB_BG:
+			if(bank == VRAM_BANK_C)
+			{
+				return 4;
+			}
+			return (bank == VRAM_BANK_H || bank == VRAM_BANK_I) ? 1 : -1;
+		case VRAM_USE_SUB_SPRITE:
+			if(bank == VRAM_BANK_D)
+			{
+				return 4;
+			}
+			return (bank == VRAM_BANK_I) ? 2 : -1;
+		case VRAM_USE_SUB_BG_EXT_PALETTE:
+			return (bank == VRAM_BANK_H) ? 2 : -1;
+		case VRAM_USE_SUB_SPRITE_EXT_PALETTE:
+			return (bank == VRAM_BANK_I) ? 3 : -1;
+	}
+	return -1;
+}
+
+/*
+ * Maps a range of background memory on a screen to a bank.
+ * @param screen The screen the memory is on (0 or 1).
+ * @param bank The bank backing the memory.
+ * @param offset The offset of the bank in the background memory.
+ */
+static void mapBgVramBank(int screen, vramBank_t bank, u32 offset)
+{
+	u32 i = 0;
+	u32 first = offset / VRAM_BLOCK_SIZE;
+	u32 count = vramBankSizes[bank] / VRAM_BLOCK_SIZE;
+
+	/*
+	 * Only the first 256KB can be reached by a background, so the
+	 * rest of the bank is left out.
+	 */
+	for(i = first;i < first + count && i < VRAM_BG_BLOCKS;i += 1)
+	{
+		bgVramBlockBanks[screen][i] = bank;
+		bgVramSizes[screen] += VRAM_BLOCK_SIZE;
+	}
+}
+
+/*
+ * Checks whether a range of background blocks can be handed out.
+ * @param screen The screen the blocks are on (0 or 1).
+ * @param first The first block.
+ * @param count The number of blocks.
+ * @return Returns true if all of the blocks are mapped and free.
+ */
+static bool bgVramBlocksFree(int screen, int first, int count)
+{
+	int i = 0;
+
+	if(first + count > VRAM_BG_BLOCKS)
+	{
+		return false;
+	}
+
+	for(i = first;i < first + count;i += 1)
+	{
+		if(bgVramBlockBanks[screen][i] < 0 || bgVramBlocksUsed[screen][i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Marks a range of background blocks as used or free, and updates
+ * the usage of the banks behind them.
+ * @param screen The screen the blocks are on (0 or 1).
+ * @param first The first block.
+ * @param count The number of blocks.
+ * @param used Whether the blocks are now used.
+ */
+static void markBgVramBlocks(int screen, int first, int count, bool used)
+{
+	int i = 0;
+
+	for(i = first;i < first + count && i < VRAM_BG_BLOCKS;i += 1)
+	{
+		if(bgVramBlockBanks[screen][i] < 0 || bgVramBlocksUsed[screen][i] == used)
+		{
+			continue;
+		}
+		bgVramBlocksUsed[screen][i] = used;
+		if(used)
+		{
+			vramBankUsed[(int)bgVramBlockBanks[screen][i]] += VRAM_BLOCK_SIZE;
+			bgVramUsed[screen] += VRAM_BLOCK_SIZE;
+		}
+		else
+		{
+			vramBankUsed[(int)bgVramBlockBanks[screen][i]] -= VRAM_BLOCK_SIZE;
+			bgVramUsed[screen] -= VRAM_BLOCK_SIZE;
+		}
+	}
+}
+
+/*
+ * Sets up the VRAM banks with the desired layout.  All of the background
+ * memory that was handed out is forgotten.
+ * @param layout The layout to use.
+ * @return Returns true if the layout was applied, false if it is not valid
+ * (IE: a bank was given a use it doesn't support, or two banks overlap).
+ */
+bool applyVramLayout(const vramLayout_t* layout)
+{
+	u8 modes[VRAM_BANK_COUNT];
+	int useCounts[VRAM_USE_SUB_SPRITE_EXT_PALETTE + 1];
+	int mainBgSlot = 0;
+	int mainSpriteSlot = 0;
+	int i = 0;
+
+	memset(useCounts, 0, sizeof(useCounts));
+
+	/*
+	 * Works out the mode of every bank first, so that nothing is changed
+	 * if the layout turns out to be invalid.
+	 */
+	for(i = 0;i < VRAM_BANK_COUNT;i += 1)
+	{
+		vramUse_t use = layout->banks[i];
+		int mode = getVramBankMode(i, use, mainBgSlot, mainSpriteSlot);
+		if(mode < 0)
+		{
+			return false;
+		}
+		modes[i] = mode;
+		useCounts[use] += 1;
+
+		if(use == VRAM_USE_MAIN_BG)
+		{
+			mainBgSlot += 1;
+		}
+		else if(use == VRAM_USE_MAIN_SPRITE)
+		{
+			mainSpriteSlot += 1;
+		}
+	}
+
+	/*
+	 * Makes sure that none of the banks overlap.  Bank E always sits at the
+	 * start of the main sprite memory, bank C covers banks H and I in the sub
+	 * BG memory, and banks D and I share the sub sprite memory.
+	 */
+	if((layout->banks[VRAM_BANK_E] == VRAM_USE_MAIN_SPRITE && useCounts[VRAM_USE_MAIN_SPRITE] > 1)
+			|| (layout->banks[VRAM_BANK_C] == VRAM_USE_SUB_BG && useCounts[VRAM_USE_SUB_BG] > 1)
+			|| useCounts[VRAM_USE_SUB_SPRITE] > 1
+			|| useCounts[VRAM_USE_MAIN_SPRITE_EXT_PALETTE] > 1)
+	{
+		return false;
+	}
+
+	/*
+	 * The layout is valid, so the banks are set up.
+	 */
+	memcpy(&vramLayout, layout, sizeof(vramLayout_t));
+	memcpy(vramBankModes, modes, sizeof(vramBankModes));
+	memset(vramBankUsed, 0, sizeof(vramBankUsed));
+	memset(bgVramBlockBanks, -1, sizeof(bgVramBlockBanks));
+	memset(bgVramBlocksUsed, 0, sizeof(bgVramBlocksUsed));
+	memset(bgVramSizes, 0, sizeof(bgVramSizes));
+	memset(bgVramUsed, 0, sizeof(bgVramUsed));
+	bgExtPaletteSlots[0] = bgExtPaletteSlots[1] = 0;
+	spriteExtPaletteSlots[0] = spriteExtPaletteSlots[1] = 0;
+	spriteVramBanks[0] = spriteVramBanks[1] = -1;
+	bgExtPaletteBanks[0] = bgExtPaletteBanks[1] = -1;
+	spriteExtPaletteBanks[0] = spriteExtPaletteBanks[1] = -1;
+
+	mainBgSlot = 0;
+	for(i = 0;i < VRAM_BANK_COUNT;i += 1)
+	{
+		*vramBankControls[i] = (layout->banks[i] == VRAM_USE_NONE) ? 0 : VRAM_ENABLE | modes[i];
+
+		switch(layout->banks[i])
+		{
+			case VRAM_USE_MAIN_BG:
+				mapBgVramBank(1, i, mainBgSlot * 0x20000);
+				mainBgSlot += 1;
+				break;
+			case VRAM_USE_SUB_BG:
+				mapBgVramBank(0, i, (i == VRAM_BANK_I) ? 0x8000 : 0);
+				break;
+			case VRAM_USE_MAIN_SPRITE:
+				if(spriteVramBanks[1] < 0)
+				{
+					spriteVramBanks[1] = i;
+				}
+				break;
+			case VRAM_USE_SUB_SPRITE:
+				spriteVramBanks[0] = i;
+				break;
+			case VRAM_USE_MAIN_BG_EXT_PALETTE:
+				bgExtPaletteBanks[1] = i;
+				break;
+			case VRAM_USE_SUB_BG_EXT_PALETTE:
+				bgExtPaletteBanks[0] = i;
+				break;
+			case VRAM_USE_MAIN_SPRITE_EXT_PALETTE:
+				spriteExtPaletteBanks[1] = i;
+				break;
+			case VRAM_USE_SUB_SPRITE_EXT_PALETTE:
+				spriteExtPaletteBanks[0] = i;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Gets the layout that is currently in use.
+ * @return Returns the current layout.
+ */
+const vramLayout_t* getVramLayout()
+{
+	return &vramLayout;
+}
+
+/*
+ * Hands out memory for a background's map and tiles.
+ * @param screen The screen the background is on.
+ * @param mapSize The size of the map in bytes.
+ * @param tileSize The size of the tiles in bytes.
+ * @param mapBase Set to the map base to use.
+ * @param tileBase Set to the tile base to use.
+ * @return Returns true if there was enough room, false otherwise.
+ */
+bool allocBgVram(int screen, u32 mapSize, u32 tileSize, int* mapBase, int* tileBase)
+{
+	int mapBlocks = (mapSize + VRAM_BLOCK_SIZE - 1) / VRAM_BLOCK_SIZE;
+	int tileBlocks = (tileSize + VRAM_BLOCK_SIZE - 1) / VRAM_BLOCK_SIZE;
+	int t = 0;
+	int m = 0;
+
+	screen = (screen <= 0) ? 0 : 1;
+
+	/*
+	 * Tiles are handed out from the top of the memory down, since maps can
+	 * only be placed in the first 64KB and need to be kept room for.
+	 */
+	for(t = VRAM_TILE_BASES - 1;t >= 0;t -= 1)
+	{
+		if(bgVramBlocksFree(screen, t * VRAM_TILE_BASE_BLOCKS, tileBlocks))
+		{
+			break;
+		}
+	}
+	if(t < 0)
+	{
+		return false;
+	}
+	markBgVramBlocks(screen, t * VRAM_TILE_BASE_BLOCKS, tileBlocks, true);
+
+	/*
+	 * Maps are handed out from the bottom up.
+	 */
+	for(m = 0;m < VRAM_MAP_BASES;m += 1)
+	{
+		if(bgVramBlocksFree(screen, m, mapBlocks))
+		{
+			break;
+		}
+	}
+	if(m >= VRAM_MAP_BASES)
+	{
+		markBgVramBlocks(screen, t * VRAM_TILE_BASE_BLOCKS, tileBlocks, false);
+		return false;
+	}
+	markBgVramBlocks(screen, m, mapBlocks, true);
+
+	*mapBase = m;
+	*tileBase = t;
+	return true;
+}
+
+/*
+ * Gives back memory handed out by allocBgVram.
+ * @param screen The screen the background is on.
+ * @param mapBase The map base that was handed out.
+ * @param mapSize The size of the map in bytes.
+ * @param tileBase The tile base that was handed out.
+ * @param tileSize The size of the tiles in bytes.
+ */
+void freeBgVram(int screen, int mapBase, u32 mapSize, int tileBase, u32 tileSize)
+{
+	screen = (screen <= 0) ? 0 : 1;
+
+	markBgVramBlocks(screen, mapBase, (mapSize + VRAM_BLOCK_SIZE - 1) / VRAM_BLOCK_SIZE, false);
+	markBgVramBlocks(screen, tileBase * VRAM_TILE_BASE_BLOCKS,
+			(tileSize + VRAM_BLOCK_SIZE - 1) / VRAM_BLOCK_SIZE, false);
+}
+
+/*
+ * Keeps track of sprite graphics memory allocated on a screen.
+ * @param screen The screen the sprite graphics are on.
+ * @param size The amount of bytes allocated (negative when freed).
+ */
+void trackSpriteVram(int screen, s32 size)
+{
+	int bank = spriteVramBanks[(screen <= 0) ? 0 : 1];
+
+	if(bank < 0)
+	{
+		return;
+	}
+
+	if(size < 0 && (u32)(-size) > vramBankUsed[bank])
+	{
+		vramBankUsed[bank] = 0;
+	}
+	else
+	{
+		vramBankUsed[bank] += size;
+	}
+}
+
+/*
+ * Gets the size of a VRAM bank.
+ * @param bank The bank to get the size of.
+ * @return Returns the size of the bank in bytes.
+ */
+u32 getVramBankSize(vramBank_t bank)
+{
+	return vramBankSizes[bank];
+}
+
+/*
+ * Gets the amount of memory used in a VRAM bank.
+ * @param bank The bank to check.
+ * @return Returns the amount of bytes used.
+ */
+u32 getVramBankUsed(vramBank_t bank)
+{
+	return vramBankUsed[bank];
+}
+
+/*
+ * Gets the amount of background memory available on a screen.
+ * @param screen The screen to check.
+ * @return Returns the size in bytes that backgrounds can use.
+ */
+u32 getBgVramSize(int screen)
+{
+	return bgVramSizes[(screen <= 0) ? 0 : 1];
+}
+
+/*
+ * Gets the amount of background memory used on a screen.
+ * @param screen The screen to check.
+ * @return Returns the amount of bytes used by backgrounds.
+ */
+u32 getBgVramUsed(int screen)
+{
+	return bgVramUsed[(screen <= 0) ? 0 : 1];
+}
+
+/*
+ * Maps the desired screen's extended background palette bank to the LCD
+ * so that it can be written to.
+ * @param screen The screen to write the palettes of.
+ */
+void beginBgExtPaletteWrite(int screen)
+{
+	int bank = bgExtPaletteBanks[(screen <= 0) ? 0 : 1];
+
+	if(bank >= 0)
+	{
+		*vramBankControls[bank] = VRAM_ENABLE;
+	}
+}
+
+/*
+ * Maps the desired screen's extended background palette bank back to its use.
+ * @param screen The screen the palettes were written for.
+ */
+void endBgExtPaletteWrite(int screen)
+{
+	int bank = bgExtPaletteBanks[(screen <= 0) ? 0 : 1];
+
+	if(bank >= 0)
+	{
+		*vramBankControls[bank] = VRAM_ENABLE | vramBankModes[bank];
+	}
+}
+
+/*
+ * Gets where an extended background palette slot is while its bank is
+ * mapped to the LCD.  Only valid between beginBgExtPaletteWrite and
+ * endBgExtPaletteWrite.
+ * @param screen The screen to get the palette for.
+ * @param slot The slot of the palette (the background layer).
+ * @return Returns a pointer to the palette, or NULL if the screen has none.
+ */
+u16* getBgExtPalette(int screen, int slot)
+{
+	screen = (screen <= 0) ? 0 : 1;
+	int bank = bgExtPaletteBanks[screen];
+
+	if(bank < 0 || slot < 0 || slot > 3)
+	{
+		return NULL;
+	}
+
+	/*
+	 * Keeps track of which slots are in use.
+	 */
+	if(!(bgExtPaletteSlots[screen] & BIT(slot)))
+	{
+		bgExtPaletteSlots[screen] |= BIT(slot);
+		vramBankUsed[bank] += VRAM_BG_EXT_PALETTE_SIZE;
+	}
+
+	return (u16*)(vramBankLcdAddresses[bank] + slot * VRAM_BG_EXT_PALETTE_SIZE);
+}
+
+/*
+ * Maps the desired screen's extended sprite palette bank to the LCD
+ * so that it can be written to.
+ * @param screen The screen to write the palettes of.
+ */
+void beginSpriteExtPaletteWrite(int screen)
+{
+	int bank = spriteExtPaletteBanks[(screen <= 0) ? 0 : 1];
+
+	if(bank >= 0)
+	{
+		*vramBankControls[bank] = VRAM_ENABLE;
+	}
+}
+
+/*
+ * Maps the desired screen's extended sprite palette bank back to its use.
+ * @param screen The screen the palettes were written for.
+ */
+void endSpriteExtPaletteWrite(int screen)
+{
+	int bank = spriteExtPaletteBanks[(screen <= 0) ? 0 : 1];
+
+	if(bank >= 0)
+	{
+		*vramBankControls[bank] = VRAM_ENABLE | vramBankModes[bank];
+	}
+}
+
+/*
+ * Gets where an extended sprite palette slot is while its bank is
+ * mapped to the LCD.  Only valid between beginSpriteExtPaletteWrite and
+ * endSpriteExtPaletteWrite.
+ * @param screen The screen to get the palette for.
+ * @param slot The slot of the palette.
+ * @return Returns a pointer to the palette, or NULL if the screen has none.
+ */
+u16* getSpriteExtPalette(int screen, int slot)
+{
+	screen = (screen <= 0) ? 0 : 1;
+	int bank = spriteExtPaletteBanks[screen];
+
+	if(bank < 0 || slot < 0 || slot > 15)
+	{
+		return NULL;
+	}
+
+	/*
+	 * Keeps track of which slots are in use.
+	 */
+	if(!(spriteExtPaletteSlots[screen] & BIT(slot)))
+	{
+		spriteExtPaletteSlots[screen] |= BIT(slot);
+		vramBankUsed[bank] += VRAM_SPRITE_EXT_PALETTE_SIZE;
+	}
+
+	return (u16*)(vramBankLcdAddresses[bank] + slot * VRAM_SPRITE_EXT_PALETTE_SIZE);
+}
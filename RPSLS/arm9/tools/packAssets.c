@@ -0,0 +1,268 @@
+/*
+ * A tool run on the computer while building, which packs the graphics grit
+ * made into one asset pack for NitroFS.  The pack starts with a hashed table
+ * of contents, so the game can find any asset with a single lookup, followed
+ * by each file's data aligned to ASSET_PACK_ALIGN bytes.
+ *
+ * Usage: packAssets <output.pak> <input directory>
+ *
+ * Every .bin file in the input directory is packed under its file name
+ * (IE: "rock.img.bin").  The layout and hash must match assets.h/assets.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <dirent.h>
+
+/*
+ * The magic number at the start of a pack ("GPAK") and its version.
+ */
+#define ASSET_PACK_MAGIC 0x4B415047
+#define ASSET_PACK_VERSION 1
+
+/*
+ * The alignment of each file's data in the pack.
+ */
+#define ASSET_PACK_ALIGN 32
+
+/*
+ * The max amount of files in a pack.
+ */
+#define MAX_PACK_FILES 1024
+
+/*
+ * A file being packed.
+ */
+typedef struct packFile_t
+{
+	char name[256];
+	uint32_t hash;
+	uint32_t offset;
+	uint32_t size;
+} packFile_t;
+
+packFile_t packFiles[MAX_PACK_FILES];
+int packFileCount = 0;
+
+/*
+ * Works out the FNV-1a hash of an asset's name.
+ * @param name The name of the asset's file.
+ * @return Returns the hash (never 0, which marks an empty slot).
+ */
+static uint32_t hashAssetName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+
+	while(*name != '\0')
+	{
+		hash = (hash ^ (uint8_t)*name) * 16777619u;
+		name += 1;
+	}
+
+	return (hash == 0) ? 1 : hash;
+}
+
+/*
+ * Writes a 16 bit value to the pack in little endian order.
+ * @param file The pack.
+ * @param value The value to write.
+ */
+static void writeU16(FILE* file, uint16_t value)
+{
+	fputc(value & 0xFF, file);
+	fputc(value >> 8, file);
+}
+
+/*
+ * Writes a 32 bit value to the pack in little endian order.
+ * @param file The pack.
+ * @param value The value to write.
+ */
+static void writeU32(FILE* file, uint32_t value)
+{
+	writeU16(file, value & 0xFFFF);
+	writeU16(file, value >> 16);
+}
+
+/*
+ * Opens one of the files being packed.
+ * @param directory The input directory.
+ * @param name The name of the file.
+ * @return Returns the opened file, or NULL if it couldn't be opened.
+ */
+static FILE* openPackFile(const char* directory, const char* name)
+{
+	char path[1024];
+
+	if(snprintf(path, sizeof(path), "%s/%s", directory, name) >= (int)sizeof(path))
+	{
+		return NULL;
+	}
+
+	FILE* file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "packAssets: could not open %s\n", path);
+	}
+	return file;
+}
+
+/*
+ * Sorts the files by name, so the pack is the same every build.
+ */
+static int compareFiles(const void* a, const void* b)
+{
+	return strcmp(((const packFile_t*)a)->name, ((const packFile_t*)b)->name);
+}
+
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <output.pak> <input directory>\n", argv[0]);
+		return 1;
+	}
+
+	/*
+	 * Finds every .bin file in the input directory.
+	 */
+	DIR* directory = opendir(argv[2]);
+	if(directory == NULL)
+	{
+		fprintf(stderr, "packAssets: could not open %s\n", argv[2]);
+		return 1;
+	}
+
+	struct dirent* entry;
+	while((entry = readdir(directory)) != NULL)
+	{
+		size_t length = strlen(entry->d_name);
+		if(length < 5 || length >= sizeof(packFiles[0].name) || strcmp(entry->d_name + length - 4, ".bin") != 0)
+		{
+			continue;
+		}
+		if(packFileCount >= MAX_PACK_FILES)
+		{
+			fprintf(stderr, "packAssets: too many files\n");
+			return 1;
+		}
+
+		strcpy(packFiles[packFileCount].name, entry->d_name);
+		packFiles[packFileCount].hash = hashAssetName(entry->d_name);
+		packFileCount += 1;
+	}
+	closedir(directory);
+
+	qsort(packFiles, packFileCount, sizeof(packFile_t), compareFiles);
+
+	/*
+	 * The table has at least twice as many slots as files, and a power
+	 * of two so the game can wrap around it with a mask.
+	 */
+	uint32_t slotCount = 1;
+	while(slotCount < (uint32_t)packFileCount * 2)
+	{
+		slotCount <<= 1;
+	}
+
+	int* slots = (int*)malloc(slotCount * sizeof(int));
+	for(uint32_t i = 0; i < slotCount; i += 1)
+	{
+		slots[i] = -1;
+	}
+
+	/*
+	 * Each file goes in the first free slot from its hash.  Only the hash
+	 * is stored, so two names with the same hash can't both be packed.
+	 */
+	for(int i = 0; i < packFileCount; i += 1)
+	{
+		uint32_t slot = packFiles[i].hash & (slotCount - 1);
+		while(slots[slot] >= 0)
+		{
+			if(packFiles[slots[slot]].hash == packFiles[i].hash)
+			{
+				fprintf(stderr, "packAssets: %s and %s have the same hash, please rename one\n",
+						packFiles[slots[slot]].name, packFiles[i].name);
+				return 1;
+			}
+			slot = (slot + 1) & (slotCount - 1);
+		}
+		slots[slot] = i;
+	}
+
+	/*
+	 * Works out where each file's data goes.
+	 */
+	uint32_t offset = 16 + slotCount * 12;
+	for(int i = 0; i < packFileCount; i += 1)
+	{
+		FILE* input = openPackFile(argv[2], packFiles[i].name);
+		if(input == NULL)
+		{
+			return 1;
+		}
+		fseek(input, 0, SEEK_END);
+		packFiles[i].size = ftell(input);
+		fclose(input);
+
+		offset = (offset + ASSET_PACK_ALIGN - 1) & ~(ASSET_PACK_ALIGN - 1);
+		packFiles[i].offset = offset;
+		offset += packFiles[i].size;
+	}
+
+	FILE* output = fopen(argv[1], "wb");
+	if(output == NULL)
+	{
+		fprintf(stderr, "packAssets: could not create %s\n", argv[1]);
+		return 1;
+	}
+
+	/*
+	 * The header, then the table of contents.
+	 */
+	writeU32(output, ASSET_PACK_MAGIC);
+	writeU16(output, ASSET_PACK_VERSION);
+	writeU16(output, 0);
+	writeU32(output, slotCount);
+	writeU32(output, packFileCount);
+
+	for(uint32_t i = 0; i < slotCount; i += 1)
+	{
+		packFile_t* file = (slots[i] >= 0) ? &packFiles[slots[i]] : NULL;
+		writeU32(output, (file != NULL) ? file->hash : 0);
+		writeU32(output, (file != NULL) ? file->offset : 0);
+		writeU32(output, (file != NULL) ? file->size : 0);
+	}
+
+	/*
+	 * Then each file's data, padded up to its offset.
+	 */
+	for(int i = 0; i < packFileCount; i += 1)
+	{
+		while((uint32_t)ftell(output) < packFiles[i].offset)
+		{
+			fputc(0, output);
+		}
+
+		FILE* input = openPackFile(argv[2], packFiles[i].name);
+		char buffer[4096];
+		size_t read;
+		if(input == NULL)
+		{
+			return 1;
+		}
+		while((read = fread(buffer, 1, sizeof(buffer), input)) > 0)
+		{
+			fwrite(buffer, 1, read, output);
+		}
+		fclose(input);
+	}
+
+	fclose(output);
+	free(slots);
+
+	printf("packAssets: packed %d files into %s\n", packFileCount, argv[1]);
+	return 0;
+}